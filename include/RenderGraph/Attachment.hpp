@@ -76,6 +76,7 @@ namespace crg
 			StencilInput = 0x01 << 6,
 			StencilOutput = 0x01 << 7,
 			Transition = 0x01 << 8,
+			SamePixel = 0x01 << 9,
 			DepthStencil = Depth | Stencil,
 			StencilInOut = StencilInput | StencilOutput,
 		};
@@ -113,6 +114,11 @@ namespace crg
 			return hasFlag( Flag::Sampled );
 		}
 
+		bool isSamePixelView()const
+		{
+			return hasFlag( Flag::SamePixel );
+		}
+
 		bool isStorageView()const
 		{
 			return hasFlag( Flag::Storage );
@@ -292,7 +298,7 @@ namespace crg
 			return isTransition() && isView();
 		}
 
-		Buffer buffer{ {}, std::string{} };
+		Buffer buffer{ VkBuffer{}, std::string{} };
 		VkBufferView view{};
 		BufferSubresourceRange range{};
 
@@ -468,6 +474,11 @@ namespace crg
 			return isImage() && imageAttach.isSampledView();
 		}
 
+		bool isSamePixelView()const
+		{
+			return isImage() && imageAttach.isSamePixelView();
+		}
+
 		bool isStorageView()const
 		{
 			return isImage() && imageAttach.isStorageView();
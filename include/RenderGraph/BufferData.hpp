@@ -0,0 +1,53 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#pragma once
+
+#include "FrameGraphPrerequisites.hpp"
+
+namespace crg
+{
+	/**
+	*\brief
+	*	Basic buffer data, from which graph owned buffers will be created.
+	*/
+	struct BufferData
+	{
+		std::string name;
+		VkBufferCreateInfo info;
+		VkMemoryPropertyFlags memory;
+
+		explicit BufferData( std::string name = {}
+			, VkDeviceSize size = {}
+			, VkBufferUsageFlags usage = {}
+			, VkMemoryPropertyFlags memory = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+			, VkBufferCreateFlags flags = {} )
+			: name{ std::move( name ) }
+			, info{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO
+				, nullptr
+				, flags
+				, size
+				, usage
+				, VK_SHARING_MODE_EXCLUSIVE
+				, 0u
+				, nullptr }
+			, memory{ memory }
+		{
+		}
+	};
+
+	inline bool operator==( VkBufferCreateInfo const & lhs, VkBufferCreateInfo const & rhs )
+	{
+		return lhs.flags == rhs.flags
+			&& lhs.size == rhs.size
+			&& lhs.usage == rhs.usage;
+	}
+
+	inline bool operator==( BufferData const & lhs, BufferData const & rhs )
+	{
+		return lhs.name == rhs.name
+			&& lhs.info == rhs.info
+			&& lhs.memory == rhs.memory;
+	}
+}
@@ -22,6 +22,8 @@ namespace crg::dot
 		bool withIds{};
 		bool withGroups{};
 		bool splitGroups{};
+		bool withSubpassMerges{};
+		bool withLifetimes{};
 	};
 	using DisplayResult = std::map< std::string, std::stringstream, std::less<> >;
 
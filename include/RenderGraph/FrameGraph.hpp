@@ -5,6 +5,7 @@ See LICENSE file in root folder.
 #pragma once
 
 #include "Attachment.hpp"
+#include "BufferData.hpp"
 #include "FramePassGroup.hpp"
 #include "GraphNode.hpp"
 #include "ImageData.hpp"
@@ -41,6 +42,27 @@ namespace crg
 		/**@{*/
 		CRG_API ImageId createImage( ImageData const & img );
 		CRG_API ImageViewId createView( ImageViewData const & view );
+		/**
+		*\brief
+		*	Creates a graph owned buffer, usable in buffer attachments like user buffers.
+		*\remarks
+		*	The buffer is created when the graph is compiled, and destroyed with the runnable graph.
+		*	Its content only lives between its first and last use by the graph passes (or for the whole frame
+		*	when it is read before being written), since its memory is shared with the graph buffers
+		*	used at different times.
+		*/
+		CRG_API Buffer createBuffer( BufferData const & buffer );
+		/**
+		*\brief
+		*	Creates a graph owned, host visible, uniform buffer, whose content is written by \p provider before each run.
+		*\remarks
+		*	Meant for per frame parameters, such as the push constants of pre-recorded command buffers:
+		*	the passes read them from the buffer, so their values can change without recording the commands again.
+		*	The provider is called once the graph fence has been waited for, the GPU doesn't use the buffer anymore.
+		*/
+		CRG_API Buffer createFrameDataBuffer( std::string const & name
+			, VkDeviceSize size
+			, FrameDataProvider provider );
 		/**@}*/
 		/**
 		*\name
@@ -56,7 +78,18 @@ namespace crg
 		*	Compilation.
 		*/
 		/**@{*/
-		CRG_API RunnableGraphPtr compile( GraphContext & context );
+		/**
+		*\brief
+		*	Compiles the graph into a runnable graph.
+		*\param[in] context
+		*	The context used to create the GPU objects.
+		*\param[in] cullPasses
+		*	If \p true, the passes that don't contribute to the graph outputs are not compiled, unless they have side effects.
+		*	The graph outputs are the images declared through addOutput, or through any group's addGroupOutput,
+		*	and the buffers written by a pass but not read by any other pass of the graph.
+		*/
+		CRG_API RunnableGraphPtr compile( GraphContext & context
+			, bool cullPasses = false );
 		/**@}*/
 		/**
 		*\name
@@ -70,6 +103,28 @@ namespace crg
 		/**@}*/
 		/**
 		*\name
+		*	Configuration.
+		*/
+		/**@{*/
+		/**
+		*\brief
+		*	Allows the compiled graph to create its single pass render targets as transient attachments.
+		*\remarks
+		*	Only enable it when the graph images aren't accessed by other graphs or by the user,
+		*	beyond what is declared through addInput/addOutput, since their content is not kept in memory.
+		*/
+		void setTransientAttachments( bool value )noexcept
+		{
+			m_transientAttachments = value;
+		}
+
+		bool hasTransientAttachments()const noexcept
+		{
+			return m_transientAttachments;
+		}
+		/**@}*/
+		/**
+		*\name
 		*	Getters.
 		*/
 		/**@{*/
@@ -139,10 +194,13 @@ namespace crg
 		ImageViewIdAliasMap m_imageViewAliases;
 		std::set< ImageId > m_images;
 		std::set< ImageViewId > m_imageViews;
+		std::set< BufferId > m_buffers;
+		std::map< BufferId, FrameDataProvider > m_frameDataProviders;
 		std::map< std::string, ImageViewId, std::less<> > m_attachViews;
 		RecordContext m_finalState;
 		FrameGraphArray m_depends;
 		LayerLayoutStatesHandler m_inputs;
 		LayerLayoutStatesHandler m_outputs;
+		bool m_transientAttachments{};
 	};
 }
@@ -37,6 +37,7 @@ namespace crg
 	struct Attachment;
 	struct AttachmentTransitions;
 	struct Buffer;
+	struct BufferData;
 	struct FramePassTransitions;
 	struct GraphContext;
 	struct ImageData;
@@ -55,17 +56,21 @@ namespace crg
 	class FrameGraph;
 	class FramePassTimer;
 	class GraphVisitor;
+	class PipelineCache;
 	class RecordContext;
 	class ResourceHandler;
 	class ResourcesCache;
 	class RunnableGraph;
 	class RunnablePass;
+	class UploadRing;
 
 	class ImageCopy;
 	class PipelinePass;
 	class RenderPass;
+	class RenderPassHolder;
 	class RenderQuad;
 
+	using BufferId = Id< BufferData >;
 	using ImageId = Id< ImageData >;
 	using ImageViewId = Id< ImageViewData >;
 	using DependencyCache = std::unordered_map< size_t, bool >;
@@ -109,8 +114,14 @@ namespace crg
 	using AttachmentsNodeMap = std::map< ConstGraphAdjacentNode, AttachmentTransitions >;
 	using ImageMemoryMap = std::map< ImageId, std::pair< VkImage, VkDeviceMemory > >;
 	using ImageViewMap = std::map< ImageViewId, VkImageView >;
+	using BufferIdArray = std::vector< BufferId >;
 	using ImageIdArray = std::vector< ImageId >;
 	using ImageViewIdArray = std::vector< ImageViewId >;
+	/**
+	*\brief
+	*	Writes host data into a graph owned buffer mapped memory.
+	*/
+	using FrameDataProvider = std::function< void( void * data, VkDeviceSize size ) >;
 
 	template< typename DataT >
 	using IdAliasMap = std::map< Id< DataT >, Id< DataT > >;
@@ -119,6 +130,7 @@ namespace crg
 
 	template< typename DataT >
 	using IdDataOwnerCont = std::map< Id< DataT >, std::unique_ptr< DataT > >;
+	using BufferIdDataOwnerCont = IdDataOwnerCont< BufferData >;
 	using ImageIdDataOwnerCont = IdDataOwnerCont< ImageData >;
 	using ImageViewIdDataOwnerCont = IdDataOwnerCont< ImageViewData >;
 
@@ -136,6 +148,7 @@ namespace crg
 	using VkPushConstantRangeArray = std::vector< VkPushConstantRange >;
 	using VkScissorArray = std::vector< VkRect2D >;
 	using VkSubpassDependencyArray = std::vector< VkSubpassDependency >;
+	using VkSubpassDescriptionArray = std::vector< VkSubpassDescription >;
 	using VkVertexInputAttributeDescriptionArray = std::vector< VkVertexInputAttributeDescription >;
 	using VkVertexInputBindingDescriptionArray = std::vector< VkVertexInputBindingDescription >;
 	using VkViewportArray = std::vector< VkViewport >;
@@ -154,12 +167,45 @@ namespace crg
 	};
 
 	using AccessState = PipelineState;
+	/**
+	*\brief
+	*	The access state of a bytes interval of a buffer, the interval begin is the key in AccessRangeMap.
+	*/
+	struct AccessRange
+	{
+		VkDeviceSize end;
+		AccessState state;
+	};
+	/**
+	*\brief
+	*	The attachments formats of a pass rendering without VkRenderPass.
+	*/
+	struct RenderingFormats
+	{
+		std::vector< VkFormat > colour;
+		VkFormat depth{ VK_FORMAT_UNDEFINED };
+		VkFormat stencil{ VK_FORMAT_UNDEFINED };
+	};
+
+	inline bool operator==( RenderingFormats const & lhs, RenderingFormats const & rhs )
+	{
+		return lhs.colour == rhs.colour
+			&& lhs.depth == rhs.depth
+			&& lhs.stencil == rhs.stencil;
+	}
+
+	inline bool operator!=( RenderingFormats const & lhs, RenderingFormats const & rhs )
+	{
+		return !( lhs == rhs );
+	}
 
 	using MipLayoutStates = std::map< uint32_t, LayoutState >;
 	using LayerLayoutStates = std::map< uint32_t, MipLayoutStates >;
 	using LayoutStateMap = std::unordered_map< uint32_t, LayerLayoutStates >;
 	using LayerLayoutStatesMap = std::map< uint32_t, LayerLayoutStates >;
 	using AccessStateMap = std::unordered_map< VkBuffer, AccessState >;
+	using AccessRangeMap = std::map< VkDeviceSize, AccessRange >;
+	using BufferAccessStates = std::unordered_map< VkBuffer, AccessRangeMap >;
 	using ViewsLayout = LayoutStateMap;
 	using BuffersLayout = AccessStateMap;
 	using ViewsLayoutPtr = std::unique_ptr< ViewsLayout >;
@@ -216,9 +262,24 @@ namespace crg
 			: Buffer{ VkBufferArray{ buffer }, std::move( name ) }
 		{
 		}
+		/**
+		*\brief
+		*	References a graph owned buffer, whose handle is filled when the graph is compiled.
+		*/
+		Buffer( VkBuffer * handle
+			, std::string pname )noexcept
+			: name{ std::move( pname ) }
+			, m_handle{ handle }
+		{
+		}
 
 		VkBuffer const & buffer( uint32_t index = 0 )const noexcept
 		{
+			if ( m_handle )
+			{
+				return *m_handle;
+			}
+
 			return m_buffers.size() == 1u
 				? m_buffers.front()
 				: m_buffers[index];
@@ -226,6 +287,11 @@ namespace crg
 
 		VkBuffer & buffer( uint32_t index = 0 )noexcept
 		{
+			if ( m_handle )
+			{
+				return *m_handle;
+			}
+
 			return m_buffers.size() == 1u
 				? m_buffers.front()
 				: m_buffers[index];
@@ -233,11 +299,14 @@ namespace crg
 
 		size_t getCount()const noexcept
 		{
-			return m_buffers.size();
+			return m_handle
+				? 1u
+				: m_buffers.size();
 		}
 
 	private:
 		VkBufferArray m_buffers;
+		VkBuffer * m_handle{};
 
 		friend CRG_API bool operator==( Buffer const & lhs, Buffer const & rhs );
 	};
@@ -331,6 +400,25 @@ namespace crg
 		VkDeviceSize offset;
 		uint32_t stride;
 	};
+	/**
+	*\brief
+	*	The buffer holding the draw count of a multi-draw indirect, written by the GPU.
+	*/
+	struct IndirectCountBuffer
+	{
+		explicit IndirectCountBuffer( Buffer pbuffer
+			, uint32_t pmaxDrawCount
+			, VkDeviceSize poffset = {} )
+			: buffer{ std::move( pbuffer ) }
+			, offset{ poffset }
+			, maxDrawCount{ pmaxDrawCount }
+		{
+		}
+
+		Buffer buffer;
+		VkDeviceSize offset;
+		uint32_t maxDrawCount;
+	};
 
 	static constexpr VkPipelineColorBlendAttachmentState DefaultBlendState{ VK_FALSE
 		, VK_BLEND_FACTOR_ONE
@@ -382,6 +470,16 @@ namespace crg
 		}
 	};
 
+	template<>
+	struct DefaultValueGetterT< IndirectCountBuffer >
+	{
+		static IndirectCountBuffer get()
+		{
+			IndirectCountBuffer const result{ Buffer{ VkBuffer{}, std::string{} }, 0u };
+			return result;
+		}
+	};
+
 	template< typename TypeT >
 	struct RawTyperT
 	{
@@ -424,6 +522,7 @@ namespace crg
 		, VkImageViewType viewType
 		, VkImageSubresourceRange const & range )noexcept;
 	CRG_API bool match( ImageViewData const & lhs, ImageViewData const & rhs )noexcept;
+	CRG_API bool isOverlapping( ImageViewData const & lhs, ImageViewData const & rhs )noexcept;
 	CRG_API bool isDepthFormat( VkFormat fmt )noexcept;
 	CRG_API bool isStencilFormat( VkFormat fmt )noexcept;
 	CRG_API bool isColourFormat( VkFormat fmt )noexcept;
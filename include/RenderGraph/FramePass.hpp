@@ -96,6 +96,15 @@ namespace crg
 			, AccessState wantedAccess );
 		/**
 		*\brief
+		*	Creates an indirect buffer attachment, holding draw or dispatch commands, or a draw count.
+		*\remarks
+		*	The buffer is transitioned to indirect command read, in the draw indirect stage.
+		*/
+		CRG_API void addIndirectBuffer( Buffer buffer
+			, VkDeviceSize offset
+			, VkDeviceSize range );
+		/**
+		*\brief
 		*	Creates a uniform buffer attachment.
 		*/
 		CRG_API void addUniformBuffer( Buffer buffer
@@ -240,6 +249,17 @@ namespace crg
 			, SamplerDesc samplerDesc = SamplerDesc{} );
 		/**
 		*\brief
+		*	Creates a sampled image attachment, only read at the pixel being rendered.
+		*\remarks
+		*	When the view is rendered to by a previous render pass, both passes can be merged as subpasses
+		*	of a single render pass, the view being then an input attachment of this pass' subpass.
+		*	This requires the image to be created with VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT.
+		*/
+		CRG_API void addSamePixelSampledView( ImageViewIdArray view
+			, uint32_t binding
+			, SamplerDesc samplerDesc = SamplerDesc{} );
+		/**
+		*\brief
 		*	Creates an implicit image attachment.
 		*\remarks
 		*	This image will only be transitioned to wanted layout at pass start, without being actually used.
@@ -325,6 +345,18 @@ namespace crg
 		}
 		/**
 		*\brief
+		*	Creates a sampled image attachment, only read at the pixel being rendered.
+		*/
+		inline void addSamePixelSampledView( ImageViewId view
+			, uint32_t binding
+			, SamplerDesc samplerDesc = SamplerDesc{} )
+		{
+			addSamePixelSampledView( ImageViewIdArray{ view }
+				, binding
+				, std::move( samplerDesc ) );
+		}
+		/**
+		*\brief
 		*	Creates an implicit image attachment.
 		*\remarks
 		*	This image will only be transitioned to wanted layout at pass start, without being actually used.
@@ -660,6 +692,21 @@ namespace crg
 		{
 			return m_name;
 		}
+		/**
+		*\brief
+		*	Tells that the pass has effects that are not visible through its attachments (readbacks, queries, ...).
+		*\remarks
+		*	Such a pass is never culled.
+		*/
+		void setSideEffects( bool value = true )
+		{
+			m_sideEffects = value;
+		}
+
+		bool hasSideEffects()const
+		{
+			return m_sideEffects;
+		}
 
 		FramePassGroup const & group;
 		FrameGraph & graph;
@@ -796,5 +843,6 @@ namespace crg
 
 	private:
 		std::string m_name;
+		bool m_sideEffects{};
 	};
 }
@@ -46,6 +46,11 @@ namespace crg
 		/**@[*/
 		CRG_API void addGroupInput( ImageViewId view );
 		CRG_API void addGroupOutput( ImageViewId view );
+		/**
+		*\brief
+		*	Lists the IDs of the views registered through addGroupOutput, in this group and its nested groups.
+		*/
+		CRG_API void listGroupOutputs( std::unordered_set< uint32_t > & result )const;
 		/**@}*/
 		/**
 		*\name
@@ -56,6 +61,7 @@ namespace crg
 			, uint32_t passIndex = 0u )const;
 		CRG_API ImageId createImage( ImageData const & img )const;
 		CRG_API ImageViewId createView( ImageViewData const & view )const;
+		CRG_API Buffer createBuffer( BufferData const & buffer )const;
 		CRG_API void addInput( ImageId image
 			, VkImageViewType viewType
 			, VkImageSubresourceRange const & range
@@ -101,11 +101,20 @@ namespace crg
 		CRG_API void reset()noexcept;
 		/**
 		*\brief
+		*	Resets the queries of the next pass.
+		*\remarks
+		*	Meant for passes recorded inside a render pass, where no query can be reset.
+		*\param[in] cmd
+		*	The command buffer used to record the reset.
+		*/
+		CRG_API void resetPass( VkCommandBuffer commandBuffer )noexcept;
+		/**
+		*\brief
 		*	Writes the timestamp for the beginning of the pass.
+		*\remarks
+		*	The queries are reset first, unless resetPass has been called since the last pass.
 		*\param[in] cmd
 		*	The command buffer used to record the begin timestamp.
-		*\param[in] passIndex
-		*	The pass index.
 		*/
 		CRG_API void beginPass( VkCommandBuffer commandBuffer )noexcept;
 		/**
@@ -169,6 +178,7 @@ namespace crg
 			bool started{};
 		};
 		std::array< Query, 2u > m_queries;
+		bool m_passReset{};
 	};
 }
 
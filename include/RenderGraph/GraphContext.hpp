@@ -238,6 +238,18 @@ namespace crg
 		static inline std::string Name{ "VkPipeline" };
 	};
 
+	template<>
+	struct DebugTypeTraits< VkPipelineCache >
+	{
+#if VK_EXT_debug_utils
+		static VkObjectType constexpr UtilsValue = VK_OBJECT_TYPE_PIPELINE_CACHE;
+#endif
+#if VK_EXT_debug_report || VK_EXT_debug_marker
+		static VkDebugReportObjectTypeEXT constexpr ReportValue = VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_CACHE_EXT;
+#endif
+		static inline std::string Name{ "VkPipelineCache" };
+	};
+
 	template<>
 	struct DebugTypeTraits< VkPipelineLayout >
 	{
@@ -391,6 +403,8 @@ namespace crg
 		VkPhysicalDeviceProperties properties{};
 		VkPhysicalDeviceFeatures features{};
 		bool separateDepthStencilLayouts;
+		// Set to true when VK_KHR_dynamic_rendering is enabled on the device, to render without VkRenderPass.
+		bool dynamicRendering{};
 		DeletionQueue delQueue;
 
 #define DECL_vkFunction( name )\
@@ -399,6 +413,9 @@ namespace crg
 		DECL_vkFunction( CreateGraphicsPipelines );
 		DECL_vkFunction( CreateComputePipelines );
 		DECL_vkFunction( DestroyPipeline );
+		DECL_vkFunction( CreatePipelineCache );
+		DECL_vkFunction( DestroyPipelineCache );
+		DECL_vkFunction( GetPipelineCacheData );
 		DECL_vkFunction( CreatePipelineLayout );
 		DECL_vkFunction( DestroyPipelineLayout );
 		DECL_vkFunction( CreateDescriptorSetLayout );
@@ -466,8 +483,17 @@ namespace crg
 		DECL_vkFunction( CmdDrawIndexed );
 		DECL_vkFunction( CmdDrawIndexedIndirect );
 		DECL_vkFunction( CmdDrawIndirect );
+#if VK_VERSION_1_2
+		DECL_vkFunction( CmdDrawIndexedIndirectCount );
+		DECL_vkFunction( CmdDrawIndirectCount );
+#endif
 		DECL_vkFunction( CmdBeginRenderPass );
 		DECL_vkFunction( CmdEndRenderPass );
+		DECL_vkFunction( CmdNextSubpass );
+#if VK_KHR_dynamic_rendering
+		DECL_vkFunction( CmdBeginRenderingKHR );
+		DECL_vkFunction( CmdEndRenderingKHR );
+#endif
 		DECL_vkFunction( CmdPushConstants );
 		DECL_vkFunction( CmdResetQueryPool );
 		DECL_vkFunction( CmdWriteTimestamp );
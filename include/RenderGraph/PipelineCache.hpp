@@ -0,0 +1,79 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#pragma once
+
+#include "FrameGraphPrerequisites.hpp"
+
+#include <vector>
+
+namespace crg
+{
+	/**
+	*\brief
+	*	A VkPipelineCache persisted in a file.
+	*\remarks
+	*	On construction, the file content is used as initial data, if it matches the device.
+	*	The cache then replaces the GraphContext's one, so that every pipeline created through the context uses it.
+	*	On destruction, the cache content is written back to the file, and the previous context's cache is restored.
+	*	Hence, it must outlive the runnable graphs using the context.
+	*/
+	class PipelineCache
+	{
+	public:
+		PipelineCache( PipelineCache const & rhs ) = delete;
+		PipelineCache( PipelineCache && rhs )noexcept = delete;
+		PipelineCache & operator=( PipelineCache const & rhs ) = delete;
+		PipelineCache & operator=( PipelineCache && rhs )noexcept = delete;
+		/**
+		*\brief
+		*	Creates the cache, from the file content if it is valid for the device.
+		*\param[in] context
+		*	The graph context, its pipeline cache is replaced.
+		*\param[in] filePath
+		*	The cache file path.
+		*/
+		CRG_API PipelineCache( GraphContext & context
+			, std::string filePath );
+		CRG_API ~PipelineCache()noexcept;
+		/**
+		*\brief
+		*	Writes the cache content to the file.
+		*\remarks
+		*	The data is written to a temporary file, which then replaces the cache file,
+		*	so that an interrupted write doesn't leave a truncated cache file.
+		*\return
+		*	\p false if the data could not be written.
+		*/
+		CRG_API bool save()const;
+		/**
+		*\brief
+		*	Tells if given data is usable as initial data for a pipeline cache, on the device described by given properties.
+		*/
+		CRG_API static bool isCompatible( VkPhysicalDeviceProperties const & properties
+			, std::vector< uint8_t > const & data );
+
+		VkPipelineCache getCache()const noexcept
+		{
+			return m_cache;
+		}
+
+		bool isLoaded()const noexcept
+		{
+			return m_loaded;
+		}
+
+		std::string const & getFilePath()const noexcept
+		{
+			return m_filePath;
+		}
+
+	private:
+		GraphContext & m_context;
+		std::string m_filePath;
+		VkPipelineCache m_previous{};
+		VkPipelineCache m_cache{};
+		bool m_loaded{};
+	};
+}
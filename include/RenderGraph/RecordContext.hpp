@@ -9,6 +9,8 @@ See LICENSE file in root folder.
 
 #include <functional>
 #include <map>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 
 namespace crg
@@ -26,6 +28,7 @@ namespace crg
 			ImageViewId view;
 			ImplicitAction action;
 		};
+		using ImplicitTransitionPtr = std::shared_ptr< ImplicitTransition const >;
 
 	public:
 		CRG_API explicit RecordContext( ContextResourcesCache & resources );
@@ -41,6 +44,12 @@ namespace crg
 		//@{
 		CRG_API void setNextPipelineState( PipelineState const & state
 			, LayerLayoutStatesMap const & imageLayouts );
+		/**
+		*\brief
+		*	Sets the next pipeline state, sharing the next layouts instead of copying them.
+		*/
+		CRG_API void setNextPipelineState( PipelineState const & state
+			, std::shared_ptr< LayerLayoutStatesHandler const > imageLayouts );
 		//@}
 		/**
 		*\name	Images
@@ -67,6 +76,11 @@ namespace crg
 			, crg::ImageViewId view
 			, ImplicitAction action = []( RecordContext &, VkCommandBuffer, uint32_t ){} );
 		CRG_API void registerImplicitTransition( ImplicitTransition transition );
+		/**
+		*\brief
+		*	Registers a transition built once, avoiding the action copy.
+		*/
+		CRG_API void registerImplicitTransition( ImplicitTransitionPtr transition );
 		CRG_API void runImplicitTransition( VkCommandBuffer commandBuffer
 			, uint32_t index
 			, crg::ImageViewId view );
@@ -142,6 +156,30 @@ namespace crg
 			, bool force = false );
 		//@}
 		//@}
+		/**
+		*\name	Barriers batching
+		*/
+		//@{
+		/**
+		*\brief
+		*	Starts deferring the barriers, so that adjacent subresources ones can be coalesced.
+		*\remarks
+		*	The deferred barriers are emitted by flushBarriers, which must be called before
+		*	any command depending on them. A barrier on a subresource already pending flushes the batch.
+		*/
+		CRG_API void beginBarriersBatch();
+		/**
+		*\brief
+		*	Emits the deferred barriers, merging the ones on adjacent mip levels or array layers
+		*	with identical layouts and accesses.
+		*/
+		CRG_API void flushBarriers( VkCommandBuffer commandBuffer );
+		/**
+		*\brief
+		*	Emits the deferred barriers and stops deferring.
+		*/
+		CRG_API void endBarriersBatch( VkCommandBuffer commandBuffer );
+		//@}
 		CRG_API GraphContext & getContext()const;
 
 		GraphContext * operator->()const
@@ -191,20 +229,63 @@ namespace crg
 		{
 			return m_nextPipelineState;
 		}
+		/**
+		*\brief
+		*	Tells that the recorded commands are only valid for the current run (pipeline still compiling, ...).
+		*/
+		void setVolatile()noexcept
+		{
+			m_volatile = true;
+		}
+
+		bool isVolatile()const noexcept
+		{
+			return m_volatile;
+		}
+		/**
+		*\brief
+		*	The number of read after read barriers skipped, because the read stages already saw the last write.
+		*/
+		uint32_t getElidedBarriersCount()const noexcept
+		{
+			return m_elidedBarriers;
+		}
 
 	private:
+		template< typename BarrierT >
+		struct PendingBarrierT
+		{
+			VkPipelineStageFlags srcStage;
+			VkPipelineStageFlags dstStage;
+			BarrierT barrier;
+		};
+
 		ContextResourcesCache & getResources()const;
+		void doAddBarrier( VkCommandBuffer commandBuffer
+			, VkPipelineStageFlags srcStage
+			, VkPipelineStageFlags dstStage
+			, VkImageMemoryBarrier const & barrier );
+		void doAddBarriers( VkCommandBuffer commandBuffer
+			, VkPipelineStageFlags srcStage
+			, VkPipelineStageFlags dstStage
+			, std::vector< VkBufferMemoryBarrier > const & barriers );
 
 	private:
 		ResourceHandler * m_handler;
 		ContextResourcesCache * m_resources;
 		LayerLayoutStatesHandler m_images;
-		AccessStateMap m_buffers;
-		std::vector< ImplicitTransition > m_implicitTransitions;
+		BufferAccessStates m_buffers;
+		// The pending implicit transitions, by view id, in registration order.
+		std::unordered_map< uint32_t, std::vector< ImplicitTransitionPtr > > m_implicitTransitions;
 		PassIndexArray m_state;
 		PipelineState m_prevPipelineState{};
 		PipelineState m_currPipelineState{};
 		PipelineState m_nextPipelineState{};
-		LayerLayoutStatesHandler m_nextImages;
+		std::shared_ptr< LayerLayoutStatesHandler const > m_nextImages;
+		bool m_volatile{};
+		uint32_t m_elidedBarriers{};
+		bool m_batching{};
+		std::vector< PendingBarrierT< VkImageMemoryBarrier > > m_pendingImageBarriers;
+		std::vector< PendingBarrierT< VkBufferMemoryBarrier > > m_pendingBufferBarriers;
 	};
 }
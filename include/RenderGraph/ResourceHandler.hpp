@@ -10,6 +10,7 @@ See LICENSE file in root folder.
 #pragma warning( disable: 5262 )
 #include <mutex>
 #pragma warning( pop )
+#include <map>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -20,6 +21,32 @@ namespace crg
 		VkSampler sampler;
 		std::string name;
 	};
+	/**
+	*\brief
+	*	The memory requirements of a resource, and the memory type its memory was allocated from.
+	*/
+	struct ResourceMemory
+	{
+		VkMemoryRequirements requirements{};
+		uint32_t memoryType{};
+	};
+	/**
+	*\brief
+	*	Aggregated memory usage of a set of resources.
+	*/
+	struct MemoryStats
+	{
+		VkDeviceSize size{};
+		uint32_t count{};
+		std::map< uint32_t, VkDeviceSize > perMemoryType{};
+
+		void add( ResourceMemory const & memory )
+		{
+			size += memory.requirements.size;
+			++count;
+			perMemoryType[memory.memoryType] += memory.requirements.size;
+		}
+	};
 
 	class ResourceHandler
 	{
@@ -34,13 +61,50 @@ namespace crg
 		CRG_API ResourceHandler() = default;
 		CRG_API ~ResourceHandler()noexcept;
 
+		CRG_API BufferId createBufferId( BufferData const & buffer );
 		CRG_API ImageId createImageId( ImageData const & img );
 		CRG_API ImageViewId createViewId( ImageViewData const & view );
+		/**
+		*\return
+		*	The storage of given graph owned buffer handle, filled by createBuffer and reset by destroyBuffer.
+		*/
+		CRG_API VkBuffer * getBufferHandle( BufferId const & bufferId );
 
+		/**
+		*\param[in] transient
+		*	\p true if the image content only lives inside a render pass.
+		*	It is then created as a transient attachment, in lazily allocated memory when available.
+		*	Ignored if the image already exists.
+		*/
 		CRG_API CreatedT< VkImage > createImage( GraphContext & context
-			, ImageId imageId );
+			, ImageId imageId
+			, bool transient = false );
 		CRG_API CreatedT< VkImageView > createImageView( GraphContext & context
 			, ImageViewId viewId );
+		/**
+		*\brief
+		*	Creates the buffer, without binding memory to it.
+		*/
+		CRG_API CreatedT< VkBuffer > createBuffer( GraphContext & context
+			, BufferId bufferId );
+		/**
+		*\brief
+		*	Allocates a single memory block, bound to all given buffers which don't have memory yet.
+		*\remarks
+		*	The buffers hence alias each other, their accesses must not overlap.
+		*	They must share the same memory properties.
+		*/
+		CRG_API void bindBufferMemory( GraphContext & context
+			, BufferIdArray const & buffers );
+		/**
+		*\return
+		*	The host address of given graph owned buffer, its memory block being mapped on first call,
+		*	\p nullptr if the buffer has no memory yet.
+		*\remarks
+		*	The buffer memory must be host visible.
+		*/
+		CRG_API void * mapBufferMemory( GraphContext & context
+			, BufferId const & bufferId );
 		CRG_API VkSampler createSampler( GraphContext & context
 			, std::string const & suffix
 			, SamplerDesc const & samplerDesc );
@@ -52,10 +116,68 @@ namespace crg
 			, ImageId imageId );
 		CRG_API void destroyImageView( GraphContext & context
 			, ImageViewId viewId );
+		/**
+		*\brief
+		*	Destroys the buffer, its memory block is freed when no other buffer is bound to it anymore.
+		*/
+		CRG_API void destroyBuffer( GraphContext & context
+			, BufferId bufferId );
 		CRG_API void destroySampler( GraphContext & context
 			, VkSampler sampler );
 		CRG_API void destroyVertexBuffer( GraphContext & context
 			, VertexBuffer const * buffer );
+		/**
+		*\name
+		*	Memory accounting.
+		*/
+		/**@{*/
+		/**
+		*\return
+		*	The memory used by given image, empty if it was not created.
+		*/
+		CRG_API ResourceMemory getMemory( ImageId const & image )const;
+		/**
+		*\return
+		*	The memory used by given vertex buffer, empty if it was not created by this handler.
+		*/
+		CRG_API ResourceMemory getMemory( VertexBuffer const & buffer )const;
+		/**
+		*\return
+		*	The memory block bound to given buffer, empty if it has no memory yet.
+		*/
+		CRG_API ResourceMemory getMemory( BufferId const & buffer )const;
+		/**
+		*\return
+		*	The memory block bound to given buffer, shared by the buffers aliasing it, \p VK_NULL_HANDLE if it has no memory yet.
+		*/
+		CRG_API VkDeviceMemory getMemoryBlock( BufferId const & buffer )const;
+		/**
+		*\return
+		*	The memory used by the given buffers, each memory block being counted once.
+		*/
+		CRG_API MemoryStats getMemoryStats( BufferIdArray const & buffers )const;
+		/**
+		*\return
+		*	The memory currently used by all the images and buffers created by this handler.
+		*/
+		CRG_API MemoryStats getMemoryStats()const;
+		/**
+		*\return
+		*	The highest memory size used at once, since the handler creation.
+		*/
+		CRG_API VkDeviceSize getPeakMemoryUsage()const;
+		/**@}*/
+
+	private:
+		struct MemoryBlock
+		{
+			ResourceMemory memory;
+			uint32_t refCount;
+			void * mapped{};
+		};
+
+		void doAddMemory( VkDeviceSize size );
+		void doRemoveMemory( VkDeviceSize size );
 
 	private:
 		mutable std::mutex m_imagesMutex;
@@ -66,8 +188,17 @@ namespace crg
 		ImageViewMap m_imageViews;
 		std::mutex m_samplersMutex;
 		std::unordered_map< VkSampler, Sampler > m_samplers;
-		std::mutex m_buffersMutex;
+		mutable std::mutex m_buffersMutex;
 		std::unordered_set< VertexBufferPtr > m_vertexBuffers;
+		std::map< ImageId, ResourceMemory > m_imagesMemory;
+		std::unordered_map< VertexBuffer const *, ResourceMemory > m_buffersMemory;
+		BufferIdDataOwnerCont m_bufferIds;
+		std::map< BufferId, VkBuffer > m_graphBuffers;
+		std::map< BufferId, VkDeviceMemory > m_graphBuffersMemory;
+		std::unordered_map< VkDeviceMemory, MemoryBlock > m_memoryBlocks;
+		mutable std::mutex m_memoryMutex;
+		VkDeviceSize m_currentMemory{};
+		VkDeviceSize m_peakMemory{};
 	};
 
 	class ContextResourcesCache
@@ -82,14 +213,64 @@ namespace crg
 			, GraphContext & context );
 		CRG_API ~ContextResourcesCache()noexcept;
 
-		CRG_API VkImage createImage( ImageId const & imageId );
+		CRG_API VkImage createImage( ImageId const & imageId
+			, bool transient = false );
 		CRG_API VkImageView createImageView( ImageViewId const & viewId );
 		CRG_API bool destroyImage( ImageId const & imageId );
 		CRG_API bool destroyImageView( ImageViewId const & viewId );
+		/**
+		*\brief
+		*	Creates the buffer if needed, the cache then owns it.
+		*/
+		CRG_API VkBuffer createBuffer( BufferId const & bufferId );
+		CRG_API void bindBufferMemory( BufferIdArray const & buffers );
+		CRG_API bool destroyBuffer( BufferId const & bufferId );
 
 		CRG_API VkSampler createSampler( SamplerDesc const & samplerDesc );
 		CRG_API VertexBuffer const & createQuadTriVertexBuffer( bool texCoords
 			, Texcoord const & config );
+		/**
+		*\brief
+		*	Retrieves the framebuffer matching given parameters, creating it if needed.
+		*\remarks
+		*	The framebuffers are shared by all the passes rendering to the same views with the same render pass.
+		*	They are destroyed along with any of their views, or with destroyFramebuffers.
+		*/
+		CRG_API VkFramebuffer createFramebuffer( std::string const & name
+			, VkRenderPass renderPass
+			, VkImageViewArray const & views
+			, VkExtent2D const & extent
+			, uint32_t layers );
+		/**
+		*\brief
+		*	Destroys the framebuffers created for given render pass.
+		*\remarks
+		*	Their destruction is deferred to the context's deletion queue, since in flight submissions may still use them.
+		*/
+		CRG_API void destroyFramebuffers( VkRenderPass renderPass );
+		/**
+		*\brief
+		*	Retrieves a render pass matching given create info, creating it if needed.
+		*\remarks
+		*	Render passes with the same attachments, subpasses and dependencies are shared,
+		*	each call must then be balanced by a call to destroyRenderPass.
+		*/
+		CRG_API VkRenderPass createRenderPass( std::string const & name
+			, VkRenderPassCreateInfo const & createInfo );
+		/**
+		*\brief
+		*	Releases a reference to given render pass.
+		*\remarks
+		*	When the render pass isn't referenced anymore, its destruction and the one of its framebuffers
+		*	are deferred to the context's deletion queue, since in flight submissions may still use them.
+		*	This queue is drained after the graph fence wait, in RunnableGraph::run, and on the cache destruction.
+		*/
+		CRG_API void destroyRenderPass( VkRenderPass renderPass );
+		/**
+		*\return
+		*	The memory used by the images and buffers created through this cache.
+		*/
+		CRG_API MemoryStats getMemoryStats()const;
 
 		GraphContext * operator->()const noexcept
 		{
@@ -106,16 +287,39 @@ namespace crg
 			return m_handler;
 		}
 
+	private:
+		struct Framebuffer
+		{
+			VkFramebuffer framebuffer;
+			VkRenderPass renderPass;
+			VkImageViewArray views;
+			VkExtent2D extent;
+			uint32_t layers;
+		};
+
+		struct RenderPass
+		{
+			VkRenderPass renderPass;
+			std::vector< uint32_t > key;
+			uint32_t refCount;
+		};
+
+		void doDestroyFramebuffers( std::function< bool( Framebuffer const & ) > const & predicate );
+
 	private:
 		using VkImageIdMap = std::map< ImageId, VkImage >;
 		using VkImageViewIdMap = std::map< ImageViewId, VkImageView >;
+		using VkBufferIdMap = std::map< BufferId, VkBuffer >;
 
 		ResourceHandler & m_handler;
 		GraphContext & m_context;
 		VkImageIdMap m_images;
 		VkImageViewIdMap m_imageViews;
+		VkBufferIdMap m_buffers;
 		std::unordered_map< size_t, VkSampler > m_samplers;
 		std::unordered_map< size_t, VertexBuffer const * > m_vertexBuffers;
+		std::unordered_multimap< size_t, Framebuffer > m_framebuffers;
+		std::unordered_multimap< size_t, RenderPass > m_renderPasses;
 	};
 
 	class ResourcesCache
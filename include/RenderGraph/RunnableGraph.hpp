@@ -9,6 +9,8 @@ See LICENSE file in root folder.
 #include "ResourceHandler.hpp"
 #include "RunnablePass.hpp"
 
+#include <set>
+
 namespace crg
 {
 	/**
@@ -39,6 +41,69 @@ namespace crg
 		}
 	};
 
+	/**
+	*\brief
+	*	Consecutive render passes sharing their render targets dimensions,
+	*	where each pass only accesses the previous ones outputs at the same pixel,
+	*	through its render targets or through views added with FramePass::addSamePixelSampledView.
+	*\remarks
+	*	Such passes are recorded as the subpasses of a single render pass.
+	*/
+	using RenderPassChain = std::vector< FramePass const * >;
+	using RenderPassChainArray = std::vector< RenderPassChain >;
+
+	/**
+	*\brief
+	*	The span of passes, in execution order, during which a resource is used.
+	*/
+	struct ResourceLifetime
+	{
+		std::string name{};
+		uint32_t firstPass{};
+		uint32_t lastPass{};
+		//!\brief The image memory size for images and views, the largest accessed range for buffers.
+		VkDeviceSize size{};
+		//!\brief VkImageUsageFlags for images and views, VkBufferUsageFlags for buffers.
+		VkFlags usage{};
+	};
+	/**
+	*\brief
+	*	The lifetimes of the resources accessed by the passes of a runnable graph.
+	*/
+	struct ResourceLifetimes
+	{
+		//!\brief The passes, in execution order, the lifetimes indices refer to.
+		FramePassArray passes{};
+		std::map< ImageId, ResourceLifetime > images{};
+		std::map< ImageViewId, ResourceLifetime > views{};
+		std::map< VkBuffer, ResourceLifetime > buffers{};
+	};
+	/**
+	*\brief
+	*	The memory used by the images and graph buffers alive when a pass is executed.
+	*/
+	struct PassMemoryUsage
+	{
+		FramePass const * pass{};
+		VkDeviceSize liveSize{};
+	};
+	/**
+	*\brief
+	*	The memory usage of a runnable graph.
+	*/
+	struct GraphMemoryStats
+	{
+		//!\brief The memory used by all the graph resources.
+		MemoryStats total{};
+		//!\brief The memory used by the images and graph buffers, per group of the pass first using them.
+		std::map< FramePassGroup const *, MemoryStats > groups{};
+		//!\brief The memory used by the images and graph buffers alive at each pass, in execution order.
+		//!\remarks Aliased graph buffers are counted once, from the first to the last pass using their memory block.
+		std::vector< PassMemoryUsage > timeline{};
+		//!\brief The highest memory size in the timeline.
+		VkDeviceSize livePeak{};
+	};
+
 	class RunnableGraph
 	{
 	public:
@@ -58,6 +123,21 @@ namespace crg
 		CRG_API ~RunnableGraph()noexcept;
 
 		CRG_API void record();
+		/**
+		*\brief
+		*	Sets the maximum count of pre-recorded command buffers.
+		*\remarks
+		*	When not 0, run() keeps a command buffer for each observed combination of passes indices and enabled statuses,
+		*	and submits it again, without recording, when that combination comes back.
+		*	The passes are hence expected to record the same commands for a given combination,
+		*	invalidateVariants() must be called when it is not the case.
+		*/
+		CRG_API void setMaxVariants( uint32_t count );
+		/**
+		*\brief
+		*	Discards the pre-recorded command buffers, on next run.
+		*/
+		CRG_API void invalidateVariants()noexcept;
 
 		CRG_API SemaphoreWaitArray run( VkQueue queue );
 		CRG_API SemaphoreWaitArray run( SemaphoreWait toWait
@@ -81,6 +161,64 @@ namespace crg
 			, crg::RunnablePass const & runnable
 			, ImageViewId view )const;
 		CRG_API LayoutState getOutputLayoutState( ImageViewId view )const;
+		/**
+		*\brief
+		*	Tells if the content written by a pass to a view is read afterwards.
+		*\remarks
+		*	The content is considered read if a later pass reads it, or if a pass reads it
+		*	before it is overwritten in the next run of the graph, or if it is a graph's input or output.
+		*	Images read by other graphs must be registered through FrameGraph::addOutput.
+		*\param[in] pass
+		*	The writing pass.
+		*\param[in] view
+		*	The written view.
+		*/
+		CRG_API bool isOutputConsumed( FramePass const & pass
+			, ImageViewId view )const;
+		/**
+		*\brief
+		*	Tells if the content written by a pass to a view is read outside of the render pass the pass is merged into.
+		*\remarks
+		*	Same as isOutputConsumed, except the reads by the next subpasses of the render pass are ignored.
+		*\param[in] pass
+		*	The writing pass.
+		*\param[in] view
+		*	The written view.
+		*/
+		CRG_API bool isMergedOutputConsumed( FramePass const & pass
+			, ImageViewId view )const;
+		/**
+		*\return
+		*	The layout state expected by the next pass using the view, after the given pass.
+		*\remarks
+		*	Contrary to the overload taking a RecordContext, this one can be called for any pass of the graph while recording.
+		*/
+		CRG_API LayoutState getNextLayoutState( crg::RunnablePass const & runnable
+			, ImageViewId view )const;
+		/**
+		*\return
+		*	The pipeline state of the next enabled pass, after the given pass.
+		*/
+		CRG_API PipelineState getNextPipelineState( crg::RunnablePass const & runnable )const;
+		/**
+		*\brief
+		*	Registers a render pass that can be recorded as a subpass of a render pass begun by a previous pass.
+		*\remarks
+		*	To be called from the runnable pass constructor.
+		*\param[in] runnable
+		*	The runnable pass.
+		*\param[in] holder
+		*	Its render pass holder.
+		*/
+		CRG_API void registerSubpass( RunnablePass & runnable
+			, RenderPassHolder & holder );
+		/**
+		*\brief
+		*	Computes the memory usage of the graph's resources.
+		*\remarks
+		*	An image is considered alive from the first to the last pass accessing it.
+		*/
+		CRG_API GraphMemoryStats getMemoryStats()const;
 
 		ConstGraphAdjacentNode getGraph()const noexcept
 		{
@@ -97,6 +235,24 @@ namespace crg
 			return m_transitions;
 		}
 
+		RenderPassChainArray const & getRenderPassChains()const noexcept
+		{
+			return m_renderPassChains;
+		}
+		/**
+		*\return
+		*	\p true while the graph command buffer is being recorded.
+		*/
+		bool isRecording()const noexcept
+		{
+			return m_recording;
+		}
+
+		ResourceLifetimes const & getResourceLifetimes()const noexcept
+		{
+			return m_lifetimes;
+		}
+
 		VkCommandPool getCommandPool()const noexcept
 		{
 			return m_commandPool.object;
@@ -137,6 +293,59 @@ namespace crg
 			return m_timer;
 		}
 
+		uint32_t getVariantCount()const noexcept
+		{
+			return uint32_t( m_variants.size() );
+		}
+		/**
+		*\return
+		*	The number of read after read barriers elided while recording the last command buffer.
+		*/
+		uint32_t getElidedBarriersCount()const noexcept
+		{
+			return m_elidedBarriers;
+		}
+
+	private:
+		struct Variant
+		{
+			RecordContext::PassIndexArray key;
+			VkCommandBuffer commandBuffer;
+			RecordContext finalState;
+			RecordContext::GraphIndexMap states;
+			bool reusable;
+		};
+		/**
+		*\brief
+		*	A later pass using an image of a pass, with the states it expects for the common subresources.
+		*/
+		struct NextImageUse
+		{
+			uint32_t pass;
+			LayerLayoutStates states;
+		};
+		/**
+		*\brief
+		*	The layouts expected by the passes following a pass, computed once at compile time.
+		*/
+		struct NextImageLayouts
+		{
+			// For each image used by the pass, the later passes using it, in execution order.
+			std::map< uint32_t, std::vector< NextImageUse > > uses;
+			// The next layouts when all the passes are enabled.
+			std::shared_ptr< LayerLayoutStatesHandler const > layouts;
+		};
+
+		void doMergeSubpasses();
+		void doBuildNextImageLayouts();
+		std::shared_ptr< LayerLayoutStatesHandler const > doGetNextImageLayouts( size_t index )const;
+		RecordContext doRecordInto( VkCommandBuffer commandBuffer
+			, VkCommandBufferUsageFlags usage );
+		RecordContext::PassIndexArray doGetVariantKey()const;
+		VkCommandBuffer doGetVariant();
+		void doDestroyVariants();
+		void doWriteFrameData();
+
 	private:
 		FrameGraph & m_graph;
 		GraphContext & m_context;
@@ -144,12 +353,26 @@ namespace crg
 		AttachmentTransitions m_transitions;
 		GraphNodePtrArray m_nodes;
 		RootNode m_rootNode;
+		RenderPassChainArray m_renderPassChains;
+		std::set< std::pair< FramePass const *, ImageViewId > > m_unconsumedOutputs;
+		std::set< std::pair< FramePass const *, ImageViewId > > m_unconsumedMergedOutputs;
+		std::map< FramePass const *, std::pair< RunnablePass *, RenderPassHolder * > > m_subpasses;
+		ResourceLifetimes m_lifetimes;
+		AccessStateMap m_aliasStates;
 		ContextObjectT< VkQueryPool > m_timerQueries;
 		uint32_t m_timerQueryOffset{};
 		ContextObjectT< VkCommandPool > m_commandPool;
 		std::vector< RunnablePassPtr > m_passes;
+		std::vector< NextImageLayouts > m_nextImageLayouts;
 		RecordContext::GraphIndexMap m_states;
 		VkCommandBuffer m_commandBuffer{};
+		uint32_t m_maxVariants{};
+		bool m_variantsDirty{};
+		std::vector< Variant > m_variants;
+		std::vector< std::pair< FrameDataProvider const *, BufferId > > m_frameData;
+		RecordContext::PassIndexArray m_lastIndices;
+		uint32_t m_elidedBarriers{};
+		bool m_recording{};
 		VkSemaphore m_semaphore{};
 		Fence m_fence;
 		FramePassTimer m_timer;
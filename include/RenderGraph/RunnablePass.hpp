@@ -235,6 +235,25 @@ namespace crg
 		CRG_API uint32_t reRecordCurrent();
 		/**
 		*\brief
+		*	Records the commands the pass can't record inside a render pass begun by a previous pass:
+		*	its attachments barriers and its timer queries reset.
+		*\param[in,out] context
+		*	Stores the states.
+		*\param[in] commandBuffer
+		*	Receives the commands.
+		*\param[in] attachments
+		*	The views transitioned by the render pass itself, which get no barrier.
+		*/
+		CRG_API void prepareSubpass( RecordContext & context
+			, VkCommandBuffer commandBuffer
+			, std::set< ImageViewId > const & attachments );
+		/**
+		*\return
+		*	\p true if the pass records commands before or after its own ones (see ru::Config).
+		*/
+		CRG_API bool hasPassActions()const;
+		/**
+		*\brief
 		*	Resets the command buffer to initial state.
 		*/
 		CRG_API void resetCommandBuffer( uint32_t passIndex );
@@ -300,6 +319,14 @@ namespace crg
 			, uint32_t index
 			, RecordContext & context );
 
+		void doRecordImageBarrier( RecordContext & context
+			, VkCommandBuffer commandBuffer
+			, uint32_t index
+			, Attachment const & attach );
+		void doRecordBufferBarrier( RecordContext & context
+			, VkCommandBuffer commandBuffer
+			, uint32_t index
+			, Attachment const & attach );
 		VkCommandBuffer doCreateCommandBuffer( std::string const & suffix );
 
 	private:
@@ -354,6 +381,8 @@ namespace crg
 		std::vector< RecordContext > m_passContexts;
 		LayerLayoutStatesHandler m_imageLayouts;
 		AccessStateMap m_bufferAccesses;
+		std::vector< RecordContext::ImplicitTransitionPtr > m_implicitTransitions;
+		bool m_subpassPrepared{};
 	};
 
 	template<>
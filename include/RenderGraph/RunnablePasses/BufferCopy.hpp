@@ -4,9 +4,14 @@ See LICENSE file in root folder.
 #pragma once
 
 #include "RenderGraph/RunnablePass.hpp"
+#include "RenderGraph/RunnablePasses/CopyRegion.hpp"
 
 namespace crg
 {
+	/**
+	*\brief
+	*	Copies the pass' first buffer into its last one.
+	*/
 	class BufferCopy
 		: public RunnablePass
 	{
@@ -19,6 +24,36 @@ namespace crg
 			, ru::Config ruConfig = {}
 			, GetPassIndexCallback passIndex = GetPassIndexCallback( [](){ return 0u; } )
 			, IsEnabledCallback isEnabled = IsEnabledCallback( [](){ return true; } ) );
+		/**
+		*\brief
+		*	Copies the given regions between the pass' buffers.
+		*\remarks
+		*	The regions offsets are relative to the buffers attachments ranges.
+		*	The regions sharing the same source and destination buffers are recorded as one multi-region copy,
+		*	surrounded by a single batch of barriers.
+		*/
+		CRG_API BufferCopy( FramePass const & pass
+			, GraphContext & context
+			, RunnableGraph & graph
+			, BufferCopyRegionArray regions
+			, ru::Config ruConfig = {}
+			, GetPassIndexCallback passIndex = GetPassIndexCallback( [](){ return 0u; } )
+			, IsEnabledCallback isEnabled = IsEnabledCallback( [](){ return true; } ) );
+		/**
+		*\brief
+		*	Copies the data uploaded for this pass in \p uploadRing, instead of the pass' first buffer.
+		*\remarks
+		*	Nothing is copied for a frame without pending upload.
+		*/
+		CRG_API BufferCopy( FramePass const & pass
+			, GraphContext & context
+			, RunnableGraph & graph
+			, UploadRing & uploadRing
+			, VkDeviceSize copyOffset
+			, VkDeviceSize copyRange
+			, ru::Config ruConfig = {}
+			, GetPassIndexCallback passIndex = GetPassIndexCallback( [](){ return 0u; } )
+			, IsEnabledCallback isEnabled = IsEnabledCallback( [](){ return true; } ) );
 
 	private:
 		void doRecordInto( RecordContext & context
@@ -26,7 +61,7 @@ namespace crg
 			, uint32_t index )const;
 
 	private:
-		VkDeviceSize m_copyOffset;
-		VkDeviceSize m_copyRange;
+		BufferCopyRegionArray m_regions;
+		UploadRing * m_uploadRing{};
 	};
 }
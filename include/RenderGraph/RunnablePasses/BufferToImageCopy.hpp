@@ -4,9 +4,14 @@ See LICENSE file in root folder.
 #pragma once
 
 #include "RenderGraph/RunnablePass.hpp"
+#include "RenderGraph/RunnablePasses/CopyRegion.hpp"
 
 namespace crg
 {
+	/**
+	*\brief
+	*	Copies the pass' first buffer into its last image.
+	*/
 	class BufferToImageCopy
 		: public RunnablePass
 	{
@@ -19,14 +24,52 @@ namespace crg
 			, ru::Config ruConfig = {}
 			, GetPassIndexCallback passIndex = GetPassIndexCallback( [](){ return 0u; } )
 			, IsEnabledCallback isEnabled = IsEnabledCallback( [](){ return true; } ) );
+		/**
+		*\brief
+		*	Copies the given regions from the pass' buffers to its images.
+		*\remarks
+		*	The regions buffer offsets are used as is.
+		*	The regions sharing the same buffer and image are recorded as one multi-region copy.
+		*/
+		CRG_API BufferToImageCopy( FramePass const & pass
+			, GraphContext & context
+			, RunnableGraph & graph
+			, BufferImageCopyRegionArray regions
+			, ru::Config ruConfig = {}
+			, GetPassIndexCallback passIndex = GetPassIndexCallback( [](){ return 0u; } )
+			, IsEnabledCallback isEnabled = IsEnabledCallback( [](){ return true; } ) );
+		/**
+		*\brief
+		*	Copies the data uploaded for this pass in \p uploadRing, instead of the pass' first buffer.
+		*\remarks
+		*	Nothing is copied for a frame without pending upload.
+		*/
+		CRG_API BufferToImageCopy( FramePass const & pass
+			, GraphContext & context
+			, RunnableGraph & graph
+			, UploadRing & uploadRing
+			, VkOffset3D copyOffset
+			, VkExtent3D copySize
+			, ru::Config ruConfig = {}
+			, GetPassIndexCallback passIndex = GetPassIndexCallback( [](){ return 0u; } )
+			, IsEnabledCallback isEnabled = IsEnabledCallback( [](){ return true; } ) );
 
 	private:
+		BufferToImageCopy( FramePass const & pass
+			, GraphContext & context
+			, RunnableGraph & graph
+			, UploadRing * uploadRing
+			, BufferImageCopyRegionArray regions
+			, ru::Config ruConfig
+			, GetPassIndexCallback passIndex
+			, IsEnabledCallback isEnabled );
+
 		void doRecordInto( RecordContext & context
 			, VkCommandBuffer commandBuffer
 			, uint32_t index )const;
 
 	private:
-		VkOffset3D m_copyOffset;
-		VkExtent3D m_copySize;
+		BufferImageCopyRegionArray m_regions;
+		UploadRing * m_uploadRing{};
 	};
 }
@@ -14,6 +14,30 @@ namespace crg
 		{
 		};
 		using GetGroupCountCallback = GetValueCallbackT< GroupCountT, uint32_t >;
+		/**
+		*\brief
+		*	One dispatch of a ComputePass dispatch list.
+		*/
+		struct Dispatch
+		{
+			uint32_t groupCountX{ 1u };
+			uint32_t groupCountY{ 1u };
+			uint32_t groupCountZ{ 1u };
+			/**
+			*	The push constants data of this dispatch, pushed to the compute stage at \p pushConstantsOffset.
+			*/
+			std::vector< uint8_t > pushConstants{};
+			uint32_t pushConstantsOffset{};
+			/**
+			*	Tells if this dispatch reads what the previous ones wrote, a memory barrier is then recorded before it.
+			*/
+			bool dependsOnPrevious{};
+		};
+		using DispatchArray = std::vector< Dispatch >;
+		struct DispatchesT
+		{
+		};
+		using GetDispatchesCallback = GetValueCallbackT< DispatchesT, DispatchArray >;
 
 		template< template< typename ValueT > typename WrapperT >
 		struct ConfigT
@@ -194,6 +218,27 @@ namespace crg
 			}
 			/**
 			*\param[in] config
+			*	The dispatches list, recorded one after the other with the same pipeline, without barriers between them.
+			*/
+			auto & dispatches( DispatchArray config )
+			{
+				m_getDispatches = GetDispatchesCallback{ [config]()
+					{
+						return config;
+					} };
+				return *this;
+			}
+			/**
+			*\param[in] config
+			*	The callback to retrieve the dispatches list, called when the pass is recorded.
+			*/
+			auto & getDispatches( GetDispatchesCallback config )
+			{
+				m_getDispatches = std::move( config );
+				return *this;
+			}
+			/**
+			*\param[in] config
 			*	The buffer used during indirect compute.
 			*/
 			auto & indirectBuffer( IndirectBuffer config )
@@ -234,6 +279,7 @@ namespace crg
 			WrapperT< GetGroupCountCallback > m_getGroupCountY{};
 			WrapperT< GetGroupCountCallback > m_getGroupCountZ{};
 			WrapperT< IndirectBuffer > m_indirectBuffer{};
+			WrapperT< GetDispatchesCallback > m_getDispatches{};
 		};
 
 		template<>
@@ -252,6 +298,7 @@ namespace crg
 			std::optional< GetGroupCountCallback > getGroupCountY{};
 			std::optional< GetGroupCountCallback > getGroupCountZ{};
 			RawTypeT< IndirectBuffer > indirectBuffer{ defaultV< IndirectBuffer > };
+			std::optional< GetDispatchesCallback > getDispatches{};
 		};
 
 		using Config = ConfigT< std::optional >;
@@ -305,6 +352,8 @@ namespace crg
 			, VkCommandBuffer commandBuffer
 			, uint32_t index );
 		void doCreatePipeline( uint32_t index );
+		void doRecordDispatches( RecordContext & context
+			, VkCommandBuffer commandBuffer )const;
 
 	private:
 		cp::ConfigData m_cpConfig;
@@ -0,0 +1,44 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#pragma once
+
+#include "RenderGraph/FrameGraphPrerequisites.hpp"
+
+namespace crg
+{
+	/**
+	*\brief
+	*	A region copied by a copy pass, from one of its attachments to another one.
+	*\remarks
+	*	The subresource layers of the region are taken from the attachments' views.
+	*	The regions sharing the same source and destination resources are recorded with a single call.
+	*	The copy passes throw at construction if an index is outside of their attachments.
+	*/
+	template< typename RegionT >
+	struct CopyRegionT
+	{
+		/**
+		*\brief
+		*	The index of the source attachment, in the pass' images or buffers.
+		*/
+		uint32_t src;
+		/**
+		*\brief
+		*	The index of the destination attachment, in the pass' images or buffers.
+		*/
+		uint32_t dst;
+		RegionT region;
+	};
+
+	using BufferCopyRegion = CopyRegionT< VkBufferCopy >;
+	using BufferImageCopyRegion = CopyRegionT< VkBufferImageCopy >;
+	using ImageBlitRegion = CopyRegionT< VkImageBlit >;
+	using ImageCopyRegion = CopyRegionT< VkImageCopy >;
+
+	using BufferCopyRegionArray = std::vector< BufferCopyRegion >;
+	using BufferImageCopyRegionArray = std::vector< BufferImageCopyRegion >;
+	using ImageBlitRegionArray = std::vector< ImageBlitRegion >;
+	using ImageCopyRegionArray = std::vector< ImageCopyRegion >;
+}
@@ -7,6 +7,40 @@ See LICENSE file in root folder.
 
 namespace crg
 {
+	namespace gm
+	{
+		struct Config
+		{
+			/**
+			*\param[in] value
+			*	\p true to generate the mip levels of every image attachment of the pass, instead of the first one only.
+			*/
+			auto & allImages( bool value = true )
+			{
+				m_allImages = value;
+				return *this;
+			}
+			/**
+			*\param[in] value
+			*	\p true to blit all the layers of a level at once, instead of one chain per layer.
+			*/
+			auto & batchLayers( bool value = true )
+			{
+				m_batchLayers = value;
+				return *this;
+			}
+
+			bool m_allImages{};
+			bool m_batchLayers{};
+		};
+	}
+	/**
+	*\brief
+	*	Generates the mip levels of the first image attachment of the pass, from its first level.
+	*\remarks
+	*	When configured so, the mip levels of every image attachment are generated,
+	*	and the chains of the images (or of their layers) are interleaved level by level.
+	*/
 	class GenerateMipmaps
 		: public RunnablePass
 	{
@@ -18,6 +52,14 @@ namespace crg
 			, ru::Config ruConfig = {}
 			, GetPassIndexCallback passIndex = GetPassIndexCallback( [](){ return 0u; } )
 			, IsEnabledCallback isEnabled = IsEnabledCallback( [](){ return true; } ) );
+		CRG_API GenerateMipmaps( FramePass const & pass
+			, GraphContext & context
+			, RunnableGraph & graph
+			, gm::Config config
+			, VkImageLayout outputLayout = VK_IMAGE_LAYOUT_UNDEFINED
+			, ru::Config ruConfig = {}
+			, GetPassIndexCallback passIndex = GetPassIndexCallback( [](){ return 0u; } )
+			, IsEnabledCallback isEnabled = IsEnabledCallback( [](){ return true; } ) );
 
 	private:
 		void doRecordInto( RecordContext & context
@@ -25,6 +67,7 @@ namespace crg
 			, uint32_t index );
 
 	private:
+		gm::Config m_config;
 		LayoutState m_outputLayout;
 	};
 }
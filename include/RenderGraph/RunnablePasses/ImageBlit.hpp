@@ -4,9 +4,14 @@ See LICENSE file in root folder.
 #pragma once
 
 #include "RenderGraph/RunnablePass.hpp"
+#include "RenderGraph/RunnablePasses/CopyRegion.hpp"
 
 namespace crg
 {
+	/**
+	*\brief
+	*	Blits the pass' first image into its second one.
+	*/
 	class ImageBlit
 		: public RunnablePass
 	{
@@ -22,6 +27,20 @@ namespace crg
 			, ru::Config ruConfig = {}
 			, GetPassIndexCallback passIndex = GetPassIndexCallback( [](){ return 0u; } )
 			, IsEnabledCallback isEnabled = IsEnabledCallback( [](){ return true; } ) );
+		/**
+		*\brief
+		*	Blits the given regions between the pass' images.
+		*\remarks
+		*	The regions sharing the same source and destination images are recorded as one multi-region blit.
+		*/
+		CRG_API ImageBlit( FramePass const & pass
+			, GraphContext & context
+			, RunnableGraph & graph
+			, ImageBlitRegionArray regions
+			, VkFilter filter
+			, ru::Config ruConfig = {}
+			, GetPassIndexCallback passIndex = GetPassIndexCallback( [](){ return 0u; } )
+			, IsEnabledCallback isEnabled = IsEnabledCallback( [](){ return true; } ) );
 
 	private:
 		void doRecordInto( RecordContext & context
@@ -29,10 +48,7 @@ namespace crg
 			, uint32_t index );
 
 	private:
-		VkOffset3D m_srcOffset;
-		VkExtent3D m_srcSize;
-		VkOffset3D m_dstOffset;
-		VkExtent3D m_dstSize;
+		ImageBlitRegionArray m_regions;
 		VkFilter m_filter;
 	};
 }
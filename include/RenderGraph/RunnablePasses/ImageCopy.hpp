@@ -4,9 +4,16 @@ See LICENSE file in root folder.
 #pragma once
 
 #include "RenderGraph/RunnablePass.hpp"
+#include "RenderGraph/RunnablePasses/CopyRegion.hpp"
 
 namespace crg
 {
+	/**
+	*\brief
+	*	Copies the pass' images, taken as (source, destination) pairs.
+	*\remarks
+	*	The pairs sharing the same source and destination images are recorded as one multi-region copy.
+	*/
 	class ImageCopy
 		: public RunnablePass
 	{
@@ -26,6 +33,18 @@ namespace crg
 			, ru::Config ruConfig = {}
 			, GetPassIndexCallback passIndex = GetPassIndexCallback( [](){ return 0u; } )
 			, IsEnabledCallback isEnabled = IsEnabledCallback( [](){ return true; } ) );
+		/**
+		*\brief
+		*	Copies the given regions between the pass' images, instead of the images pairs.
+		*/
+		CRG_API ImageCopy( FramePass const & pass
+			, GraphContext & context
+			, RunnableGraph & graph
+			, ImageCopyRegionArray regions
+			, VkImageLayout finalOutputLayout = VK_IMAGE_LAYOUT_UNDEFINED
+			, ru::Config ruConfig = {}
+			, GetPassIndexCallback passIndex = GetPassIndexCallback( [](){ return 0u; } )
+			, IsEnabledCallback isEnabled = IsEnabledCallback( [](){ return true; } ) );
 
 	private:
 		void doRecordInto( RecordContext & context
@@ -33,7 +52,7 @@ namespace crg
 			, uint32_t index );
 
 	private:
-		VkExtent3D m_copySize;
+		ImageCopyRegionArray m_regions;
 		VkImageLayout m_finalOutputLayout;
 	};
 }
@@ -0,0 +1,74 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#pragma once
+
+#include "RenderGraph/RunnablePass.hpp"
+
+namespace crg
+{
+	/**
+	*\brief
+	*	Copies the pass' source image into a host visible ring, and gives the data back to the host once the GPU is done with it.
+	*\remarks
+	*	The ring holds one segment per frame in flight, and the callback receives the mapped content
+	*	of each segment once the graph fence has signaled for the frame which wrote it,
+	*	without ever waiting for the queue to be idle.
+	*	The callback is only called for the frames where the pass was recorded and enabled,
+	*	so the frames where it is disabled (or culled) produce no data.
+	*	The pass has no output attachment, it should be flagged with FramePass::setSideEffects to avoid being culled.
+	*/
+	class ImageReadback
+		: public RunnablePass
+	{
+	public:
+		/**
+		*\param[in] data
+		*	The mapped readback data, only valid during the call.
+		*\param[in] size
+		*	The data size.
+		*/
+		using ReadbackCallback = std::function< void( void const * data, VkDeviceSize size ) >;
+
+	public:
+		/**
+		*\param[in] frameSize
+		*	The bytes size of the copied region.
+		*	An exception is thrown if the copy of \p copySize texels from the source image doesn't fit in it.
+		*\param[in] callback
+		*	The callback receiving the read back data, once per frame where the pass was recorded and enabled.
+		*\param[in] frameCount
+		*	The number of frames in flight (ring segments count).
+		*/
+		CRG_API ImageReadback( FramePass const & pass
+			, GraphContext & context
+			, RunnableGraph & graph
+			, VkOffset3D copyOffset
+			, VkExtent3D copySize
+			, VkDeviceSize frameSize
+			, ReadbackCallback callback
+			, uint32_t frameCount = 2u
+			, ru::Config ruConfig = {}
+			, GetPassIndexCallback passIndex = GetPassIndexCallback( [](){ return 0u; } )
+			, IsEnabledCallback isEnabled = IsEnabledCallback( [](){ return true; } ) );
+		CRG_API ~ImageReadback()noexcept override;
+
+	private:
+		void doRecordInto( RecordContext & context
+			, VkCommandBuffer commandBuffer
+			, uint32_t index );
+		void doDeliver();
+
+	private:
+		VkOffset3D m_copyOffset;
+		VkExtent3D m_copySize;
+		VkDeviceSize m_frameSize;
+		ReadbackCallback m_callback;
+		VkBuffer m_buffer{};
+		VkDeviceMemory m_memory{};
+		uint8_t * m_data{};
+		std::vector< bool > m_pending;
+		uint32_t m_current{};
+	};
+}
@@ -4,9 +4,14 @@ See LICENSE file in root folder.
 #pragma once
 
 #include "RenderGraph/RunnablePass.hpp"
+#include "RenderGraph/RunnablePasses/CopyRegion.hpp"
 
 namespace crg
 {
+	/**
+	*\brief
+	*	Copies the pass' last image into its first buffer.
+	*/
 	class ImageToBufferCopy
 		: public RunnablePass
 	{
@@ -19,6 +24,20 @@ namespace crg
 			, ru::Config ruConfig = {}
 			, GetPassIndexCallback passIndex = GetPassIndexCallback( [](){ return 0u; } )
 			, IsEnabledCallback isEnabled = IsEnabledCallback( [](){ return true; } ) );
+		/**
+		*\brief
+		*	Copies the given regions from the pass' images to its buffers.
+		*\remarks
+		*	The regions buffer offsets are used as is.
+		*	The regions sharing the same image and buffer are recorded as one multi-region copy.
+		*/
+		CRG_API ImageToBufferCopy( FramePass const & pass
+			, GraphContext & context
+			, RunnableGraph & graph
+			, BufferImageCopyRegionArray regions
+			, ru::Config ruConfig = {}
+			, GetPassIndexCallback passIndex = GetPassIndexCallback( [](){ return 0u; } )
+			, IsEnabledCallback isEnabled = IsEnabledCallback( [](){ return true; } ) );
 
 	private:
 		void doRecordInto( RecordContext & context
@@ -26,7 +45,6 @@ namespace crg
 			, uint32_t index );
 
 	private:
-		VkOffset3D m_copyOffset;
-		VkExtent3D m_copySize;
+		BufferImageCopyRegionArray m_regions;
 	};
 }
@@ -27,6 +27,17 @@ namespace crg
 		}
 	};
 	
+	template<>
+	struct DefaultValueGetterT< VkPipelineShaderStageCreateInfoArray >
+	{
+		static inline VkPipelineShaderStageCreateInfoArray const value{};
+
+		static VkPipelineShaderStageCreateInfoArray get()
+		{
+			return value;
+		}
+	};
+
 	template<>
 	struct DefaultValueGetterT< std::vector< VkDescriptorSetLayout > >
 	{
@@ -134,11 +145,17 @@ namespace crg
 			explicit ConfigT( WrapperT< std::vector< VkPipelineShaderStageCreateInfoArray > > programs = {}
 				, WrapperT< ProgramCreator > programCreator = {}
 				, WrapperT< std::vector< VkDescriptorSetLayout > > layouts = {}
-				, WrapperT< VkPushConstantRangeArray > pushConstants = {} )
+				, WrapperT< VkPushConstantRangeArray > pushConstants = {}
+				, WrapperT< bool > asyncCompile = {}
+				, WrapperT< VkPipelineShaderStageCreateInfoArray > fallbackProgram = {}
+				, WrapperT< void const * > pushConstantsData = {} )
 				: m_programs{ std::move( programs ) }
 				, m_programCreator{ std::move( programCreator ) }
 				, m_layouts{ std::move( layouts ) }
 				, m_pushConstants{ std::move( pushConstants ) }
+				, m_asyncCompile{ std::move( asyncCompile ) }
+				, m_fallbackProgram{ std::move( fallbackProgram ) }
+				, m_pushConstantsData{ std::move( pushConstantsData ) }
 			{
 			}
 			/**
@@ -204,11 +221,48 @@ namespace crg
 				m_pushConstants = std::move( config );
 				return *this;
 			}
+			/**
+			*\param[in] config
+			*	The host data block holding the push constants values, each declared range being read at its offset.
+			*\remarks
+			*	The values are pushed when the pass is recorded, so the pass is recorded again at each run
+			*	and its command buffers are never pre-recorded (see RunnableGraph::setMaxVariants).
+			*	For parameters changing at each frame in a pre-recorded graph, use FrameGraph::createFrameDataBuffer instead.
+			*	The block must outlive the pass.
+			*/
+			auto & pushConstantsData( void const * config )
+			{
+				m_pushConstantsData = config;
+				return *this;
+			}
+			/**
+			*\param[in] config
+			*	\p true to compile the pipelines on a worker thread.
+			*\remarks
+			*	Until its pipeline is ready, the pass records nothing, or uses the fallback program, if any.
+			*/
+			auto & asyncCompile( bool config )
+			{
+				m_asyncCompile = std::move( config );
+				return *this;
+			}
+			/**
+			*\param[in] config
+			*	The program used while the pipeline is being compiled asynchronously.
+			*/
+			auto & fallbackProgram( VkPipelineShaderStageCreateInfoArray config )
+			{
+				m_fallbackProgram = std::move( config );
+				return *this;
+			}
 
 			WrapperT< std::vector< VkPipelineShaderStageCreateInfoArray > > m_programs;
 			WrapperT< ProgramCreator > m_programCreator;
 			WrapperT< std::vector< VkDescriptorSetLayout > > m_layouts;
 			WrapperT< VkPushConstantRangeArray > m_pushConstants;
+			WrapperT< bool > m_asyncCompile;
+			WrapperT< VkPipelineShaderStageCreateInfoArray > m_fallbackProgram;
+			WrapperT< void const * > m_pushConstantsData;
 		};
 
 		using Config = ConfigT< std::optional >;
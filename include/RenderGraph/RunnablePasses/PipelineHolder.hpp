@@ -5,6 +5,8 @@ See LICENSE file in root folder.
 
 #include "RenderGraph/RunnablePasses/PipelineConfig.hpp"
 
+#include <future>
+
 namespace crg
 {
 	class PipelineHolder
@@ -36,12 +38,42 @@ namespace crg
 			, VkComputePipelineCreateInfo const & createInfo );
 		CRG_API void createPipeline( uint32_t index
 			, VkComputePipelineCreateInfo const & createInfo );
-		CRG_API void recordInto( RecordContext & context
+		/**
+		*\brief
+		*	Binds the pipeline and descriptor set for given index.
+		*\return
+		*	\p false if no pipeline could be bound (asynchronous compilation still pending, and no fallback program).
+		*/
+		CRG_API bool recordInto( RecordContext & context
 			, VkCommandBuffer commandBuffer
 			, uint32_t index );
+		/**
+		*\brief
+		*	Destroys the pipelines of given index, in all pipeline sets, and replaces their program.
+		*/
 		CRG_API void resetPipeline( VkPipelineShaderStageCreateInfoArray config
 			, uint32_t index );
+		/**
+		*\brief
+		*	Selects the pipeline set used by the next calls.
+		*\remarks
+		*	Each set holds one pipeline per program, the users create one set per pipeline states
+		*	(render pass, subpass, formats...), so switching between them doesn't recreate any pipeline.
+		*/
+		CRG_API void selectPipelineSet( uint32_t set );
 		CRG_API void createDescriptorSet( uint32_t index );
+		/**
+		*\brief
+		*	Retrieves the asynchronously compiled pipeline, if it is available.
+		*\return
+		*	\p true if the pipeline for given index is ready to use.
+		*/
+		CRG_API bool isPipelineReady( uint32_t index );
+		/**
+		*\return
+		*	\p true if the pipeline for given index has been created, or is being compiled.
+		*/
+		CRG_API bool hasPipeline( uint32_t index )const;
 
 		VkDescriptorSet getDescriptorSet( uint32_t index )
 		{
@@ -69,6 +101,13 @@ namespace crg
 		void doCreateDescriptorSetLayout();
 		void doCreatePipelineLayout();
 		void doCreateDescriptorPool();
+		uint32_t doGetPipelineIndex( uint32_t index )const;
+		template< typename CreateInfoT >
+		void doCreatePipeline( uint32_t index
+			, std::string const & name
+			, CreateInfoT const & createInfo );
+		void doRetrievePipeline( uint32_t index );
+		void doWaitPendingPipelines();
 
 	protected:
 		FramePass const & m_pass;
@@ -90,7 +129,16 @@ namespace crg
 		std::vector< DescriptorSet > m_descriptorSets;
 
 	private:
+		struct PendingPipeline
+		{
+			std::string name;
+			std::future< VkPipeline > pipeline;
+		};
+
 		std::vector< VkPipeline > m_pipelines{};
+		std::vector< VkPipeline > m_fallbackPipelines{};
+		std::vector< PendingPipeline > m_pendingPipelines{};
+		uint32_t m_currentSet{};
 	};
 
 	template< typename BuilderT >
@@ -133,6 +181,24 @@ namespace crg
 			m_baseConfig.pushConstants( std::move( config ) );
 			return static_cast< BuilderT & >( *this );
 		}
+		/**
+		*\param[in] config
+		*	\p true to compile the pipelines on a worker thread.
+		*/
+		BuilderT & asyncCompile( bool config )
+		{
+			m_baseConfig.asyncCompile( config );
+			return static_cast< BuilderT & >( *this );
+		}
+		/**
+		*\param[in] config
+		*	The program used while the pipeline is being compiled asynchronously.
+		*/
+		BuilderT & fallbackProgram( VkPipelineShaderStageCreateInfoArray config )
+		{
+			m_baseConfig.fallbackProgram( std::move( config ) );
+			return static_cast< BuilderT & >( *this );
+		}
 
 	protected:
 		pp::Config m_baseConfig;
@@ -178,6 +178,18 @@ namespace crg
 			}
 			/**
 			*\param[in] config
+			*	The GPU written draw count, turning the indirect draw into a multi-draw indirect.
+			*\remarks
+			*	Requires vkCmdDrawIndexedIndirectCount (Vulkan 1.2).
+			*	The indirect and count buffers should be declared with FramePass::addIndirectBuffer.
+			*/
+			auto & indirectCountBuffer( IndirectCountBuffer config )
+			{
+				m_indirectCountBuffer = std::move( config );
+				return *this;
+			}
+			/**
+			*\param[in] config
 			*	The primitive count retrieval callback.
 			*/
 			auto & getPrimitiveCount( GetPrimitiveCountCallback config )
@@ -228,6 +240,7 @@ namespace crg
 			WrapperT< VertexBuffer > m_vertexBuffer{};
 			WrapperT< IndexBuffer > m_indexBuffer{};
 			WrapperT< IndirectBuffer > m_indirectBuffer{};
+			WrapperT< IndirectCountBuffer > m_indirectCountBuffer{};
 		};
 
 		template<>
@@ -246,6 +259,7 @@ namespace crg
 			RawTypeT< VertexBuffer > vertexBuffer{};
 			RawTypeT< IndexBuffer > indexBuffer{};
 			RawTypeT< IndirectBuffer > indirectBuffer{ defaultV< IndirectBuffer > };
+			RawTypeT< IndirectCountBuffer > indirectCountBuffer{ defaultV< IndirectCountBuffer > };
 		};
 
 		using Config = ConfigT< std::optional >;
@@ -73,6 +73,16 @@ namespace crg
 			return m_holder.getRenderPass( passIndex );
 		}
 
+		bool isDynamicRendering()const
+		{
+			return m_holder.isDynamicRendering();
+		}
+
+		RenderingFormats const & getRenderingFormats( uint32_t passIndex )const
+		{
+			return m_holder.getRenderingFormats( passIndex );
+		}
+
 	protected:
 		VkPipelineColorBlendStateCreateInfo doCreateBlendState()
 		{
@@ -16,6 +16,15 @@ namespace crg
 			LayoutState input;
 			LayoutState output;
 		};
+		/**
+		*\brief
+		*	A pass recorded as a subpass of a render pass begun by a previous pass.
+		*/
+		struct Subpass
+		{
+			RunnablePass * runnable;
+			RenderPassHolder * holder;
+		};
 
 	public:
 		RenderPassHolder( RenderPassHolder const & )noexcept = delete;
@@ -41,10 +50,32 @@ namespace crg
 			, VkCommandBuffer commandBuffer );
 		CRG_API VkPipelineColorBlendStateCreateInfo createBlendState();
 		CRG_API VkFramebuffer getFramebuffer( uint32_t index )const;
+		/**
+		*\brief
+		*	Records the given passes as the subpasses of a single render pass, begun by this holder.
+		*\remarks
+		*	The passes are recorded consecutively, this holder's pass being the first one.
+		*	They are merged only when all of them are enabled, each one records its own render pass otherwise.
+		*\param[in] subpasses
+		*	The passes, in execution order.
+		*/
+		CRG_API void mergeSubpasses( std::vector< Subpass > subpasses );
 
 		VkRenderPass getRenderPass( uint32_t index )const
 		{
-			return m_passes[index].renderPass;
+			return m_mergedRenderPass
+				? m_mergedRenderPass
+				: doGetPassData( index ).renderPass;
+		}
+		/**
+		*\return
+		*	The index of the subpass the pass is recorded in, in the render pass returned by getRenderPass.
+		*/
+		uint32_t getSubpass()const
+		{
+			return m_mergedRenderPass
+				? m_subpass
+				: 0u;
 		}
 
 		VkExtent2D const & getRenderSize()const
@@ -54,52 +85,123 @@ namespace crg
 
 		VkRect2D const & getRenderArea( uint32_t index )const
 		{
-			return m_passes[index].renderArea;
+			return doGetPassData( index ).renderArea;
 		}
 
 		std::vector< VkClearValue > const & getClearValues( uint32_t index )const
 		{
-			return m_passes[index].clearValues;
+			return doGetPassData( index ).clearValues;
 		}
 
 		VkPipelineColorBlendAttachmentStateArray const & getBlendAttachs()const
 		{
 			return m_blendAttachs;
 		}
+		/**
+		*\return
+		*	\p true if the pass is rendered using VK_KHR_dynamic_rendering, in which case no VkRenderPass nor VkFramebuffer is created.
+		*/
+		bool isDynamicRendering()const
+		{
+			return m_dynamicRendering;
+		}
+		/**
+		*\return
+		*	The attachments formats, to create pipelines when rendering without VkRenderPass.
+		*/
+		RenderingFormats const & getRenderingFormats( uint32_t index )const
+		{
+			return doGetPassData( index ).formats;
+		}
 
 	private:
+		struct PassData;
+
+		PassData & doGetPassData( uint32_t index )
+		{
+			auto & pass = m_passes[index];
+			return pass.states[pass.current];
+		}
+
+		PassData const & doGetPassData( uint32_t index )const
+		{
+			auto & pass = m_passes[index];
+			return pass.states[pass.current];
+		}
+
+		PassData const & doGetMergedData()const
+		{
+			return m_merged.states[m_merged.current];
+		}
+
 		void doCreateRenderPass( RecordContext & context
 			, crg::RunnablePass const & runnable
 			, PipelineState const & previousState
 			, PipelineState const & nextState
 			, uint32_t passIndex );
 		void doInitialiseRenderArea( uint32_t index );
-		VkFramebuffer doCreateFramebuffer( uint32_t passIndex )const;
+		bool doIsMergeable()const;
+		VkRenderPass doInitialiseMerged( RecordContext & context );
+		void doCreateMergedRenderPass( RecordContext & context
+			, PipelineState const & previousState
+			, PipelineState const & nextState );
+		void doBeginMerged( RecordContext & context
+			, VkCommandBuffer commandBuffer
+			, VkSubpassContents subpassContents );
+		VkFramebuffer doGetFramebuffer( PassData const & data
+			, uint32_t index )const;
+		void doBeginRendering( RecordContext & context
+			, VkCommandBuffer commandBuffer );
+		void doEndRendering( RecordContext & context
+			, VkCommandBuffer commandBuffer );
 
 	private:
 		struct PassData
 		{
 			VkRenderPass renderPass{};
-			mutable VkFramebuffer frameBuffer{};
 			VkRect2D renderArea{};
 			std::vector< Attachment const * > attachments;
 			std::vector< VkClearValue > clearValues;
 			std::vector< Entry > attaches;
+			VkAttachmentDescriptionArray descriptions;
+			std::vector< VkImageLayout > layouts;
+			RenderingFormats formats;
 			PipelineState previousState;
 			PipelineState nextState;
+			bool initialised{};
 
-			void cleanup( crg::GraphContext & context )noexcept;
+			void cleanup( ContextResourcesCache & resources )noexcept;
+		};
+		/**
+		*\brief
+		*	The render passes created for a pass index, one for each encountered combination of layouts and pipeline states.
+		*\remarks
+		*	They are kept until the holder is destroyed, since pre-recorded command buffers may still use any of them.
+		*/
+		struct PassStates
+		{
+			std::vector< PassData > states;
+			size_t current{};
 		};
 
 		FramePass const & m_pass;
 		GraphContext & m_context;
 		RunnableGraph & m_graph;
 		VkExtent2D m_size;
-		std::vector< PassData > m_passes;
+		std::vector< PassStates > m_passes;
 		PassData const * m_currentPass{};
 		VkPipelineColorBlendAttachmentStateArray m_blendAttachs;
 		uint32_t m_layers{};
 		uint32_t m_index{};
 		uint32_t m_count{ 1u };
+		bool m_dynamicRendering{};
+		// The holder of the first pass of the merged passes, if any.
+		RenderPassHolder * m_leader{};
+		uint32_t m_subpass{};
+		VkRenderPass m_mergedRenderPass{};
+		// The merged passes, on their first pass holder.
+		std::vector< Subpass > m_subpasses;
+		PassStates m_merged;
+		bool m_merging{};
 	};
 }
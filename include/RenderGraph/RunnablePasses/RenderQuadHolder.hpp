@@ -21,14 +21,28 @@ namespace crg
 		CRG_API void initialise( VkExtent2D const & renderSize
 			, VkRenderPass renderPass
 			, VkPipelineColorBlendStateCreateInfo blendState
-			, uint32_t index );
+			, uint32_t index
+			, RenderingFormats const & formats = {}
+			, uint32_t subpass = 0u );
+		/**
+		*\brief
+		*	Selects the pipeline states matching given render pass, for given pass index.
+		*\remarks
+		*	The pipelines created for the previously used render passes are kept.
+		*/
 		CRG_API void resetRenderPass( VkExtent2D const & renderSize
 			, VkRenderPass renderPass
 			, VkPipelineColorBlendStateCreateInfo blendState
-			, uint32_t index );
+			, uint32_t index
+			, RenderingFormats const & formats = {}
+			, uint32_t subpass = 0u );
 		CRG_API void resetPipeline( VkPipelineShaderStageCreateInfoArray config
 			, uint32_t index );
-		CRG_API void record( RecordContext & context
+		/**
+		*\return
+		*	\p false if nothing was recorded, because the pipeline is not ready yet.
+		*/
+		CRG_API bool record( RecordContext & context
 			, VkCommandBuffer commandBuffer
 			, uint32_t index );
 		CRG_API void end( RecordContext & context
@@ -36,6 +50,14 @@ namespace crg
 			, uint32_t index )const;
 		CRG_API uint32_t getPassIndex()const;
 		CRG_API bool isEnabled()const;
+		/**
+		*\return
+		*	\p true if the pass records commands after its render pass (see the end configuration).
+		*/
+		bool hasEnd()const
+		{
+			return m_hasEnd;
+		}
 
 		VkPipelineVertexInputStateCreateInfo const & getInputState()const
 		{
@@ -53,29 +75,45 @@ namespace crg
 		}
 
 	private:
-		void doPreparePipelineStates( VkExtent2D const & renderSize
+		uint32_t doPreparePipelineStates( VkExtent2D const & renderSize
 			, VkRenderPass renderPass
-			, VkPipelineColorBlendStateCreateInfo blendState );
+			, VkPipelineColorBlendStateCreateInfo blendState
+			, RenderingFormats const & formats
+			, uint32_t subpass );
 		void doCreatePipeline( uint32_t passIndex );
 		VkPipelineViewportStateCreateInfo doCreateViewportState( VkExtent2D const & renderSize
 			, VkViewport & viewport
 			, VkRect2D & scissor )const;
 
+	private:
+		struct PipelineStates
+		{
+			VkExtent2D renderSize{};
+			VkRenderPass renderPass{};
+			uint32_t subpass{};
+			RenderingFormats formats{};
+#if VK_KHR_dynamic_rendering
+			VkPipelineRenderingCreateInfoKHR renderingInfo{};
+#endif
+			VkViewport viewport{};
+			VkRect2D scissor{};
+			VkPipelineViewportStateCreateInfo vpState{};
+			VkPipelineColorBlendStateCreateInfo blendState{};
+			std::vector< VkPipelineColorBlendAttachmentState > blendAttachs{};
+		};
+
 	private:
 		rq::ConfigData m_config;
 		RunnableGraph & m_graph;
 		PipelineHolder m_pipeline;
 		bool m_useTexCoord{ true };
+		bool m_hasEnd{};
 		VertexBuffer const * m_vertexBuffer{};
-		VkRenderPass m_renderPass{};
-		VkExtent2D m_renderSize{};
-		VkViewport m_viewport{};
-		VkRect2D m_scissor{};
-		VkPipelineViewportStateCreateInfo m_vpState{};
+		// One pipeline set per encountered states, each pass index uses one of them.
+		std::vector< std::unique_ptr< PipelineStates > > m_states{};
+		std::vector< uint32_t > m_passStates{};
 		VkPipelineInputAssemblyStateCreateInfo m_iaState{};
 		VkPipelineMultisampleStateCreateInfo m_msState{};
 		VkPipelineRasterizationStateCreateInfo m_rsState{};
-		VkPipelineColorBlendStateCreateInfo m_blendState{};
-		std::vector< VkPipelineColorBlendAttachmentState > m_blendAttachs{};
 	};
 }
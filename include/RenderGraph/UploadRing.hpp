@@ -0,0 +1,125 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#pragma once
+
+#include "FrameGraphPrerequisites.hpp"
+
+#include <unordered_map>
+
+namespace crg
+{
+	/**
+	*\brief
+	*	Persistently mapped staging buffer, split in one segment per frame in flight.
+	*\remarks
+	*	The host writes its data through upload(), the copy passes built on this ring
+	*	(BufferCopy, BufferToImageCopy) consume it when they are recorded.
+	*	Recording closes the current segment and moves on to the next one.
+	*	A closed segment is reclaimed, when the host writes in it again, by waiting the fences
+	*	of all the graphs which recorded a copy from it.
+	*	Hence the runnable graphs consuming the ring must outlive it.
+	*/
+	class UploadRing
+	{
+	public:
+		struct Upload
+		{
+			VkDeviceSize offset;
+			VkDeviceSize size;
+		};
+
+	public:
+		/**
+		*\param[in] context
+		*	The context used to create the buffer.
+		*\param[in] name
+		*	The ring name.
+		*\param[in] frameSize
+		*	The staging size available for one frame.
+		*\param[in] frameCount
+		*	The number of frames in flight (segments count).
+		*/
+		CRG_API UploadRing( GraphContext & context
+			, std::string name
+			, VkDeviceSize frameSize
+			, uint32_t frameCount = 2u );
+		CRG_API ~UploadRing()noexcept;
+
+		UploadRing( UploadRing const & ) = delete;
+		UploadRing & operator=( UploadRing const & ) = delete;
+		UploadRing( UploadRing && rhs )noexcept = delete;
+		UploadRing & operator=( UploadRing && rhs )noexcept = delete;
+		/**
+		*\brief
+		*	Writes data for given pass in the current frame segment.
+		*\remarks
+		*	A previous, not yet recorded, upload for the same pass is replaced.
+		*\param[in] pass
+		*	The copy pass which will consume the data.
+		*\param[in] data, size
+		*	The data to upload.
+		*\param[in] alignment
+		*	The required alignment of the data inside the ring buffer.
+		*\return
+		*	\p false if the frame segment has not enough space left.
+		*/
+		CRG_API bool upload( FramePass const & pass
+			, void const * data
+			, VkDeviceSize size
+			, VkDeviceSize alignment = 16u );
+		/**
+		*\brief
+		*	Retrieves the pending upload for given pass, and closes the current segment.
+		*\remarks
+		*	Meant to be called by the copy passes, while recording.
+		*\param[in] pass
+		*	The copy pass.
+		*\param[in] fence
+		*	The fence which will be signaled once the recorded commands are executed.
+		*\return
+		*	\p false if the pass has no pending upload.
+		*/
+		CRG_API bool takeUpload( FramePass const & pass
+			, Fence & fence
+			, Upload & result );
+
+		Buffer const & getBuffer()const noexcept
+		{
+			return m_buffer;
+		}
+
+		VkDeviceSize getFrameSize()const noexcept
+		{
+			return m_frameSize;
+		}
+
+		uint32_t getFrameCount()const noexcept
+		{
+			return uint32_t( m_segments.size() );
+		}
+
+	private:
+		struct Segment
+		{
+			VkDeviceSize head{};
+			std::vector< Fence * > fences;
+			bool closed{};
+		};
+
+		void doReclaim( Segment & segment );
+
+	private:
+		GraphContext & m_context;
+		std::string m_name;
+		VkDeviceSize m_frameSize;
+		Buffer m_buffer;
+		VkDeviceMemory m_memory{};
+		uint8_t * m_data{};
+		std::vector< Segment > m_segments;
+		uint32_t m_current{};
+		bool m_dirty{};
+		std::unordered_map< FramePass const *, Upload > m_pending;
+	};
+}
@@ -48,7 +48,8 @@ namespace crg
 
 	bool operator==( Buffer const & lhs, Buffer const & rhs )
 	{
-		return lhs.m_buffers == rhs.m_buffers;
+		return lhs.m_handle == rhs.m_handle
+			&& lhs.m_buffers == rhs.m_buffers;
 	}
 
 	AttachmentTransitions mergeIdenticalTransitions( AttachmentTransitions transitions )
@@ -12,6 +12,22 @@ namespace crg::builder
 {
 	using FramePassSet = std::set< FramePass const * >;
 
+	inline bool isInRange( uint32_t value
+		, uint32_t left
+		, uint32_t count )noexcept
+	{
+		return value >= left && value < left + count;
+	}
+
+	inline bool areIntersecting( uint32_t lhsLBound
+		, uint32_t lhsCount
+		, uint32_t rhsLBound
+		, uint32_t rhsCount )noexcept
+	{
+		return isInRange( lhsLBound, rhsLBound, rhsCount )
+			|| isInRange( rhsLBound, lhsLBound, lhsCount );
+	}
+
 	template< typename TypeT >
 	void filter( std::vector< TypeT > const & inputs
 		, std::function< bool( TypeT const & ) > filterFunc
@@ -9,6 +9,7 @@ See LICENSE file in root folder.
 
 #include <numeric>
 #include <array>
+#include <set>
 #include <string>
 #include <type_traits>
 
@@ -249,6 +250,29 @@ namespace crg::dot
 		static std::string_view constexpr bufColour{ "#458b00" };
 		static std::string_view constexpr extColour{ "#ff7f00" };
 		static std::string_view constexpr passColour{ "#00007f" };
+		static std::string_view constexpr mergeColour{ "#007f7f" };
+		static std::string_view constexpr lifeColour{ "#7f7f7f" };
+
+		using PassPairSet = std::set< std::pair< FramePass const *, FramePass const * > >;
+
+		static PassPairSet listMerges( RunnableGraph const & value
+			, Config const & config )
+		{
+			PassPairSet result;
+
+			if ( config.withSubpassMerges )
+			{
+				for ( auto & chain : value.getRenderPassChains() )
+				{
+					for ( size_t i = 1u; i < chain.size(); ++i )
+					{
+						result.emplace( chain[i - 1u], chain[i] );
+					}
+				}
+			}
+
+			return result;
+		}
 
 		struct FramePassGroupStreams
 		{
@@ -450,19 +474,21 @@ namespace crg::dot
 				, FramePassGroupStreams & groups
 				, ConstGraphAdjacentNode node
 				, Config const & config
+				, PassPairSet const & merges
 				, std::set< ConstGraphAdjacentNode > & visited )
 			{
-				DotOutVisitor vis{ streams, groups, config, visited };
+				DotOutVisitor vis{ streams, groups, config, merges, visited };
 				node->accept( &vis );
 			}
 
 			static void submit( DisplayResult & streams
 				, FramePassGroupStreams & groups
 				, ConstGraphAdjacentNode node
-				, Config const & config )
+				, Config const & config
+				, PassPairSet const & merges )
 			{
 				std::set< ConstGraphAdjacentNode > visited;
-				submit( streams, groups, node, config, visited );
+				submit( streams, groups, node, config, merges, visited );
 			}
 
 			static void displayNode( std::ostream & stream
@@ -650,8 +676,32 @@ namespace crg::dot
 				displayEdge( *curstream, name, dstNode, getAttachName( transition.data ), colour, config );
 			}
 
+			template< typename ResourceT >
+			static void displayLifetimes( std::ostream & stream
+				, std::map< ResourceT, ResourceLifetime > const & lifetimes
+				, std::string_view const & kind
+				, FramePassArray const & passes
+				, FramePassGroupStreams & groups
+				, Config const & config )
+			{
+				for ( auto const & [_, lifetime] : lifetimes )
+				{
+					auto first = passes[lifetime.firstPass];
+					auto last = passes[lifetime.lastPass];
+					displayPassNode( first->id, first->getGroupName(), &first->group, passColour, groups, config );
+					displayPassNode( last->id, last->getGroupName(), &last->group, passColour, groups, config );
+					std::string name{ std::string{ kind } + " " + lifetime.name
+						+ "\\nlifetime [" + std::to_string( lifetime.firstPass ) + ", " + std::to_string( lifetime.lastPass ) + "]"
+						+ "\\nsize " + std::to_string( lifetime.size ) };
+					displayNode( stream, name, "note", lifeColour, groups.getNodes(), config );
+					displayEdge( stream, first->getGroupName(), name, "first use", lifeColour, config );
+					displayEdge( stream, name, last->getGroupName(), "last use", lifeColour, config );
+				}
+			}
+
 			static void submit( DisplayResult & streams
 				, AttachmentTransitions const & transitions
+				, ResourceLifetimes const & lifetimes
 				, Config const & config )
 			{
 				FramePassGroupStreams groups{ config };
@@ -680,6 +730,13 @@ namespace crg::dot
 					displayTransitionEdge( trstream, bufColour, transition, groups, config );
 				}
 
+				if ( config.withLifetimes )
+				{
+					displayLifetimes( trstream, lifetimes.images, "Image", lifetimes.passes, groups, config );
+					displayLifetimes( trstream, lifetimes.views, "View", lifetimes.passes, groups, config );
+					displayLifetimes( trstream, lifetimes.buffers, "Buffer", lifetimes.passes, groups, config );
+				}
+
 				groups.write( streams, trstream );
 			}
 
@@ -687,10 +744,12 @@ namespace crg::dot
 			DotOutVisitor( DisplayResult & streams
 				, FramePassGroupStreams & groups
 				, Config const & config
+				, PassPairSet const & merges
 				, std::set< ConstGraphAdjacentNode > & visited )
 				: m_streams{ streams }
 				, m_groups{ groups }
 				, m_config{ config }
+				, m_merges{ merges }
 				, m_visited{ visited }
 			{
 			}
@@ -752,6 +811,12 @@ namespace crg::dot
 					displayEdge( *curstream, lhsName, name, transition.data.name, bufColour, m_config );
 					displayEdge( *curstream, name, rhsName, transition.data.name, bufColour, m_config );
 				}
+
+				if ( auto lhsPass = getFramePass( *lhs ), rhsPass = getFramePass( *rhs );
+					m_merges.end() != m_merges.find( { lhsPass, rhsPass } ) )
+				{
+					displayEdge( *curstream, lhsName, rhsName, "Subpass merge", mergeColour, m_config );
+				}
 			}
 
 			void submit( ConstGraphAdjacentNode node )
@@ -760,6 +825,7 @@ namespace crg::dot
 					, m_groups
 					, node
 					, m_config
+					, m_merges
 					, m_visited );
 			}
 
@@ -771,6 +837,7 @@ namespace crg::dot
 						, m_groups
 						, next
 						, m_config
+						, m_merges
 						, m_visited );
 				}
 
@@ -797,6 +864,7 @@ namespace crg::dot
 			DisplayResult & m_streams;
 			FramePassGroupStreams & m_groups;
 			Config const & m_config;
+			PassPairSet const & m_merges;
 			std::set< GraphNode const * > & m_visited;
 		};
 	}
@@ -806,7 +874,7 @@ namespace crg::dot
 	{
 		DisplayResult result;
 		dotexp::FramePassGroupStreams groups{ config };
-		dotexp::DotOutVisitor::submit( result, groups, value.getGraph(), config );
+		dotexp::DotOutVisitor::submit( result, groups, value.getGraph(), config, dotexp::listMerges( value, config ) );
 		return result;
 	}
 
@@ -814,7 +882,7 @@ namespace crg::dot
 		, Config const & config )
 	{
 		DisplayResult result;
-		dotexp::DotOutVisitor::submit( result, value.getTransitions(), config );
+		dotexp::DotOutVisitor::submit( result, value.getTransitions(), value.getResourceLifetimes(), config );
 		return result;
 	}
 
@@ -151,7 +151,239 @@ namespace crg
 					, lhsInfo.viewType, rhsInfo.viewType
 					, lhsInfo.subresourceRange, rhsInfo.subresourceRange );
 		}
-}
+
+		static void listViews( ImageViewId const & view
+			, ImageViewIdArray & result )
+		{
+			if ( view.data->source.empty() )
+			{
+				result.push_back( view );
+			}
+			else
+			{
+				result.insert( result.end()
+					, view.data->source.begin()
+					, view.data->source.end() );
+			}
+		}
+
+		static ImageViewIdArray listViews( Attachment const & attach )
+		{
+			ImageViewIdArray result;
+
+			for ( uint32_t i = 0u; i < attach.getViewCount(); ++i )
+			{
+				listViews( attach.view( i ), result );
+			}
+
+			return result;
+		}
+
+		static bool isGraphOutput( FrameGraph const & graph
+			, std::unordered_set< uint32_t > const & groupOutputs
+			, Attachment const & attach )
+		{
+			for ( uint32_t i = 0u; i < attach.getViewCount(); ++i )
+			{
+				auto view = attach.view( i );
+
+				if ( groupOutputs.end() != groupOutputs.find( view.id ) )
+				{
+					return true;
+				}
+
+				ImageViewIdArray views;
+				listViews( view, views );
+
+				if ( std::any_of( views.begin()
+					, views.end()
+					, [&graph, &groupOutputs]( ImageViewId const & lookup )
+					{
+						return groupOutputs.end() != groupOutputs.find( lookup.id )
+							|| graph.getOutputLayoutState( lookup ).layout != VK_IMAGE_LAYOUT_UNDEFINED;
+					} ) )
+				{
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		static bool isSameBuffer( Attachment const & lhs
+			, Attachment const & rhs )
+		{
+			for ( uint32_t i = 0u; i < lhs.getBufferCount(); ++i )
+			{
+				for ( uint32_t j = 0u; j < rhs.getBufferCount(); ++j )
+				{
+					if ( lhs.buffer( i ) == rhs.buffer( j ) )
+					{
+						return true;
+					}
+				}
+			}
+
+			return false;
+		}
+
+		static bool isConsumed( FramePassArray const & passes
+			, FramePass const & writer
+			, Attachment const & output )
+		{
+			return std::any_of( passes.begin()
+				, passes.end()
+				, [&writer, &output]( FramePass const * reader )
+				{
+					return reader != &writer
+						&& std::any_of( reader->buffers.begin()
+							, reader->buffers.end()
+							, [&output]( Attachment const & input )
+							{
+								return input.isInput()
+									&& isSameBuffer( input, output );
+							} );
+				} );
+		}
+
+		static bool isRootPass( FrameGraph const & graph
+			, std::unordered_set< uint32_t > const & groupOutputs
+			, FramePassArray const & passes
+			, FramePass const & pass )
+		{
+			// Buffers can't be declared as graph outputs, so the ones written but not read
+			// by any pass of the graph are considered as read outside of it.
+			return pass.hasSideEffects()
+				|| std::any_of( pass.images.begin()
+					, pass.images.end()
+					, [&graph, &groupOutputs]( Attachment const & attach )
+					{
+						return attach.isOutput()
+							&& isGraphOutput( graph, groupOutputs, attach );
+					} )
+				|| std::any_of( pass.buffers.begin()
+					, pass.buffers.end()
+					, [&passes, &pass]( Attachment const & attach )
+					{
+						return attach.isOutput()
+							&& !isConsumed( passes, pass, attach );
+					} );
+		}
+
+		static bool isWritingInput( FramePass const & writer
+			, Attachment const & input )
+		{
+			if ( input.isImage() )
+			{
+				auto inputViews = listViews( input );
+				return std::any_of( writer.images.begin()
+					, writer.images.end()
+					, [&inputViews]( Attachment const & attach )
+					{
+						if ( !attach.isOutput() )
+						{
+							return false;
+						}
+
+						auto outputViews = listViews( attach );
+						return std::any_of( outputViews.begin()
+							, outputViews.end()
+							, [&inputViews]( ImageViewId const & output )
+							{
+								return std::any_of( inputViews.begin()
+									, inputViews.end()
+									, [&output]( ImageViewId const & lookup )
+									{
+										return isOverlapping( *lookup.data, *output.data );
+									} );
+							} );
+					} );
+			}
+
+			return std::any_of( writer.buffers.begin()
+				, writer.buffers.end()
+				, [&input]( Attachment const & attach )
+				{
+					return attach.isOutput()
+						&& isSameBuffer( input, attach );
+				} );
+		}
+
+		static FramePassArray cullPasses( FrameGraph const & graph
+			, std::unordered_set< uint32_t > const & groupOutputs
+			, FramePassArray const & passes )
+		{
+			FramePassArray alive;
+
+			for ( auto & pass : passes )
+			{
+				if ( isRootPass( graph, groupOutputs, passes, *pass ) )
+				{
+					alive.push_back( pass );
+				}
+			}
+
+			if ( alive.empty() )
+			{
+				Logger::logWarning( graph.getName() + " - No pass produces the graph outputs, passes culling skipped" );
+				return passes;
+			}
+
+			// Walk the passes backwards from the roots, through their explicit dependencies and their inputs producers.
+			for ( size_t index = 0u; index < alive.size(); ++index )
+			{
+				auto & current = *alive[index];
+				auto isAlive = [&alive]( FramePass const * lookup )
+				{
+					return alive.end() != std::find( alive.begin(), alive.end(), lookup );
+				};
+
+				for ( auto & depend : current.passDepends )
+				{
+					if ( !isAlive( depend ) )
+					{
+						alive.push_back( depend );
+					}
+				}
+
+				for ( auto & pass : passes )
+				{
+					if ( isAlive( pass ) )
+					{
+						continue;
+					}
+
+					auto isProducer = [&pass]( Attachment const & attach )
+					{
+						return attach.isInput()
+							&& isWritingInput( *pass, attach );
+					};
+
+					if ( std::any_of( current.images.begin(), current.images.end(), isProducer )
+						|| std::any_of( current.buffers.begin(), current.buffers.end(), isProducer ) )
+					{
+						alive.push_back( pass );
+					}
+				}
+			}
+
+			FramePassArray result;
+
+			for ( auto & pass : passes )
+			{
+				if ( alive.end() != std::find( alive.begin(), alive.end(), pass ) )
+				{
+					result.push_back( pass );
+				}
+				else
+				{
+					Logger::logDebug( graph.getName() + " - Culled pass " + pass->getGroupName() );
+				}
+			}
+
+			return result;
+		}
+	}
 
 	FrameGraph::FrameGraph( ResourceHandler & handler
 		, std::string name )
@@ -187,7 +419,29 @@ namespace crg
 		return result;
 	}
 
-	RunnableGraphPtr FrameGraph::compile( GraphContext & context )
+	Buffer FrameGraph::createBuffer( BufferData const & buffer )
+	{
+		auto bufferId = m_handler.createBufferId( buffer );
+		m_buffers.insert( bufferId );
+		return Buffer{ m_handler.getBufferHandle( bufferId ), buffer.name };
+	}
+
+	Buffer FrameGraph::createFrameDataBuffer( std::string const & name
+		, VkDeviceSize size
+		, FrameDataProvider provider )
+	{
+		BufferData data{ name
+			, size
+			, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT
+			, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT };
+		auto bufferId = m_handler.createBufferId( data );
+		m_buffers.insert( bufferId );
+		m_frameDataProviders.try_emplace( bufferId, std::move( provider ) );
+		return Buffer{ m_handler.getBufferHandle( bufferId ), name };
+	}
+
+	RunnableGraphPtr FrameGraph::compile( GraphContext & context
+		, bool cullPasses )
 	{
 		FramePassArray passes;
 		m_defaultGroup->listPasses( passes );
@@ -198,6 +452,19 @@ namespace crg
 			CRG_Exception( "No FramePass registered." );
 		}
 
+		// Graph owned buffers handles are needed to compute the dependencies.
+		for ( auto & buffer : m_buffers )
+		{
+			m_handler.createBuffer( context, buffer );
+		}
+
+		if ( cullPasses )
+		{
+			std::unordered_set< uint32_t > groupOutputs;
+			m_defaultGroup->listGroupOutputs( groupOutputs );
+			passes = fgph::cullPasses( *this, groupOutputs, passes );
+		}
+
 		passes = fgph::sortPasses( passes );
 		GraphNodePtrArray nodes;
 
@@ -645,6 +912,17 @@ namespace crg
 				, rhs.info );
 	}
 
+	bool isOverlapping( ImageViewData const & lhs, ImageViewData const & rhs )noexcept
+	{
+		auto lhsRange = getVirtualRange( lhs.image, lhs.info.viewType, lhs.info.subresourceRange );
+		auto rhsRange = getVirtualRange( rhs.image, rhs.info.viewType, rhs.info.subresourceRange );
+		return lhs.image.id == rhs.image.id
+			&& builder::areIntersecting( lhsRange.baseMipLevel, lhsRange.levelCount
+				, rhsRange.baseMipLevel, rhsRange.levelCount )
+			&& builder::areIntersecting( lhsRange.baseArrayLayer, lhsRange.layerCount
+				, rhsRange.baseArrayLayer, rhsRange.layerCount );
+	}
+
 	bool isDepthFormat( VkFormat fmt )noexcept
 	{
 		return fmt == VK_FORMAT_D16_UNORM
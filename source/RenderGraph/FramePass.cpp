@@ -291,6 +291,13 @@ namespace crg
 			, std::move( wantedAccess ) } );
 	}
 
+	void FramePass::addIndirectBuffer( Buffer buffer
+		, VkDeviceSize offset
+		, VkDeviceSize range )
+	{
+		addImplicitBuffer( std::move( buffer ), offset, range, { VK_ACCESS_INDIRECT_COMMAND_READ_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT } );
+	}
+
 	void FramePass::addUniformBuffer( Buffer buffer
 		, uint32_t binding
 		, VkDeviceSize offset
@@ -658,6 +665,28 @@ namespace crg
 			, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL } );
 	}
 
+	void FramePass::addSamePixelSampledView( ImageViewIdArray views
+		, uint32_t binding
+		, SamplerDesc samplerDesc )
+	{
+		auto attachName = fpass::adjustName( *this, views.front().data->name ) + "/Spl";
+		images.push_back( { Attachment::FlagKind( Attachment::Flag::Input )
+			, *this
+			, binding
+			, std::move( attachName )
+			, ImageAttachment::FlagKind( ImageAttachment::FlagKind( ImageAttachment::Flag::Sampled )
+				| ImageAttachment::FlagKind( ImageAttachment::Flag::SamePixel ) )
+			, std::move( views )
+			, VK_ATTACHMENT_LOAD_OP_DONT_CARE
+			, VK_ATTACHMENT_STORE_OP_DONT_CARE
+			, VK_ATTACHMENT_LOAD_OP_DONT_CARE
+			, VK_ATTACHMENT_STORE_OP_DONT_CARE
+			, std::move( samplerDesc )
+			, VkClearValue{}
+			, VkPipelineColorBlendAttachmentState{}
+			, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL } );
+	}
+
 	void FramePass::addImplicitColourView( ImageViewIdArray views
 		, VkImageLayout wantedLayout )
 	{
@@ -22,13 +22,6 @@ namespace crg::builder
 {
 	namespace deps
 	{
-		static bool isInRange( uint32_t value
-			, uint32_t left
-			, uint32_t count )
-		{
-			return value >= left && value < left + count;
-		}
-
 		static bool isSingleMipView( ImageViewId const & sub
 			, ImageViewId const & main )
 		{
@@ -302,40 +295,10 @@ namespace crg::builder
 #endif
 		}
 
-		static bool areIntersecting( uint32_t lhsLBound
-			, uint32_t lhsCount
-			, uint32_t rhsLBound
-			, uint32_t rhsCount )
-		{
-			return isInRange( lhsLBound, rhsLBound, rhsCount )
-				|| isInRange( rhsLBound, lhsLBound, lhsCount );
-		}
-
-		static bool areIntersecting( VkImageSubresourceRange const & lhs
-			, VkImageSubresourceRange const & rhs )
-		{
-			return areIntersecting( lhs.baseMipLevel
-				, lhs.levelCount
-				, rhs.baseMipLevel
-				, rhs.levelCount )
-				&& areIntersecting( lhs.baseArrayLayer
-					, lhs.layerCount
-					, rhs.baseArrayLayer
-					, lhs.layerCount );
-		}
-
-		static bool areOverlapping( ImageViewData const & lhs
-			, ImageViewData const & rhs )
-		{
-			return lhs.image == rhs.image
-				&& areIntersecting( getVirtualRange( lhs.image, lhs.info.viewType, lhs.info.subresourceRange )
-					, getVirtualRange( rhs.image, rhs.info.viewType, rhs.info.subresourceRange ) );
-		}
-
 		static bool areOverlapping( ImageViewId const & lhs
 			, ImageViewId const & rhs )
 		{
-			return areOverlapping( *lhs.data, *rhs.data );
+			return isOverlapping( *lhs.data, *rhs.data );
 		}
 
 		static bool areOverlapping( Buffer const & lhs
@@ -137,6 +137,16 @@ namespace crg
 		m_outputs.emplace( view.id );
 	}
 
+	void FramePassGroup::listGroupOutputs( std::unordered_set< uint32_t > & result )const
+	{
+		result.insert( m_outputs.begin(), m_outputs.end() );
+
+		for ( auto & group : groups )
+		{
+			group->listGroupOutputs( result );
+		}
+	}
+
 	LayoutState FramePassGroup::getFinalLayoutState( ImageViewId view
 		, uint32_t passIndex )const
 	{
@@ -153,6 +163,11 @@ namespace crg
 		return m_graph.createView( view );
 	}
 
+	Buffer FramePassGroup::createBuffer( BufferData const & buffer )const
+	{
+		return m_graph.createBuffer( buffer );
+	}
+
 	void FramePassGroup::addInput( ImageId image
 		, VkImageViewType viewType
 		, VkImageSubresourceRange const & range
@@ -100,7 +100,7 @@ namespace crg
 		m_gpuTime = 0ns;
 	}
 
-	void FramePassTimer::beginPass( VkCommandBuffer commandBuffer )noexcept
+	void FramePassTimer::resetPass( VkCommandBuffer commandBuffer )noexcept
 	{
 		std::swap( m_queries.front(), m_queries.back() );
 		auto const & query = m_queries.front();
@@ -108,6 +108,18 @@ namespace crg
 			, m_timerQueries
 			, query.offset
 			, 2u );
+		m_passReset = true;
+	}
+
+	void FramePassTimer::beginPass( VkCommandBuffer commandBuffer )noexcept
+	{
+		if ( !m_passReset )
+		{
+			resetPass( commandBuffer );
+		}
+
+		m_passReset = false;
+		auto const & query = m_queries.front();
 		m_context.vkCmdWriteTimestamp( commandBuffer
 			, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT
 			, m_timerQueries
@@ -45,6 +45,9 @@ namespace crg
 		DECL_vkFunction( CreateGraphicsPipelines );
 		DECL_vkFunction( CreateComputePipelines );
 		DECL_vkFunction( DestroyPipeline );
+		DECL_vkFunction( CreatePipelineCache );
+		DECL_vkFunction( DestroyPipelineCache );
+		DECL_vkFunction( GetPipelineCacheData );
 		DECL_vkFunction( CreatePipelineLayout );
 		DECL_vkFunction( DestroyPipelineLayout );
 		DECL_vkFunction( CreateDescriptorSetLayout );
@@ -112,8 +115,17 @@ namespace crg
 		DECL_vkFunction( CmdDrawIndexed );
 		DECL_vkFunction( CmdDrawIndexedIndirect );
 		DECL_vkFunction( CmdDrawIndirect );
+#if VK_VERSION_1_2
+		DECL_vkFunction( CmdDrawIndexedIndirectCount );
+		DECL_vkFunction( CmdDrawIndirectCount );
+#endif
 		DECL_vkFunction( CmdBeginRenderPass );
 		DECL_vkFunction( CmdEndRenderPass );
+		DECL_vkFunction( CmdNextSubpass );
+#if VK_KHR_dynamic_rendering
+		DECL_vkFunction( CmdBeginRenderingKHR );
+		DECL_vkFunction( CmdEndRenderingKHR );
+#endif
 		DECL_vkFunction( CmdPushConstants );
 		DECL_vkFunction( CmdResetQueryPool );
 		DECL_vkFunction( CmdWriteTimestamp );
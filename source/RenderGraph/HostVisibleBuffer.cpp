@@ -0,0 +1,124 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#include "HostVisibleBuffer.hpp"
+
+#include "RenderGraph/GraphContext.hpp"
+
+namespace crg
+{
+	namespace hostbuf
+	{
+		static uint32_t deduceMemoryType( GraphContext const & context
+			, uint32_t typeBits
+			, VkMemoryPropertyFlags preferredFlags )
+		{
+			VkMemoryPropertyFlags required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+				| VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+			VkMemoryPropertyFlags preferred = required | preferredFlags;
+
+			for ( uint32_t i = 0; i < context.memoryProperties.memoryTypeCount; ++i )
+			{
+				if ( ( typeBits & ( 1u << i ) ) != 0u
+					&& ( context.memoryProperties.memoryTypes[i].propertyFlags & preferred ) == preferred )
+				{
+					return i;
+				}
+			}
+
+			return context.deduceMemoryType( typeBits, required );
+		}
+	}
+
+	void createHostVisibleBuffer( GraphContext & context
+		, std::string const & name
+		, VkDeviceSize size
+		, VkBufferUsageFlags usage
+		, VkMemoryPropertyFlags preferredFlags
+		, VkBuffer & buffer
+		, VkDeviceMemory & memory
+		, uint8_t *& data )
+	{
+		VkBufferCreateInfo createInfo{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO
+			, nullptr
+			, 0u
+			, size
+			, usage
+			, VK_SHARING_MODE_EXCLUSIVE
+			, 0u
+			, nullptr };
+		auto res = context.vkCreateBuffer( context.device
+			, &createInfo
+			, context.allocator
+			, &buffer );
+		checkVkResult( res, name + " - Buffer creation" );
+		crgRegisterObject( context, name, buffer );
+
+		if ( !context.device )
+		{
+			return;
+		}
+
+		VkMemoryRequirements requirements{};
+		context.vkGetBufferMemoryRequirements( context.device
+			, buffer
+			, &requirements );
+		VkMemoryAllocateInfo allocateInfo{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO
+			, nullptr
+			, requirements.size
+			, hostbuf::deduceMemoryType( context, requirements.memoryTypeBits, preferredFlags ) };
+		res = context.vkAllocateMemory( context.device
+			, &allocateInfo
+			, context.allocator
+			, &memory );
+		checkVkResult( res, name + " - Memory allocation" );
+		crgRegisterObject( context, name, memory );
+
+		res = context.vkBindBufferMemory( context.device
+			, buffer
+			, memory
+			, 0u );
+		checkVkResult( res, name + " - Memory binding" );
+
+		void * mapped{};
+		res = context.vkMapMemory( context.device
+			, memory
+			, 0u
+			, VK_WHOLE_SIZE
+			, 0u
+			, &mapped );
+		checkVkResult( res, name + " - Memory mapping" );
+		data = static_cast< uint8_t * >( mapped );
+	}
+
+	void destroyHostVisibleBuffer( GraphContext & context
+		, VkBuffer & buffer
+		, VkDeviceMemory & memory
+		, uint8_t *& data )noexcept
+	{
+		if ( memory )
+		{
+			if ( data )
+			{
+				context.vkUnmapMemory( context.device, memory );
+				data = nullptr;
+			}
+
+			crgUnregisterObject( context, memory );
+			context.vkFreeMemory( context.device
+				, memory
+				, context.allocator );
+			memory = {};
+		}
+
+		if ( buffer )
+		{
+			crgUnregisterObject( context, buffer );
+			context.vkDestroyBuffer( context.device
+				, buffer
+				, context.allocator );
+			buffer = {};
+		}
+	}
+}
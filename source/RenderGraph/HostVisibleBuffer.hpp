@@ -0,0 +1,37 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#pragma once
+
+#include "RenderGraph/FrameGraphPrerequisites.hpp"
+
+namespace crg
+{
+	/**
+	*\brief
+	*	Creates a buffer bound to persistently mapped, host visible and coherent memory.
+	*\remarks
+	*	Without device, only the buffer is created, and \p memory and \p data are left empty.
+	*\param[in] name
+	*	The name used to register the objects and in the error messages.
+	*\param[in] preferredFlags
+	*	Memory properties preferred on top of host visibility and coherency (e.g. cached memory for host reads).
+	*/
+	void createHostVisibleBuffer( GraphContext & context
+		, std::string const & name
+		, VkDeviceSize size
+		, VkBufferUsageFlags usage
+		, VkMemoryPropertyFlags preferredFlags
+		, VkBuffer & buffer
+		, VkDeviceMemory & memory
+		, uint8_t *& data );
+	/**
+	*\brief
+	*	Unmaps and frees the memory, and destroys the buffer, created through createHostVisibleBuffer.
+	*/
+	void destroyHostVisibleBuffer( GraphContext & context
+		, VkBuffer & buffer
+		, VkDeviceMemory & memory
+		, uint8_t *& data )noexcept;
+}
@@ -0,0 +1,201 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#include "RenderGraph/PipelineCache.hpp"
+#include "RenderGraph/GraphContext.hpp"
+#include "RenderGraph/Log.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace crg
+{
+	namespace plcache
+	{
+		static uint32_t constexpr HeaderSize = 16u + VK_UUID_SIZE;
+
+		static uint32_t readUInt32( std::vector< uint8_t > const & data
+			, size_t offset )
+		{
+			uint32_t result{};
+			std::memcpy( &result, data.data() + offset, sizeof( uint32_t ) );
+			return result;
+		}
+
+		static std::vector< uint8_t > readFile( std::string const & filePath )
+		{
+			std::vector< uint8_t > result;
+			std::ifstream file{ filePath, std::ios::binary | std::ios::ate };
+
+			if ( !file )
+			{
+				return result;
+			}
+
+			auto size = file.tellg();
+
+			if ( size <= 0 )
+			{
+				return result;
+			}
+
+			result.resize( size_t( size ) );
+			file.seekg( 0, std::ios::beg );
+
+			if ( !file.read( reinterpret_cast< char * >( result.data() ), std::streamsize( result.size() ) ) )
+			{
+				result.clear();
+			}
+
+			return result;
+		}
+	}
+
+	PipelineCache::PipelineCache( GraphContext & context
+		, std::string filePath )
+		: m_context{ context }
+		, m_filePath{ std::move( filePath ) }
+		, m_previous{ context.cache }
+	{
+		if ( !m_context.vkCreatePipelineCache )
+		{
+			return;
+		}
+
+		auto data = plcache::readFile( m_filePath );
+
+		if ( !data.empty() && !isCompatible( m_context.properties, data ) )
+		{
+			Logger::logWarning( "Pipeline cache [" + m_filePath + "] doesn't match the device, discarding it" );
+			data.clear();
+		}
+
+		VkPipelineCacheCreateInfo createInfo{ VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO
+			, nullptr
+			, 0u
+			, data.size()
+			, data.empty() ? nullptr : data.data() };
+		auto res = m_context.vkCreatePipelineCache( m_context.device
+			, &createInfo
+			, m_context.allocator
+			, &m_cache );
+
+		if ( res != VK_SUCCESS && !data.empty() )
+		{
+			Logger::logWarning( "Pipeline cache [" + m_filePath + "] couldn't be loaded, starting from an empty one" );
+			createInfo.initialDataSize = 0u;
+			createInfo.pInitialData = nullptr;
+			data.clear();
+			res = m_context.vkCreatePipelineCache( m_context.device
+				, &createInfo
+				, m_context.allocator
+				, &m_cache );
+		}
+
+		checkVkResult( res, "PipelineCache creation" );
+		crgRegisterObject( m_context, m_filePath, m_cache );
+		m_loaded = !data.empty();
+		m_context.cache = m_cache;
+	}
+
+	PipelineCache::~PipelineCache()noexcept
+	{
+		if ( !m_cache )
+		{
+			return;
+		}
+
+		try
+		{
+			save();
+		}
+		catch ( std::exception & exc )
+		{
+			Logger::logError( "Pipeline cache [" + m_filePath + "] save failed: " + exc.what() );
+		}
+
+		if ( m_context.cache == m_cache )
+		{
+			m_context.cache = m_previous;
+		}
+
+		crgUnregisterObject( m_context, m_cache );
+
+		if ( m_context.vkDestroyPipelineCache )
+		{
+			m_context.vkDestroyPipelineCache( m_context.device, m_cache, m_context.allocator );
+		}
+	}
+
+	bool PipelineCache::save()const
+	{
+		if ( !m_cache || !m_context.vkGetPipelineCacheData )
+		{
+			return false;
+		}
+
+		size_t size{};
+		auto res = m_context.vkGetPipelineCacheData( m_context.device, m_cache, &size, nullptr );
+
+		if ( res != VK_SUCCESS || size == 0u )
+		{
+			return false;
+		}
+
+		std::vector< uint8_t > data( size );
+		res = m_context.vkGetPipelineCacheData( m_context.device, m_cache, &size, data.data() );
+
+		if ( res != VK_SUCCESS )
+		{
+			Logger::logWarning( "Pipeline cache [" + m_filePath + "] data couldn't be retrieved" );
+			return false;
+		}
+
+		auto tmpPath = m_filePath + ".tmp";
+
+		{
+			std::ofstream file{ tmpPath, std::ios::binary | std::ios::trunc };
+
+			if ( !file
+				|| !file.write( reinterpret_cast< char const * >( data.data() ), std::streamsize( size ) ) )
+			{
+				Logger::logWarning( "Pipeline cache [" + tmpPath + "] couldn't be written" );
+				return false;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename( tmpPath, m_filePath, error );
+
+		if ( error )
+		{
+			Logger::logWarning( "Pipeline cache [" + m_filePath + "] couldn't be replaced: " + error.message() );
+			std::filesystem::remove( tmpPath, error );
+			return false;
+		}
+
+		return true;
+	}
+
+	bool PipelineCache::isCompatible( VkPhysicalDeviceProperties const & properties
+		, std::vector< uint8_t > const & data )
+	{
+		if ( data.size() < plcache::HeaderSize )
+		{
+			return false;
+		}
+
+		auto headerSize = plcache::readUInt32( data, 0u );
+		auto headerVersion = plcache::readUInt32( data, 4u );
+		auto vendorID = plcache::readUInt32( data, 8u );
+		auto deviceID = plcache::readUInt32( data, 12u );
+		return headerSize >= plcache::HeaderSize
+			&& headerSize <= data.size()
+			&& headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+			&& vendorID == properties.vendorID
+			&& deviceID == properties.deviceID
+			&& 0 == std::memcmp( data.data() + 16u, properties.pipelineCacheUUID, VK_UUID_SIZE );
+	}
+}
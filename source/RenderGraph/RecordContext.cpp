@@ -9,9 +9,11 @@ See LICENSE file in root folder.
 #include "RenderGraph/RunnableGraph.hpp"
 
 #include <array>
+#include <limits>
 #include <string>
 #include <type_traits>
 #include <unordered_set>
+#include <utility>
 
 #pragma warning( push )
 #pragma warning( disable: 5262 )
@@ -42,6 +44,233 @@ namespace crg
 
 			return result;
 		}
+
+		static bool isReadOnly( VkAccessFlags access )
+		{
+			VkAccessFlags constexpr writeMask = VK_ACCESS_SHADER_WRITE_BIT
+				| VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+				| VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+				| VK_ACCESS_TRANSFER_WRITE_BIT
+				| VK_ACCESS_HOST_WRITE_BIT
+				| VK_ACCESS_MEMORY_WRITE_BIT;
+			return access != 0u
+				&& ( access & writeMask ) == 0u;
+		}
+		/**
+		*\brief
+		*	Tells if going from \p from to \p to is a read after read in stages that already see the last write.
+		*\remarks
+		*	The tracked stages are the ones the last write has been made visible to,
+		*	a read in another stage still needs a barrier, chained to the previous one.
+		*/
+		static bool isElidable( AccessState const & from
+			, AccessState const & to )
+		{
+			return isReadOnly( from.access )
+				&& isReadOnly( to.access )
+				&& ( to.pipelineStage & ~from.pipelineStage ) == 0u;
+		}
+		/**
+		*\brief
+		*	The state after a read to read barrier: the data is visible to both stages sets.
+		*/
+		static AccessState widen( AccessState const & from
+			, AccessState const & to )
+		{
+			if ( isReadOnly( from.access ) && isReadOnly( to.access ) )
+			{
+				return { from.access | to.access
+					, from.pipelineStage | to.pipelineStage };
+			}
+
+			return to;
+		}
+
+		static uint32_t getEnd( uint32_t base
+			, uint32_t count )
+		{
+			return count == VK_REMAINING_MIP_LEVELS
+				? std::numeric_limits< uint32_t >::max()
+				: base + count;
+		}
+
+		static bool overlaps( uint32_t lhsBase, uint32_t lhsCount
+			, uint32_t rhsBase, uint32_t rhsCount )
+		{
+			return lhsBase < getEnd( rhsBase, rhsCount )
+				&& rhsBase < getEnd( lhsBase, lhsCount );
+		}
+
+		static bool overlaps( VkImageMemoryBarrier const & lhs
+			, VkImageMemoryBarrier const & rhs )
+		{
+			auto & lhsRange = lhs.subresourceRange;
+			auto & rhsRange = rhs.subresourceRange;
+			return lhs.image == rhs.image
+				&& ( lhsRange.aspectMask & rhsRange.aspectMask ) != 0u
+				&& overlaps( lhsRange.baseMipLevel, lhsRange.levelCount, rhsRange.baseMipLevel, rhsRange.levelCount )
+				&& overlaps( lhsRange.baseArrayLayer, lhsRange.layerCount, rhsRange.baseArrayLayer, rhsRange.layerCount );
+		}
+
+		static bool overlaps( VkBufferMemoryBarrier const & lhs
+			, VkBufferMemoryBarrier const & rhs )
+		{
+			auto lhsEnd = lhs.size == VK_WHOLE_SIZE ? std::numeric_limits< VkDeviceSize >::max() : lhs.offset + lhs.size;
+			auto rhsEnd = rhs.size == VK_WHOLE_SIZE ? std::numeric_limits< VkDeviceSize >::max() : rhs.offset + rhs.size;
+			return lhs.buffer == rhs.buffer
+				&& lhs.offset < rhsEnd
+				&& rhs.offset < lhsEnd;
+		}
+		/**
+		*\brief
+		*	Merges \p rhs into \p lhs, if they only differ by adjacent mip levels or adjacent array layers.
+		*/
+		static bool tryMerge( VkImageMemoryBarrier & lhs
+			, VkImageMemoryBarrier const & rhs )
+		{
+			auto & lhsRange = lhs.subresourceRange;
+			auto & rhsRange = rhs.subresourceRange;
+
+			if ( lhs.image != rhs.image
+				|| lhs.oldLayout != rhs.oldLayout
+				|| lhs.newLayout != rhs.newLayout
+				|| lhs.srcAccessMask != rhs.srcAccessMask
+				|| lhs.dstAccessMask != rhs.dstAccessMask
+				|| lhs.srcQueueFamilyIndex != rhs.srcQueueFamilyIndex
+				|| lhs.dstQueueFamilyIndex != rhs.dstQueueFamilyIndex
+				|| lhsRange.aspectMask != rhsRange.aspectMask
+				|| lhsRange.levelCount == VK_REMAINING_MIP_LEVELS
+				|| rhsRange.levelCount == VK_REMAINING_MIP_LEVELS
+				|| lhsRange.layerCount == VK_REMAINING_ARRAY_LAYERS
+				|| rhsRange.layerCount == VK_REMAINING_ARRAY_LAYERS )
+			{
+				return false;
+			}
+
+			if ( lhsRange.baseArrayLayer == rhsRange.baseArrayLayer
+				&& lhsRange.layerCount == rhsRange.layerCount
+				&& ( lhsRange.baseMipLevel + lhsRange.levelCount == rhsRange.baseMipLevel
+					|| rhsRange.baseMipLevel + rhsRange.levelCount == lhsRange.baseMipLevel ) )
+			{
+				lhsRange.baseMipLevel = std::min( lhsRange.baseMipLevel, rhsRange.baseMipLevel );
+				lhsRange.levelCount += rhsRange.levelCount;
+				return true;
+			}
+
+			if ( lhsRange.baseMipLevel == rhsRange.baseMipLevel
+				&& lhsRange.levelCount == rhsRange.levelCount
+				&& ( lhsRange.baseArrayLayer + lhsRange.layerCount == rhsRange.baseArrayLayer
+					|| rhsRange.baseArrayLayer + rhsRange.layerCount == lhsRange.baseArrayLayer ) )
+			{
+				lhsRange.baseArrayLayer = std::min( lhsRange.baseArrayLayer, rhsRange.baseArrayLayer );
+				lhsRange.layerCount += rhsRange.layerCount;
+				return true;
+			}
+
+			return false;
+		}
+
+		template< typename BarrierT >
+		static void coalesce( std::vector< BarrierT > & barriers )
+		{
+			bool merged = true;
+
+			while ( merged )
+			{
+				merged = false;
+
+				for ( auto it = barriers.begin(); it != barriers.end(); ++it )
+				{
+					auto next = std::next( it );
+
+					while ( next != barriers.end() )
+					{
+						if ( it->srcStage == next->srcStage
+							&& it->dstStage == next->dstStage
+							&& tryMerge( it->barrier, next->barrier ) )
+						{
+							next = barriers.erase( next );
+							merged = true;
+						}
+						else
+						{
+							++next;
+						}
+					}
+				}
+			}
+		}
+
+		static VkDeviceSize getEnd( BufferSubresourceRange const & range )
+		{
+			return range.size == VK_WHOLE_SIZE
+				? std::numeric_limits< VkDeviceSize >::max()
+				: range.offset + range.size;
+		}
+
+		static bool operator==( AccessState const & lhs, AccessState const & rhs )
+		{
+			return lhs.access == rhs.access
+				&& lhs.pipelineStage == rhs.pipelineStage;
+		}
+
+		static void setRange( AccessRangeMap & ranges
+			, VkDeviceSize begin
+			, VkDeviceSize end
+			, AccessState const & state )
+		{
+			auto it = ranges.lower_bound( begin );
+
+			// Cut the interval starting before the range.
+			if ( it != ranges.begin() )
+			{
+				auto prev = std::prev( it );
+
+				if ( prev->second.end > begin )
+				{
+					if ( prev->second.end > end )
+					{
+						ranges.emplace( end, prev->second );
+					}
+
+					prev->second.end = begin;
+				}
+			}
+
+			// Remove the intervals starting inside the range, keeping their tail.
+			while ( it != ranges.end() && it->first < end )
+			{
+				if ( it->second.end > end )
+				{
+					auto tail = it->second;
+					ranges.erase( it );
+					ranges.emplace( end, tail );
+					break;
+				}
+
+				it = ranges.erase( it );
+			}
+
+			it = ranges.emplace( begin, AccessRange{ end, state } ).first;
+
+			// Merge with neighbours in the same state, to keep the map small.
+			if ( auto next = std::next( it );
+				next != ranges.end() && next->first == end && next->second.state == state )
+			{
+				it->second.end = next->second.end;
+				ranges.erase( next );
+			}
+
+			if ( it != ranges.begin() )
+			{
+				if ( auto prev = std::prev( it );
+					prev->second.end == begin && prev->second.state == state )
+				{
+					prev->second.end = it->second.end;
+					ranges.erase( it );
+				}
+			}
+		}
 	}
 
 	//************************************************************************************************
@@ -65,9 +294,9 @@ namespace crg
 	{
 		m_images.addStates( data.m_images );
 
-		for ( auto & state : data.m_buffers )
+		for ( auto & [buffer, ranges] : data.m_buffers )
 		{
-			m_buffers.insert( state );
+			m_buffers.insert( { buffer, ranges } );
 		}
 
 		if ( m_prevPipelineState.access < data.m_currPipelineState.access )
@@ -78,11 +307,18 @@ namespace crg
 
 	void RecordContext::setNextPipelineState( PipelineState const & state
 		, LayerLayoutStatesMap const & imageLayouts )
+	{
+		setNextPipelineState( state
+			, std::make_shared< LayerLayoutStatesHandler const >( imageLayouts ) );
+	}
+
+	void RecordContext::setNextPipelineState( PipelineState const & state
+		, std::shared_ptr< LayerLayoutStatesHandler const > imageLayouts )
 	{
 		m_prevPipelineState = m_currPipelineState;
 		m_currPipelineState = m_nextPipelineState;
 		m_nextPipelineState = state;
-		m_nextImages = LayerLayoutStatesHandler{ imageLayouts };
+		m_nextImages = std::move( imageLayouts );
 	}
 
 	void RecordContext::setLayoutState( crg::ImageViewId view
@@ -118,67 +354,99 @@ namespace crg
 
 	LayoutState RecordContext::getNextLayoutState( ImageViewId view )const
 	{
-		return m_nextImages.getLayoutState( view );
+		return m_nextImages
+			? m_nextImages->getLayoutState( view )
+			: LayoutState{ VK_IMAGE_LAYOUT_UNDEFINED, { 0u, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT } };
 	}
 
 	LayoutState RecordContext::getNextLayoutState( ImageId image
 		, VkImageViewType viewType
 		, VkImageSubresourceRange const & subresourceRange )const
 	{
-		return m_nextImages.getLayoutState( image
-			, viewType
-			, subresourceRange );
+		return m_nextImages
+			? m_nextImages->getLayoutState( image
+				, viewType
+				, subresourceRange )
+			: LayoutState{ VK_IMAGE_LAYOUT_UNDEFINED, { 0u, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT } };
 	}
 
 	void RecordContext::registerImplicitTransition( RunnablePass const & pass
 			, crg::ImageViewId view
 			, RecordContext::ImplicitAction action )
 	{
-		registerImplicitTransition( { &pass, view, std::move( action ) } );
+		registerImplicitTransition( ImplicitTransition{ &pass, view, std::move( action ) } );
 	}
 
 	void RecordContext::registerImplicitTransition( ImplicitTransition transition )
 	{
-		m_implicitTransitions.emplace_back( std::move( transition ) );
+		registerImplicitTransition( std::make_shared< ImplicitTransition const >( std::move( transition ) ) );
+	}
+
+	void RecordContext::registerImplicitTransition( ImplicitTransitionPtr transition )
+	{
+		auto id = transition->view.id;
+		m_implicitTransitions[id].emplace_back( std::move( transition ) );
 	}
 
 	void RecordContext::runImplicitTransition( VkCommandBuffer commandBuffer
 		, uint32_t index
 		, crg::ImageViewId view )
 	{
-		auto it = std::find_if( m_implicitTransitions.begin()
-			, m_implicitTransitions.end()
-			, [&view]( ImplicitTransition const & lookup )
-			{
-				return lookup.view == view;
-			} );
+		auto it = m_implicitTransitions.find( view.id );
+
+		if ( it == m_implicitTransitions.end() )
+		{
+			return;
+		}
+
+		// The transition is removed before its action runs, as the action can run other implicit transitions.
+		auto transition = std::move( it->second.front() );
+		it->second.erase( it->second.begin() );
 
-		if ( it != m_implicitTransitions.end() )
+		if ( it->second.empty() )
 		{
-			auto pass = it->pass;
-			auto action = it->action;
 			m_implicitTransitions.erase( it );
+		}
 
-			if ( !pass->isEnabled() )
-			{
-				action( *this, commandBuffer, index );
-			}
+		if ( !transition->pass->isEnabled() )
+		{
+			// The action records commands depending on its barriers, they can't be deferred.
+			flushBarriers( commandBuffer );
+			auto batching = std::exchange( m_batching, false );
+			transition->action( *this, commandBuffer, index );
+			m_batching = batching;
 		}
 	}
 
 	void RecordContext::setAccessState( VkBuffer buffer
-		, [[maybe_unused]] BufferSubresourceRange const & subresourceRange
+		, BufferSubresourceRange const & subresourceRange
 		, AccessState const & layoutState )
 	{
-		m_buffers.insert_or_assign( buffer, layoutState );
+		recctx::setRange( m_buffers[buffer]
+			, subresourceRange.offset
+			, recctx::getEnd( subresourceRange )
+			, layoutState );
 	}
 
 	AccessState const & RecordContext::getAccessState( VkBuffer buffer
-		, [[maybe_unused]] BufferSubresourceRange const & subresourceRange )const
+		, BufferSubresourceRange const & subresourceRange )const
 	{
 		if ( auto bufferIt = m_buffers.find( buffer ); bufferIt != m_buffers.end() )
 		{
-			return bufferIt->second;
+			auto & ranges = bufferIt->second;
+			auto it = ranges.upper_bound( subresourceRange.offset );
+
+			if ( it != ranges.begin()
+				&& std::prev( it )->second.end > subresourceRange.offset )
+			{
+				return std::prev( it )->second.state;
+			}
+
+			if ( it != ranges.end()
+				&& it->first < recctx::getEnd( subresourceRange ) )
+			{
+				return it->second.state;
+			}
 		}
 
 		static AccessState const dummy{ 0u, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT };
@@ -238,6 +506,18 @@ namespace crg
 				, getStageMask( initialLayout ) };
 		}
 
+		if ( !force
+			&& from.layout == wantedState.layout
+			&& recctx::isElidable( from.state, wantedState.state ) )
+		{
+			if ( from.state.pipelineStage != wantedState.state.pipelineStage )
+			{
+				++m_elidedBarriers;
+			}
+
+			return;
+		}
+
 		if ( force
 			|| ( ( from.layout != wantedState.layout
 				|| from.state.pipelineStage != wantedState.state.pipelineStage )
@@ -254,20 +534,16 @@ namespace crg
 				, VK_QUEUE_FAMILY_IGNORED
 				, resources.createImage( image )
 				, range };
-			resources->vkCmdPipelineBarrier( commandBuffer
+			doAddBarrier( commandBuffer
 				, from.state.pipelineStage
 				, wantedState.state.pipelineStage
-				, VK_DEPENDENCY_BY_REGION_BIT
-				, 0u
-				, nullptr
-				, 0u
-				, nullptr
-				, 1u
-				, &barrier );
+				, barrier );
 			setLayoutState( image
 				, viewType
 				, range
-				, wantedState );
+				, ( from.layout == wantedState.layout
+					? LayoutState{ wantedState.layout, recctx::widen( from.state, wantedState.state ) }
+					: wantedState ) );
 		}
 	}
 
@@ -324,41 +600,101 @@ namespace crg
 		, AccessState const & wantedState
 		, bool force )
 	{
-		auto from = getAccessState( buffer
-			, subresourceRange );
+		// Only the intervals of the range that are not yet in the wanted state get a barrier,
+		// accesses to disjoint ranges of a buffer don't wait for each other.
+		AccessState const initial{ initialMask, initialStage };
+		auto begin = subresourceRange.offset;
+		auto end = recctx::getEnd( subresourceRange );
+		std::vector< VkBufferMemoryBarrier > barriers;
+		std::vector< std::pair< BufferSubresourceRange, AccessState > > states;
+		VkPipelineStageFlags srcStage{};
+		auto addBarrier = [&]( VkDeviceSize first, VkDeviceSize last, AccessState from )
+		{
+			if ( first >= last )
+			{
+				return;
+			}
+
+			if ( from.pipelineStage == VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT )
+			{
+				from = initial;
+			}
+
+			if ( !force
+				&& recctx::isElidable( from, wantedState ) )
+			{
+				if ( from.pipelineStage != wantedState.pipelineStage )
+				{
+					++m_elidedBarriers;
+				}
+
+				return;
+			}
+
+			if ( force
+				|| from.access != wantedState.access
+				|| from.pipelineStage != wantedState.pipelineStage )
+			{
+				barriers.push_back( VkBufferMemoryBarrier{ VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER
+					, nullptr
+					, from.access
+					, wantedState.access
+					, VK_QUEUE_FAMILY_IGNORED
+					, VK_QUEUE_FAMILY_IGNORED
+					, buffer
+					, first
+					, ( last == std::numeric_limits< VkDeviceSize >::max()
+						? VK_WHOLE_SIZE
+						: last - first ) } );
+				states.emplace_back( BufferSubresourceRange{ first, barriers.back().size }
+					, recctx::widen( from, wantedState ) );
+				srcStage |= from.pipelineStage;
+			}
+		};
+
+		if ( auto bufferIt = m_buffers.find( buffer ); bufferIt != m_buffers.end() )
+		{
+			auto & ranges = bufferIt->second;
+			auto it = ranges.upper_bound( begin );
+
+			if ( it != ranges.begin() )
+			{
+				--it;
+			}
+
+			auto curr = begin;
+
+			for ( ; it != ranges.end() && it->first < end && curr < end; ++it )
+			{
+				if ( it->second.end <= curr )
+				{
+					continue;
+				}
 
-		if ( from.pipelineStage == VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT )
+				addBarrier( curr, std::min( it->first, end ), initial );
+				curr = std::max( curr, it->first );
+				addBarrier( curr, std::min( it->second.end, end ), it->second.state );
+				curr = std::min( it->second.end, end );
+			}
+
+			addBarrier( curr, end, initial );
+		}
+		else
 		{
-			from = { initialMask, initialStage };
+			addBarrier( begin, end, initial );
 		}
 
-		if ( force
-			|| ( from.access != wantedState.access
-				|| from.pipelineStage != wantedState.pipelineStage ) )
+		if ( !barriers.empty() )
 		{
-			auto const & resources = getResources();
-			VkBufferMemoryBarrier barrier{ VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER
-				, nullptr
-				, from.access
-				, wantedState.access
-				, VK_QUEUE_FAMILY_IGNORED
-				, VK_QUEUE_FAMILY_IGNORED
-				, buffer
-				, subresourceRange.offset
-				, subresourceRange.size };
-			resources->vkCmdPipelineBarrier( commandBuffer
-				, from.pipelineStage
+			doAddBarriers( commandBuffer
+				, srcStage
 				, wantedState.pipelineStage
-				, VK_DEPENDENCY_BY_REGION_BIT
-				, 0u
-				, nullptr
-				, 1u
-				, &barrier
-				, 0u
-				, nullptr );
-			setAccessState( buffer
-				, subresourceRange
-				, wantedState );
+				, barriers );
+
+			for ( auto & [range, state] : states )
+			{
+				setAccessState( buffer, range, state );
+			}
 		}
 	}
 
@@ -377,6 +713,58 @@ namespace crg
 			, force );
 	}
 
+	void RecordContext::beginBarriersBatch()
+	{
+		m_batching = true;
+	}
+
+	void RecordContext::flushBarriers( VkCommandBuffer commandBuffer )
+	{
+		if ( m_pendingImageBarriers.empty()
+			&& m_pendingBufferBarriers.empty() )
+		{
+			return;
+		}
+
+		recctx::coalesce( m_pendingImageBarriers );
+		using StagesPair = std::pair< VkPipelineStageFlags, VkPipelineStageFlags >;
+		std::map< StagesPair, std::pair< std::vector< VkBufferMemoryBarrier >, std::vector< VkImageMemoryBarrier > > > groups;
+
+		for ( auto & pending : m_pendingBufferBarriers )
+		{
+			groups[{ pending.srcStage, pending.dstStage }].first.push_back( pending.barrier );
+		}
+
+		for ( auto & pending : m_pendingImageBarriers )
+		{
+			groups[{ pending.srcStage, pending.dstStage }].second.push_back( pending.barrier );
+		}
+
+		m_pendingBufferBarriers.clear();
+		m_pendingImageBarriers.clear();
+		auto const & resources = getResources();
+
+		for ( auto & [stages, barriers] : groups )
+		{
+			resources->vkCmdPipelineBarrier( commandBuffer
+				, stages.first
+				, stages.second
+				, VK_DEPENDENCY_BY_REGION_BIT
+				, 0u
+				, nullptr
+				, uint32_t( barriers.first.size() )
+				, barriers.first.data()
+				, uint32_t( barriers.second.size() )
+				, barriers.second.data() );
+		}
+	}
+
+	void RecordContext::endBarriersBatch( VkCommandBuffer commandBuffer )
+	{
+		m_batching = false;
+		flushBarriers( commandBuffer );
+	}
+
 	GraphContext & RecordContext::getContext()const
 	{
 		return getResources();
@@ -533,6 +921,61 @@ namespace crg
 		};
 	}
 
+	void RecordContext::doAddBarrier( VkCommandBuffer commandBuffer
+		, VkPipelineStageFlags srcStage
+		, VkPipelineStageFlags dstStage
+		, VkImageMemoryBarrier const & barrier )
+	{
+		// A barrier must wait for the pending ones on the same subresources.
+		if ( std::any_of( m_pendingImageBarriers.begin()
+			, m_pendingImageBarriers.end()
+			, [&barrier]( PendingBarrierT< VkImageMemoryBarrier > const & lookup )
+			{
+				return recctx::overlaps( lookup.barrier, barrier );
+			} ) )
+		{
+			flushBarriers( commandBuffer );
+		}
+
+		m_pendingImageBarriers.push_back( { srcStage, dstStage, barrier } );
+
+		if ( !m_batching )
+		{
+			flushBarriers( commandBuffer );
+		}
+	}
+
+	void RecordContext::doAddBarriers( VkCommandBuffer commandBuffer
+		, VkPipelineStageFlags srcStage
+		, VkPipelineStageFlags dstStage
+		, std::vector< VkBufferMemoryBarrier > const & barriers )
+	{
+		if ( std::any_of( m_pendingBufferBarriers.begin()
+			, m_pendingBufferBarriers.end()
+			, [&barriers]( PendingBarrierT< VkBufferMemoryBarrier > const & lookup )
+			{
+				return std::any_of( barriers.begin()
+					, barriers.end()
+					, [&lookup]( VkBufferMemoryBarrier const & barrier )
+					{
+						return recctx::overlaps( lookup.barrier, barrier );
+					} );
+			} ) )
+		{
+			flushBarriers( commandBuffer );
+		}
+
+		for ( auto & barrier : barriers )
+		{
+			m_pendingBufferBarriers.push_back( { srcStage, dstStage, barrier } );
+		}
+
+		if ( !m_batching )
+		{
+			flushBarriers( commandBuffer );
+		}
+	}
+
 	ContextResourcesCache & RecordContext::getResources()const
 	{
 		if ( !m_resources )
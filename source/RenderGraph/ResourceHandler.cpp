@@ -4,13 +4,16 @@ See LICENSE file in root folder.
 #include "RenderGraph/ResourceHandler.hpp"
 
 #include "RenderGraph/Attachment.hpp"
+#include "RenderGraph/BufferData.hpp"
 #include "RenderGraph/GraphContext.hpp"
 #include "RenderGraph/ImageData.hpp"
 #include "RenderGraph/ImageViewData.hpp"
 #include "RenderGraph/Log.hpp"
 #include "RenderGraph/RunnableGraph.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <set>
 
 #pragma warning( push )
 #pragma warning( disable: 5262 )
@@ -40,6 +43,35 @@ namespace crg
 			return data.info;
 		}
 
+		static VkImageUsageFlags getTransientUsage( VkImageUsageFlags usage )
+		{
+			// Transient attachments only allow attachment usages.
+			return ( usage & ( VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT
+					| VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT
+					| VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT ) )
+				| VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+		}
+
+		static uint32_t deduceLazyMemoryType( GraphContext const & context
+			, uint32_t typeBits )
+		{
+			auto bits = typeBits;
+
+			for ( uint32_t i = 0; i < context.memoryProperties.memoryTypeCount; ++i )
+			{
+				if ( ( bits & 1 ) == 1
+					&& ( context.memoryProperties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT ) != 0 )
+				{
+					return i;
+				}
+
+				bits >>= 1;
+			}
+
+			return context.deduceMemoryType( typeBits
+				, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+		}
+
 		static VkImageViewCreateInfo convert( ImageViewData const & data
 			, VkImage const & image )
 		{
@@ -97,6 +129,108 @@ namespace crg
 				| ( ( config.invertV ? 0x01u : 0x00u ) << 2u ) };
 			return result;
 		}
+
+		static size_t makeHash( VkRenderPass renderPass
+			, VkImageViewArray const & views
+			, VkExtent2D const & extent
+			, uint32_t layers )
+		{
+			auto result = std::hash< VkRenderPass >{}( renderPass );
+
+			for ( auto view : views )
+			{
+				result = hashCombine( result, view );
+			}
+
+			result = hashCombine( result, extent.width );
+			result = hashCombine( result, extent.height );
+			result = hashCombine( result, layers );
+			return result;
+		}
+
+		static void addReferences( std::vector< uint32_t > & key
+			, uint32_t count
+			, VkAttachmentReference const * references )
+		{
+			key.push_back( references ? count : 0u );
+
+			if ( references )
+			{
+				for ( uint32_t i = 0u; i < count; ++i )
+				{
+					key.push_back( references[i].attachment );
+					key.push_back( uint32_t( references[i].layout ) );
+				}
+			}
+		}
+
+		static std::vector< uint32_t > makeKey( VkRenderPassCreateInfo const & createInfo )
+		{
+			std::vector< uint32_t > result;
+			result.push_back( createInfo.flags );
+			result.push_back( createInfo.attachmentCount );
+
+			for ( uint32_t i = 0u; i < createInfo.attachmentCount; ++i )
+			{
+				auto & attach = createInfo.pAttachments[i];
+				result.push_back( attach.flags );
+				result.push_back( uint32_t( attach.format ) );
+				result.push_back( uint32_t( attach.samples ) );
+				result.push_back( uint32_t( attach.loadOp ) );
+				result.push_back( uint32_t( attach.storeOp ) );
+				result.push_back( uint32_t( attach.stencilLoadOp ) );
+				result.push_back( uint32_t( attach.stencilStoreOp ) );
+				result.push_back( uint32_t( attach.initialLayout ) );
+				result.push_back( uint32_t( attach.finalLayout ) );
+			}
+
+			result.push_back( createInfo.subpassCount );
+
+			for ( uint32_t i = 0u; i < createInfo.subpassCount; ++i )
+			{
+				auto & subpass = createInfo.pSubpasses[i];
+				result.push_back( subpass.flags );
+				result.push_back( uint32_t( subpass.pipelineBindPoint ) );
+				addReferences( result, subpass.inputAttachmentCount, subpass.pInputAttachments );
+				addReferences( result, subpass.colorAttachmentCount, subpass.pColorAttachments );
+				addReferences( result, subpass.colorAttachmentCount, subpass.pResolveAttachments );
+				addReferences( result, 1u, subpass.pDepthStencilAttachment );
+				result.push_back( subpass.preserveAttachmentCount );
+
+				for ( uint32_t j = 0u; j < subpass.preserveAttachmentCount; ++j )
+				{
+					result.push_back( subpass.pPreserveAttachments[j] );
+				}
+			}
+
+			result.push_back( createInfo.dependencyCount );
+
+			for ( uint32_t i = 0u; i < createInfo.dependencyCount; ++i )
+			{
+				auto & dependency = createInfo.pDependencies[i];
+				result.push_back( dependency.srcSubpass );
+				result.push_back( dependency.dstSubpass );
+				result.push_back( dependency.srcStageMask );
+				result.push_back( dependency.dstStageMask );
+				result.push_back( dependency.srcAccessMask );
+				result.push_back( dependency.dstAccessMask );
+				result.push_back( dependency.dependencyFlags );
+			}
+
+			return result;
+		}
+
+		static size_t makeHash( std::vector< uint32_t > const & key )
+		{
+			size_t result{};
+
+			for ( auto value : key )
+			{
+				result = hashCombine( result, value );
+			}
+
+			return result;
+		}
 	}
 
 	//*********************************************************************************************
@@ -132,6 +266,15 @@ namespace crg
 			}
 		}
 
+		for ( auto const & [data, graphBuffer] : m_graphBuffers )
+		{
+			if ( graphBuffer )
+			{
+				snprintf( buffer.data(), buffer.size(), "Leaked [VkBuffer](%.900s)", data.data->name.c_str() );
+				Logger::logError( buffer.data() );
+			}
+		}
+
 		for ( auto const & [_, data] : m_samplers )
 		{
 			snprintf( buffer.data(), buffer.size(), "Leaked [VkSampler](%.900s)", data.name.c_str() );
@@ -173,8 +316,28 @@ namespace crg
 		return result;
 	}
 
+	BufferId ResourceHandler::createBufferId( BufferData const & buffer )
+	{
+		lock_type lock( m_buffersMutex );
+		auto data = std::make_unique< BufferData >( buffer );
+		BufferId result{ uint32_t( m_bufferIds.size() + 1u ), data.get() };
+		m_bufferIds.try_emplace( result, std::move( data ) );
+		m_graphBuffers.try_emplace( result );
+		return result;
+	}
+
+	VkBuffer * ResourceHandler::getBufferHandle( BufferId const & bufferId )
+	{
+		lock_type lock( m_buffersMutex );
+		auto it = m_graphBuffers.find( bufferId );
+		return it == m_graphBuffers.end()
+			? nullptr
+			: &it->second;
+	}
+
 	ResourceHandler::CreatedT< VkImage > ResourceHandler::createImage( GraphContext & context
-		, ImageId imageId )
+		, ImageId imageId
+		, bool transient )
 	{
 		ResourceHandler::CreatedT< VkImage > result{};
 
@@ -188,6 +351,12 @@ namespace crg
 			{
 				// Create image
 				auto createInfo = reshdl::convert( *imageId.data );
+
+				if ( transient )
+				{
+					createInfo.usage = reshdl::getTransientUsage( createInfo.usage );
+				}
+
 				auto res = context.vkCreateImage( context.device
 					, &createInfo
 					, context.allocator
@@ -203,8 +372,10 @@ namespace crg
 					context.vkGetImageMemoryRequirements( context.device
 						, image
 						, &requirements );
-					uint32_t deduced = context.deduceMemoryType( requirements.memoryTypeBits
-						, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+					uint32_t deduced = transient
+						? reshdl::deduceLazyMemoryType( context, requirements.memoryTypeBits )
+						: context.deduceMemoryType( requirements.memoryTypeBits
+							, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
 					VkMemoryAllocateInfo allocateInfo{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO
 						, nullptr
 						, requirements.size
@@ -215,6 +386,8 @@ namespace crg
 						, &it->second.second );
 					auto memory = it->second.second;
 					checkVkResult( res, "Image memory allocation" );
+					m_imagesMemory[imageId] = { requirements, deduced };
+					doAddMemory( requirements.size );
 					crgRegisterObjectName( context, imageId.data->name, memory );
 
 					// Bind image and memory
@@ -263,6 +436,130 @@ namespace crg
 		return result;
 	}
 
+	ResourceHandler::CreatedT< VkBuffer > ResourceHandler::createBuffer( GraphContext & context
+		, BufferId bufferId )
+	{
+		ResourceHandler::CreatedT< VkBuffer > result{};
+
+		if ( context.vkCreateBuffer )
+		{
+			bool created{};
+			lock_type lock( m_buffersMutex );
+			auto & buffer = m_graphBuffers[bufferId];
+
+			if ( !buffer )
+			{
+				auto createInfo = bufferId.data->info;
+				auto res = context.vkCreateBuffer( context.device
+					, &createInfo
+					, context.allocator
+					, &buffer );
+				checkVkResult( res, bufferId.data->name + " - Buffer creation" );
+				crgRegisterObjectName( context, bufferId.data->name, buffer );
+				created = true;
+			}
+
+			result = { buffer, created };
+		}
+
+		return result;
+	}
+
+	void ResourceHandler::bindBufferMemory( GraphContext & context
+		, BufferIdArray const & buffers )
+	{
+		lock_type lock( m_buffersMutex );
+
+		if ( !context.device )
+		{
+			return;
+		}
+
+		std::vector< std::pair< BufferId, VkBuffer > > toBind;
+		VkMemoryRequirements requirements{ 0u, 1u, ~0u };
+		std::string name;
+
+		for ( auto & bufferId : buffers )
+		{
+			auto it = m_graphBuffers.find( bufferId );
+
+			if ( it == m_graphBuffers.end()
+				|| !it->second
+				|| m_graphBuffersMemory.end() != m_graphBuffersMemory.find( bufferId ) )
+			{
+				continue;
+			}
+
+			VkMemoryRequirements bufferRequirements{};
+			context.vkGetBufferMemoryRequirements( context.device
+				, it->second
+				, &bufferRequirements );
+			requirements.size = std::max( requirements.size, bufferRequirements.size );
+			requirements.alignment = std::max( requirements.alignment, bufferRequirements.alignment );
+			requirements.memoryTypeBits &= bufferRequirements.memoryTypeBits;
+			name += ( name.empty() ? std::string{} : std::string{ "/" } ) + bufferId.data->name;
+			toBind.emplace_back( bufferId, it->second );
+		}
+
+		if ( toBind.empty() )
+		{
+			return;
+		}
+
+		uint32_t deduced = context.deduceMemoryType( requirements.memoryTypeBits
+			, toBind.front().first.data->memory );
+		VkMemoryAllocateInfo allocateInfo{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO
+			, nullptr
+			, requirements.size
+			, deduced };
+		VkDeviceMemory memory{};
+		auto res = context.vkAllocateMemory( context.device
+			, &allocateInfo
+			, context.allocator
+			, &memory );
+		checkVkResult( res, name + " - Buffer memory allocation" );
+		crgRegisterObjectName( context, name, memory );
+		m_memoryBlocks[memory] = { { requirements, deduced }, uint32_t( toBind.size() ) };
+		doAddMemory( requirements.size );
+
+		for ( auto & [bufferId, buffer] : toBind )
+		{
+			res = context.vkBindBufferMemory( context.device
+				, buffer
+				, memory
+				, 0u );
+			checkVkResult( res, bufferId.data->name + " - Buffer memory binding" );
+			m_graphBuffersMemory[bufferId] = memory;
+		}
+	}
+
+	void * ResourceHandler::mapBufferMemory( GraphContext & context
+		, BufferId const & bufferId )
+	{
+		lock_type lock( m_buffersMutex );
+		auto it = m_graphBuffersMemory.find( bufferId );
+
+		if ( it == m_graphBuffersMemory.end() )
+		{
+			return nullptr;
+		}
+
+		auto & block = m_memoryBlocks.at( it->second );
+
+		if ( !block.mapped )
+		{
+			auto res = context.vkMapMemory( context.device
+				, it->second
+				, 0u
+				, VK_WHOLE_SIZE
+				, 0u
+				, &block.mapped );
+			checkVkResult( res, bufferId.data->name + " - Buffer memory mapping" );
+		}
+
+		return block.mapped;
+	}
+
 	VkSampler ResourceHandler::createSampler( GraphContext & context
 		, std::string const & suffix
 		, SamplerDesc const & samplerDesc )
@@ -347,6 +644,8 @@ namespace crg
 					, context.allocator
 					, &vertexBuffer->memory );
 				checkVkResult( res, "Buffer memory allocation" );
+				m_buffersMemory[vertexBuffer] = { requirements, deduced };
+				doAddMemory( requirements.size );
 				crgRegisterObject( context, "QuadVertexMemory_" + suffix, vertexBuffer->memory );
 
 				res = context.vkBindBufferMemory( context.device
@@ -427,6 +726,13 @@ namespace crg
 				context.vkFreeMemory( context.device, it->second.second, context.allocator );
 			}
 
+			if ( auto memIt = m_imagesMemory.find( imageId );
+				memIt != m_imagesMemory.end() )
+			{
+				doRemoveMemory( memIt->second.requirements.size );
+				m_imagesMemory.erase( memIt );
+			}
+
 			if ( context.vkDestroyImage && it->second.first )
 			{
 				context.vkDestroyImage( context.device, it->second.first, context.allocator );
@@ -453,6 +759,57 @@ namespace crg
 		}
 	}
 
+	void ResourceHandler::destroyBuffer( GraphContext & context
+		, BufferId bufferId )
+	{
+		lock_type lock( m_buffersMutex );
+		auto it = m_graphBuffers.find( bufferId );
+
+		if ( it == m_graphBuffers.end() )
+		{
+			return;
+		}
+
+		if ( context.vkDestroyBuffer && it->second )
+		{
+			crgUnregisterObject( context, it->second );
+			context.vkDestroyBuffer( context.device
+				, it->second
+				, context.allocator );
+		}
+
+		it->second = VkBuffer{};
+
+		if ( auto memIt = m_graphBuffersMemory.find( bufferId );
+			memIt != m_graphBuffersMemory.end() )
+		{
+			auto blockIt = m_memoryBlocks.find( memIt->second );
+
+			if ( blockIt != m_memoryBlocks.end()
+				&& --blockIt->second.refCount == 0u )
+			{
+				doRemoveMemory( blockIt->second.memory.requirements.size );
+
+				if ( blockIt->second.mapped && context.vkUnmapMemory )
+				{
+					context.vkUnmapMemory( context.device, blockIt->first );
+				}
+
+				if ( context.vkFreeMemory )
+				{
+					crgUnregisterObject( context, blockIt->first );
+					context.vkFreeMemory( context.device
+						, blockIt->first
+						, context.allocator );
+				}
+
+				m_memoryBlocks.erase( blockIt );
+			}
+
+			m_graphBuffersMemory.erase( memIt );
+		}
+	}
+
 	void ResourceHandler::destroySampler( GraphContext & context
 		, VkSampler sampler )
 	{
@@ -488,6 +845,13 @@ namespace crg
 		{
 			auto & vertexBuffer = **it;
 
+			if ( auto memIt = m_buffersMemory.find( &vertexBuffer );
+				memIt != m_buffersMemory.end() )
+			{
+				doRemoveMemory( memIt->second.requirements.size );
+				m_buffersMemory.erase( memIt );
+			}
+
 			if ( context.vkFreeMemory && vertexBuffer.memory )
 			{
 				crgUnregisterObject( context, vertexBuffer.memory );
@@ -508,6 +872,110 @@ namespace crg
 		}
 	}
 
+	ResourceMemory ResourceHandler::getMemory( ImageId const & image )const
+	{
+		lock_type lock( m_imagesMutex );
+		auto it = m_imagesMemory.find( image );
+		return it == m_imagesMemory.end()
+			? ResourceMemory{}
+			: it->second;
+	}
+
+	ResourceMemory ResourceHandler::getMemory( VertexBuffer const & buffer )const
+	{
+		lock_type lock( m_buffersMutex );
+		auto it = m_buffersMemory.find( &buffer );
+		return it == m_buffersMemory.end()
+			? ResourceMemory{}
+			: it->second;
+	}
+
+	ResourceMemory ResourceHandler::getMemory( BufferId const & buffer )const
+	{
+		lock_type lock( m_buffersMutex );
+		auto it = m_graphBuffersMemory.find( buffer );
+
+		if ( it == m_graphBuffersMemory.end() )
+		{
+			return ResourceMemory{};
+		}
+
+		return m_memoryBlocks.at( it->second ).memory;
+	}
+
+	VkDeviceMemory ResourceHandler::getMemoryBlock( BufferId const & buffer )const
+	{
+		lock_type lock( m_buffersMutex );
+		auto it = m_graphBuffersMemory.find( buffer );
+		return it == m_graphBuffersMemory.end()
+			? VkDeviceMemory{}
+			: it->second;
+	}
+
+	MemoryStats ResourceHandler::getMemoryStats( BufferIdArray const & buffers )const
+	{
+		MemoryStats result;
+		lock_type lock( m_buffersMutex );
+		std::set< VkDeviceMemory > blocks;
+
+		for ( auto & buffer : buffers )
+		{
+			if ( auto it = m_graphBuffersMemory.find( buffer );
+				it != m_graphBuffersMemory.end() && blocks.insert( it->second ).second )
+			{
+				result.add( m_memoryBlocks.at( it->second ).memory );
+			}
+		}
+
+		return result;
+	}
+
+	MemoryStats ResourceHandler::getMemoryStats()const
+	{
+		MemoryStats result;
+		{
+			lock_type lock( m_imagesMutex );
+
+			for ( auto const & [_, memory] : m_imagesMemory )
+			{
+				result.add( memory );
+			}
+		}
+		{
+			lock_type lock( m_buffersMutex );
+
+			for ( auto const & [_, memory] : m_buffersMemory )
+			{
+				result.add( memory );
+			}
+
+			for ( auto const & [_, block] : m_memoryBlocks )
+			{
+				result.add( block.memory );
+			}
+		}
+		return result;
+	}
+
+	VkDeviceSize ResourceHandler::getPeakMemoryUsage()const
+	{
+		lock_type lock( m_memoryMutex );
+		return m_peakMemory;
+	}
+
+	void ResourceHandler::doAddMemory( VkDeviceSize size )
+	{
+		lock_type lock( m_memoryMutex );
+		m_currentMemory += size;
+		m_peakMemory = std::max( m_peakMemory, m_currentMemory );
+	}
+
+	void ResourceHandler::doRemoveMemory( VkDeviceSize size )
+	{
+		lock_type lock( m_memoryMutex );
+		m_currentMemory -= std::min( m_currentMemory, size );
+	}
+
 	//*********************************************************************************************
 
 	ContextResourcesCache::ContextResourcesCache( ResourceHandler & handler
@@ -519,6 +987,25 @@ namespace crg
 
 	ContextResourcesCache::~ContextResourcesCache()noexcept
 	{
+		// The render passes and framebuffers released since the last run are still pending.
+		m_context.delQueue.clear( m_context );
+
+		for ( auto const & [_, framebuffer] : m_framebuffers )
+		{
+			crgUnregisterObject( m_context, framebuffer.framebuffer );
+			m_context.vkDestroyFramebuffer( m_context.device
+				, framebuffer.framebuffer
+				, m_context.allocator );
+		}
+
+		for ( auto const & [_, renderPass] : m_renderPasses )
+		{
+			crgUnregisterObject( m_context, renderPass.renderPass );
+			m_context.vkDestroyRenderPass( m_context.device
+				, renderPass.renderPass
+				, m_context.allocator );
+		}
+
 		for ( auto const & [imageView, _] : m_imageViews )
 		{
 			m_handler.destroyImageView( m_context, imageView );
@@ -529,6 +1016,11 @@ namespace crg
 			m_handler.destroyImage( m_context, image );
 		}
 
+		for ( auto const & [buffer, _] : m_buffers )
+		{
+			m_handler.destroyBuffer( m_context, buffer );
+		}
+
 		for ( auto const & [_, sampler] : m_samplers )
 		{
 			m_handler.destroySampler( m_context, sampler );
@@ -540,9 +1032,10 @@ namespace crg
 		}
 	}
 
-	VkImage ContextResourcesCache::createImage( ImageId const & image )
+	VkImage ContextResourcesCache::createImage( ImageId const & image
+		, bool transient )
 	{
-		auto [result, created] = m_handler.createImage( m_context, image );
+		auto [result, created] = m_handler.createImage( m_context, image, transient );
 
 		if ( created )
 		{
@@ -584,12 +1077,47 @@ namespace crg
 
 		if ( result )
 		{
+			doDestroyFramebuffers( [view = it->second]( Framebuffer const & lookup )
+				{
+					return lookup.views.end() != std::find( lookup.views.begin(), lookup.views.end(), view );
+				} );
 			m_handler.destroyImageView( m_context, viewId );
 		}
 
 		return result;
 	}
 
+	VkBuffer ContextResourcesCache::createBuffer( BufferId const & bufferId )
+	{
+		auto result = m_handler.createBuffer( m_context, bufferId ).first;
+
+		if ( result )
+		{
+			m_buffers[bufferId] = result;
+		}
+
+		return result;
+	}
+
+	void ContextResourcesCache::bindBufferMemory( BufferIdArray const & buffers )
+	{
+		m_handler.bindBufferMemory( m_context, buffers );
+	}
+
+	bool ContextResourcesCache::destroyBuffer( BufferId const & bufferId )
+	{
+		auto it = m_buffers.find( bufferId );
+		auto result = it != m_buffers.end();
+
+		if ( result )
+		{
+			m_handler.destroyBuffer( m_context, bufferId );
+			m_buffers.erase( it );
+		}
+
+		return result;
+	}
+
 	VkSampler ContextResourcesCache::createSampler( SamplerDesc const & samplerDesc )
 	{
 		auto hash = reshdl::makeHash( samplerDesc );
@@ -622,6 +1150,204 @@ namespace crg
 		return *it->second;
 	}
 
+	MemoryStats ContextResourcesCache::getMemoryStats()const
+	{
+		MemoryStats result;
+
+		for ( auto const & [image, _] : m_images )
+		{
+			if ( auto memory = m_handler.getMemory( image );
+				memory.requirements.size )
+			{
+				result.add( memory );
+			}
+		}
+
+		for ( auto const & [_, buffer] : m_vertexBuffers )
+		{
+			if ( !buffer )
+			{
+				continue;
+			}
+
+			if ( auto memory = m_handler.getMemory( *buffer );
+				memory.requirements.size )
+			{
+				result.add( memory );
+			}
+		}
+
+		BufferIdArray buffers;
+
+		for ( auto const & [buffer, _] : m_buffers )
+		{
+			buffers.push_back( buffer );
+		}
+
+		auto buffersStats = m_handler.getMemoryStats( buffers );
+		result.size += buffersStats.size;
+		result.count += buffersStats.count;
+
+		for ( auto const & [type, size] : buffersStats.perMemoryType )
+		{
+			result.perMemoryType[type] += size;
+		}
+
+		return result;
+	}
+
+	VkFramebuffer ContextResourcesCache::createFramebuffer( std::string const & name
+		, VkRenderPass renderPass
+		, VkImageViewArray const & views
+		, VkExtent2D const & extent
+		, uint32_t layers )
+	{
+		auto hash = reshdl::makeHash( renderPass, views, extent, layers );
+		auto [begin, end] = m_framebuffers.equal_range( hash );
+		auto it = std::find_if( begin
+			, end
+			, [&renderPass, &views, &extent, layers]( std::pair< size_t const, Framebuffer > const & lookup )
+			{
+				return lookup.second.renderPass == renderPass
+					&& lookup.second.views == views
+					&& lookup.second.extent.width == extent.width
+					&& lookup.second.extent.height == extent.height
+					&& lookup.second.layers == layers;
+			} );
+
+		if ( it != end )
+		{
+			return it->second.framebuffer;
+		}
+
+		VkFramebufferCreateInfo createInfo{ VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO
+			, nullptr
+			, 0u
+			, renderPass
+			, uint32_t( views.size() )
+			, views.data()
+			, extent.width
+			, extent.height
+			, layers };
+		VkFramebuffer result{};
+		auto res = m_context.vkCreateFramebuffer( m_context.device
+			, &createInfo
+			, m_context.allocator
+			, &result );
+		checkVkResult( res, name + " - Framebuffer creation" );
+		crgRegisterObject( m_context, name, result );
+		m_framebuffers.emplace( hash, Framebuffer{ result, renderPass, views, extent, layers } );
+		return result;
+	}
+
+	void ContextResourcesCache::destroyFramebuffers( VkRenderPass renderPass )
+	{
+		std::vector< VkFramebuffer > framebuffers;
+		auto it = m_framebuffers.begin();
+
+		while ( it != m_framebuffers.end() )
+		{
+			if ( it->second.renderPass == renderPass )
+			{
+				framebuffers.push_back( it->second.framebuffer );
+				it = m_framebuffers.erase( it );
+			}
+			else
+			{
+				++it;
+			}
+		}
+
+		if ( framebuffers.empty() )
+		{
+			return;
+		}
+
+		m_context.delQueue.push( [framebuffers]( GraphContext & ctx )
+			{
+				for ( auto framebuffer : framebuffers )
+				{
+					crgUnregisterObject( ctx, framebuffer );
+					ctx.vkDestroyFramebuffer( ctx.device, framebuffer, ctx.allocator );
+				}
+			} );
+	}
+
+	VkRenderPass ContextResourcesCache::createRenderPass( std::string const & name
+		, VkRenderPassCreateInfo const & createInfo )
+	{
+		auto key = reshdl::makeKey( createInfo );
+		auto hash = reshdl::makeHash( key );
+		auto [begin, end] = m_renderPasses.equal_range( hash );
+		auto it = std::find_if( begin
+			, end
+			, [&key]( std::pair< size_t const, RenderPass > const & lookup )
+			{
+				return lookup.second.key == key;
+			} );
+
+		if ( it != end )
+		{
+			++it->second.refCount;
+			return it->second.renderPass;
+		}
+
+		VkRenderPass result{};
+		auto res = m_context.vkCreateRenderPass( m_context.device
+			, &createInfo
+			, m_context.allocator
+			, &result );
+		checkVkResult( res, name + " - RenderPass creation" );
+		crgRegisterObject( m_context, name, result );
+		m_renderPasses.emplace( hash, RenderPass{ result, std::move( key ), 1u } );
+		return result;
+	}
+
+	void ContextResourcesCache::destroyRenderPass( VkRenderPass renderPass )
+	{
+		auto it = std::find_if( m_renderPasses.begin()
+			, m_renderPasses.end()
+			, [renderPass]( std::pair< size_t const, RenderPass > const & lookup )
+			{
+				return lookup.second.renderPass == renderPass;
+			} );
+
+		if ( it == m_renderPasses.end()
+			|| --it->second.refCount > 0u )
+		{
+			return;
+		}
+
+		m_renderPasses.erase( it );
+		destroyFramebuffers( renderPass );
+		m_context.delQueue.push( [renderPass]( GraphContext & ctx )
+			{
+				crgUnregisterObject( ctx, renderPass );
+				ctx.vkDestroyRenderPass( ctx.device, renderPass, ctx.allocator );
+			} );
+	}
+
+	void ContextResourcesCache::doDestroyFramebuffers( std::function< bool( Framebuffer const & ) > const & predicate )
+	{
+		auto it = m_framebuffers.begin();
+
+		while ( it != m_framebuffers.end() )
+		{
+			if ( predicate( it->second ) )
+			{
+				crgUnregisterObject( m_context, it->second.framebuffer );
+				m_context.vkDestroyFramebuffer( m_context.device
+					, it->second.framebuffer
+					, m_context.allocator );
+				it = m_framebuffers.erase( it );
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+
 	//*********************************************************************************************
 
 	ResourcesCache::ResourcesCache( ResourceHandler & handler )
@@ -5,7 +5,9 @@ See LICENSE file in root folder.
 #include "RenderGraph/GraphVisitor.hpp"
 #include "RenderGraph/Log.hpp"
 #include "RenderGraph/ResourceHandler.hpp"
+#include "RenderGraph/RunnablePasses/RenderPassHolder.hpp"
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <string>
@@ -47,7 +49,7 @@ namespace crg
 			return result;
 		}
 
-		static LayerLayoutStates mergeRanges( LayerLayoutStatesMap nextLayouts
+		static LayerLayoutStates mergeRanges( LayerLayoutStatesMap const & nextLayouts
 			, LayerLayoutStatesMap::value_type const & currentLayout )
 		{
 			LayerLayoutStates result;
@@ -81,54 +83,673 @@ namespace crg
 			return result;
 		}
 
-		static LayerLayoutStatesMap gatherNextImageLayouts( LayerLayoutStatesMap currentLayouts
-			, std::vector< RunnablePassPtr >::iterator nextPassIt
-			, std::vector< RunnablePassPtr >::iterator endIt )
+		static PipelineState getNextState( PipelineState currentState
+			, std::vector< RunnablePassPtr >::const_iterator nextPassIt
+			, std::vector< RunnablePassPtr >::const_iterator endIt )
+		{
+			while ( endIt != nextPassIt
+				&& !( *nextPassIt )->isEnabled() )
+			{	
+				++nextPassIt;
+			}
+
+			return ( endIt != nextPassIt && ( *nextPassIt )->isEnabled() )
+				? ( *nextPassIt )->getPipelineState()
+				: currentState;
+		}
+
+		static std::vector< RunnablePassPtr >::const_iterator findRunnable( std::vector< RunnablePassPtr > const & passes
+			, RunnablePass const & runnable )
+		{
+			auto it = std::find_if( passes.begin()
+				, passes.end()
+				, [&runnable]( RunnablePassPtr const & lookup )
+				{
+					return lookup.get() == &runnable;
+				} );
+			assert( it != passes.end() );
+			return it;
+		}
+
+		static bool isRasterPass( FramePass const & pass )
+		{
+			auto hasTarget = std::any_of( pass.images.begin()
+				, pass.images.end()
+				, []( Attachment const & attach )
+				{
+					return attach.isColourAttach()
+						|| attach.isDepthAttach()
+						|| attach.isStencilAttach();
+				} );
+			auto hasOtherOutput = std::any_of( pass.images.begin()
+				, pass.images.end()
+				, []( Attachment const & attach )
+				{
+					return attach.isOutput()
+						&& ( attach.isStorageView() || attach.isTransferView() );
+				} )
+				|| std::any_of( pass.buffers.begin()
+					, pass.buffers.end()
+					, []( Attachment const & attach )
+					{
+						return attach.isOutput();
+					} );
+			return hasTarget && !hasOtherOutput;
+		}
+
+		static VkExtent3D getRenderExtent( FramePass const & pass )
 		{
-			LayerLayoutStatesMap result;
+			VkExtent3D result{};
+
+			for ( auto & attach : pass.images )
+			{
+				if ( attach.isColourAttach()
+					|| attach.isDepthAttach()
+					|| attach.isStencilAttach() )
+				{
+					auto view = attach.view();
+					auto mipLevel = view.data->info.subresourceRange.baseMipLevel;
+					result.width = std::max( result.width
+						, view.data->image.data->info.extent.width >> mipLevel );
+					result.height = std::max( result.height
+						, view.data->image.data->info.extent.height >> mipLevel );
+					result.depth = std::max( result.depth
+						, view.data->info.subresourceRange.layerCount );
+				}
+			}
+
+			return result;
+		}
+
+		static bool isTarget( Attachment const & attach )
+		{
+			return attach.isColourAttach()
+				|| attach.isDepthAttach()
+				|| attach.isStencilAttach();
+		}
+
+		static bool isSingleView( FramePass const & pass )
+		{
+			return std::all_of( pass.images.begin()
+				, pass.images.end()
+				, []( Attachment const & attach )
+				{
+					return attach.getViewCount() == 1u;
+				} );
+		}
+
+		static bool isSameTarget( Attachment const & lhsAttach
+			, Attachment const & rhsAttach )
+		{
+			return isTarget( lhsAttach )
+				&& isTarget( rhsAttach )
+				&& rhsAttach.isInput()
+				&& rhsAttach.view() == lhsAttach.view();
+		}
+
+		static bool isSamePixelRead( Attachment const & lhsAttach
+			, Attachment const & rhsAttach )
+		{
+			// The view is read as an input attachment, its image must allow it.
+			auto view = lhsAttach.view();
+			return lhsAttach.isColourAttach()
+				&& lhsAttach.isOutput()
+				&& rhsAttach.isSamePixelView()
+				&& rhsAttach.view() == view
+				&& ( view.data->image.data->info.usage & VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT ) != 0;
+		}
+
+		static bool canMerge( RenderPassChain const & chain
+			, FramePass const & rhs )
+		{
+			auto & lhs = *chain.front();
+
+			if ( !isRasterPass( lhs ) || !isRasterPass( rhs )
+				|| !isSingleView( lhs ) || !isSingleView( rhs ) )
+			{
+				return false;
+			}
+
+			auto lhsExtent = getRenderExtent( lhs );
+			auto rhsExtent = getRenderExtent( rhs );
+
+			if ( lhsExtent.width != rhsExtent.width
+				|| lhsExtent.height != rhsExtent.height
+				|| lhsExtent.depth != rhsExtent.depth )
+			{
+				return false;
+			}
 
-			while ( !currentLayouts.empty()
-				&& endIt != nextPassIt )
+			bool dependent{};
+
+			for ( auto pass : chain )
 			{
-				if ( auto const & nextPass = **nextPassIt;
-					nextPass.isEnabled() )
+				for ( auto & lhsAttach : pass->images )
 				{
-					auto & nextLayouts = nextPass.getImageLayouts();
-					LayerLayoutStates layoutStates;
-					auto currIt = std::find_if( currentLayouts.begin()
-						, currentLayouts.end()
-						, [&nextLayouts, &layoutStates]( LayerLayoutStatesMap::value_type const & lookup )
+					for ( auto & rhsAttach : rhs.images )
+					{
+						if ( rhsAttach.view().data->image != lhsAttach.view().data->image
+							|| ( !lhsAttach.isOutput() && !rhsAttach.isOutput() ) )
 						{
-							layoutStates = mergeRanges( nextLayouts, lookup );
-							return !layoutStates.empty();
-						} );
+							continue;
+						}
+
+						// Only a same pixel access to the previous outputs, through the render targets or input attachments, allows a subpass dependency.
+						if ( !isSameTarget( lhsAttach, rhsAttach )
+							&& !isSamePixelRead( lhsAttach, rhsAttach ) )
+						{
+							return false;
+						}
+
+						dependent = true;
+					}
+				}
+			}
+
+			return dependent;
+		}
+
+		static RenderPassChainArray findRenderPassChains( GraphNodePtrArray const & nodes )
+		{
+			RenderPassChainArray result;
+			RenderPassChain current;
 
-					if ( currIt != currentLayouts.end() )
+			for ( auto const & node : nodes )
+			{
+				auto pass = getFramePass( *node );
+
+				if ( !pass )
+				{
+					continue;
+				}
+
+				if ( !current.empty()
+					&& !canMerge( current, *pass ) )
+				{
+					if ( current.size() > 1u )
 					{
-						result.try_emplace( currIt->first, layoutStates );
-						currentLayouts.erase( currIt );
+						result.push_back( std::move( current ) );
 					}
+
+					current.clear();
 				}
-				
-				++nextPassIt;
+
+				current.push_back( pass );
+			}
+
+			if ( current.size() > 1u )
+			{
+				result.push_back( std::move( current ) );
 			}
 
 			return result;
 		}
 
-		static PipelineState getNextState( PipelineState currentState
-			, std::vector< RunnablePassPtr >::iterator nextPassIt
-			, std::vector< RunnablePassPtr >::iterator endIt )
+		static void listResources( FramePass const & pass
+			, std::set< ImageId > & images
+			, std::set< ImageViewId > & views )
 		{
-			while ( endIt != nextPassIt
-				&& !( *nextPassIt )->isEnabled() )
-			{	
-				++nextPassIt;
+			for ( auto & attach : pass.images )
+			{
+				for ( uint32_t i = 0u; i < attach.getViewCount(); ++i )
+				{
+					auto view = attach.view( i );
+					views.insert( view );
+					images.insert( view.data->image );
+
+					for ( auto & source : view.data->source )
+					{
+						views.insert( source );
+						images.insert( source.data->image );
+					}
+				}
 			}
+		}
 
-			return ( endIt != nextPassIt && ( *nextPassIt )->isEnabled() )
-				? ( *nextPassIt )->getPipelineState()
-				: currentState;
+		static void updateLifetime( ResourceLifetime & lifetime
+			, uint32_t index
+			, bool inserted )
+		{
+			if ( inserted )
+			{
+				lifetime.firstPass = index;
+			}
+
+			lifetime.lastPass = index;
+		}
+
+		static VkBufferUsageFlags getBufferUsage( Attachment const & attach )
+		{
+			VkBufferUsageFlags result{};
+
+			if ( attach.isUniformBufferView() )
+			{
+				result |= VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT;
+			}
+			else if ( attach.isUniformBuffer() )
+			{
+				result |= VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+			}
+
+			if ( attach.isStorageBufferView() )
+			{
+				result |= VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT;
+			}
+			else if ( attach.isStorageBuffer() )
+			{
+				result |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+			}
+
+			if ( attach.isTransferInputBuffer() )
+			{
+				result |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+			}
+
+			if ( attach.isTransferOutputBuffer() )
+			{
+				result |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+			}
+
+			return result;
+		}
+
+		static ResourceLifetimes computeLifetimes( GraphNodePtrArray const & nodes )
+		{
+			ResourceLifetimes result;
+
+			for ( auto const & node : nodes )
+			{
+				auto pass = getFramePass( *node );
+
+				if ( !pass )
+				{
+					continue;
+				}
+
+				auto index = uint32_t( result.passes.size() );
+				result.passes.push_back( pass );
+				std::set< ImageId > images;
+				std::set< ImageViewId > views;
+				listResources( *pass, images, views );
+
+				for ( auto & image : images )
+				{
+					auto [it, ins] = result.images.try_emplace( image );
+					updateLifetime( it->second, index, ins );
+
+					if ( ins )
+					{
+						it->second.name = image.data->name;
+						it->second.usage = image.data->info.usage;
+					}
+				}
+
+				for ( auto & view : views )
+				{
+					auto [it, ins] = result.views.try_emplace( view );
+					updateLifetime( it->second, index, ins );
+
+					if ( ins )
+					{
+						it->second.name = view.data->name;
+						it->second.usage = view.data->image.data->info.usage;
+					}
+				}
+
+				for ( auto & attach : pass->buffers )
+				{
+					auto & bufferAttach = attach.bufferAttach;
+
+					for ( uint32_t i = 0u; i < attach.getBufferCount(); ++i )
+					{
+						auto [it, ins] = result.buffers.try_emplace( attach.buffer( i ) );
+						updateLifetime( it->second, index, ins );
+
+						if ( ins )
+						{
+							it->second.name = bufferAttach.buffer.name;
+						}
+
+						if ( bufferAttach.range.size != VK_WHOLE_SIZE )
+						{
+							it->second.size = std::max( it->second.size
+								, bufferAttach.range.offset + bufferAttach.range.size );
+						}
+
+						it->second.usage |= getBufferUsage( attach );
+					}
+				}
+			}
+
+			return result;
+		}
+
+		static bool isTransientAttach( Attachment const & attach )
+		{
+			if ( !attach.isImage()
+				|| attach.isInput()
+				|| attach.imageAttach.isStencilInputAttach() )
+			{
+				return false;
+			}
+
+			if ( attach.isColourAttach() || attach.isDepthAttach() )
+			{
+				return attach.getLoadOp() != VK_ATTACHMENT_LOAD_OP_LOAD
+					&& ( !attach.isStencilAttach()
+						|| attach.getStencilLoadOp() != VK_ATTACHMENT_LOAD_OP_LOAD );
+			}
+
+			return attach.isStencilAttach()
+				&& attach.getStencilLoadOp() != VK_ATTACHMENT_LOAD_OP_LOAD;
+		}
+
+		static std::set< ImageId > findTransientImages( ResourceLifetimes const & lifetimes
+			, FrameGraph const & graph
+			, std::set< ImageViewId > const & graphViews )
+		{
+			std::set< ImageId > result;
+
+			for ( auto const & [image, lifetime] : lifetimes.images )
+			{
+				if ( lifetime.firstPass == lifetime.lastPass )
+				{
+					result.insert( image );
+				}
+			}
+
+			// Content accessed outside of the graph must stay in memory.
+			for ( auto const & view : graphViews )
+			{
+				if ( graph.getOutputLayoutState( view ).layout != VK_IMAGE_LAYOUT_UNDEFINED
+					|| graph.getInputLayoutState( view ).layout != VK_IMAGE_LAYOUT_UNDEFINED )
+				{
+					result.erase( view.data->image );
+				}
+			}
+
+			// The only pass using the image must use it as a render target that doesn't load its content.
+			for ( auto const & [image, lifetime] : lifetimes.images )
+			{
+				if ( result.end() == result.find( image ) )
+				{
+					continue;
+				}
+
+				auto pass = lifetimes.passes[lifetime.firstPass];
+				bool transient = true;
+
+				for ( auto & attach : pass->images )
+				{
+					for ( uint32_t i = 0u; i < attach.getViewCount() && transient; ++i )
+					{
+						auto view = attach.view( i );
+						transient = ( view.data->image != image
+								&& std::none_of( view.data->source.begin()
+									, view.data->source.end()
+									, [&image]( ImageViewId const & lookup )
+									{
+										return lookup.data->image == image;
+									} ) )
+							|| isTransientAttach( attach );
+					}
+				}
+
+				if ( !transient )
+				{
+					result.erase( image );
+				}
+			}
+
+			return result;
+		}
+
+		static AccessState getBufferAccess( FramePass const & pass
+			, VkBuffer buffer
+			, bool & read )
+		{
+			AccessState result{ 0u, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT };
+			read = false;
+
+			for ( auto & attach : pass.buffers )
+			{
+				for ( uint32_t i = 0u; i < attach.getBufferCount(); ++i )
+				{
+					if ( attach.buffer( i ) == buffer )
+					{
+						result.access |= attach.getAccessMask();
+						read = read || attach.isInput();
+					}
+				}
+			}
+
+			return result;
+		}
+
+		struct BufferAlias
+		{
+			BufferId buffer;
+			VkBuffer handle;
+			uint32_t firstPass;
+			uint32_t lastPass;
+		};
+		using BufferAliasArray = std::vector< BufferAlias >;
+
+		static std::vector< BufferAliasArray > findBufferAliases( BufferIdArray const & buffers
+			, ResourceHandler & handler
+			, ResourceLifetimes const & lifetimes )
+		{
+			std::vector< BufferAliasArray > result;
+			BufferAliasArray candidates;
+
+			for ( auto & buffer : buffers )
+			{
+				auto handle = *handler.getBufferHandle( buffer );
+				auto it = lifetimes.buffers.find( handle );
+
+				if ( it == lifetimes.buffers.end() )
+				{
+					result.push_back( { BufferAlias{ buffer, handle, 0u, 0u } } );
+					continue;
+				}
+
+				bool read{};
+				getBufferAccess( *lifetimes.passes[it->second.firstPass], handle, read );
+
+				// Content read before being written must be kept from one frame to the next.
+				candidates.push_back( read
+					? BufferAlias{ buffer, handle, 0u, uint32_t( lifetimes.passes.size() ) }
+					: BufferAlias{ buffer, handle, it->second.firstPass, it->second.lastPass } );
+			}
+
+			std::stable_sort( candidates.begin()
+				, candidates.end()
+				, []( BufferAlias const & lhs, BufferAlias const & rhs )
+				{
+					return lhs.firstPass < rhs.firstPass;
+				} );
+			std::vector< BufferAliasArray > aliases;
+
+			for ( auto & candidate : candidates )
+			{
+				auto it = std::find_if( aliases.begin()
+					, aliases.end()
+					, [&candidate]( BufferAliasArray const & lookup )
+					{
+						return lookup.back().lastPass < candidate.firstPass
+							&& lookup.back().buffer.data->memory == candidate.buffer.data->memory;
+					} );
+
+				if ( it == aliases.end() )
+				{
+					aliases.push_back( { candidate } );
+				}
+				else
+				{
+					it->push_back( candidate );
+				}
+			}
+
+			result.insert( result.end(), aliases.begin(), aliases.end() );
+			return result;
+		}
+
+		struct ImageViewAccess
+		{
+			size_t index;
+			FramePass const * pass;
+			ImageViewId view;
+			ImageViewId subView;
+			bool read;
+			bool write;
+		};
+
+		static bool isContained( uint32_t lhsLBound
+			, uint32_t lhsCount
+			, uint32_t rhsLBound
+			, uint32_t rhsCount )
+		{
+			return lhsLBound >= rhsLBound
+				&& lhsLBound + lhsCount <= rhsLBound + rhsCount;
+		}
+
+		static VkImageSubresourceRange getVirtualRange( ImageViewId const & view )
+		{
+			return crg::getVirtualRange( view.data->image
+				, view.data->info.viewType
+				, view.data->info.subresourceRange );
+		}
+
+
+		static bool isCovering( ImageViewId const & lhs
+			, ImageViewId const & rhs )
+		{
+			auto lhsRange = getVirtualRange( lhs );
+			auto rhsRange = getVirtualRange( rhs );
+			return lhs.data->image == rhs.data->image
+				&& isContained( rhsRange.baseMipLevel, rhsRange.levelCount
+					, lhsRange.baseMipLevel, lhsRange.levelCount )
+				&& isContained( rhsRange.baseArrayLayer, rhsRange.layerCount
+					, lhsRange.baseArrayLayer, lhsRange.layerCount );
+		}
+
+		static std::vector< ImageViewAccess > listImageAccesses( GraphNodePtrArray const & nodes )
+		{
+			std::vector< ImageViewAccess > result;
+			size_t index{};
+
+			for ( auto const & node : nodes )
+			{
+				auto pass = getFramePass( *node );
+
+				if ( !pass )
+				{
+					continue;
+				}
+
+				for ( auto & attach : pass->images )
+				{
+					for ( uint32_t i = 0u; i < attach.getViewCount(); ++i )
+					{
+						auto view = attach.view( i );
+
+						if ( view.data->source.empty() )
+						{
+							result.push_back( { index, pass, view, view, attach.isInput(), attach.isOutput() } );
+						}
+						else
+						{
+							for ( auto & source : view.data->source )
+							{
+								result.push_back( { index, pass, view, source, attach.isInput(), attach.isOutput() } );
+							}
+						}
+					}
+				}
+
+				++index;
+			}
+
+			return result;
+		}
+
+		static bool isInSameChain( RenderPassChainArray const & chains
+			, FramePass const * lhs
+			, FramePass const * rhs )
+		{
+			return std::any_of( chains.begin()
+				, chains.end()
+				, [lhs, rhs]( RenderPassChain const & chain )
+				{
+					return chain.end() != std::find( chain.begin(), chain.end(), lhs )
+						&& chain.end() != std::find( chain.begin(), chain.end(), rhs );
+				} );
+		}
+
+		static std::set< std::pair< FramePass const *, ImageViewId > > findUnconsumedOutputs( GraphNodePtrArray const & nodes
+			, RenderPassChainArray const & ignoredChains )
+		{
+			auto accesses = listImageAccesses( nodes );
+			// Reads that happen before any write of their whole range, in execution order,
+			// access the content written during the previous run of the graph.
+			std::vector< ImageViewAccess const * > wrappingReads;
+
+			for ( auto & read : accesses )
+			{
+				if ( read.read
+					&& std::none_of( accesses.begin()
+						, accesses.end()
+						, [&read]( ImageViewAccess const & lookup )
+						{
+							return lookup.write
+								&& lookup.index < read.index
+								&& isCovering( lookup.subView, read.subView );
+						} ) )
+				{
+					wrappingReads.push_back( &read );
+				}
+			}
+
+			std::set< std::pair< FramePass const *, ImageViewId > > consumed;
+			std::set< std::pair< FramePass const *, ImageViewId > > result;
+
+			for ( auto & write : accesses )
+			{
+				if ( !write.write )
+				{
+					continue;
+				}
+
+				// The reads by the next passes of an ignored chain don't count.
+				auto isConsumed = std::any_of( accesses.begin()
+						, accesses.end()
+						, [&write, &ignoredChains]( ImageViewAccess const & lookup )
+						{
+							return lookup.read
+								&& lookup.index > write.index
+								&& !isInSameChain( ignoredChains, lookup.pass, write.pass )
+								&& isOverlapping( *lookup.subView.data, *write.subView.data );
+						} )
+					|| std::any_of( wrappingReads.begin()
+						, wrappingReads.end()
+						, [&write]( ImageViewAccess const * lookup )
+						{
+							return isOverlapping( *lookup->subView.data, *write.subView.data );
+						} );
+				auto key = std::make_pair( write.pass, write.view );
+
+				if ( isConsumed )
+				{
+					consumed.insert( key );
+					result.erase( key );
+				}
+				else if ( consumed.end() == consumed.find( key ) )
+				{
+					result.insert( key );
+				}
+			}
+
+			return result;
 		}
 	}
 
@@ -195,52 +816,156 @@ namespace crg
 	{
 		auto name = m_graph.getName() + "/Graph";
 
-		if ( m_context.vkCreateSemaphore )
+		if ( m_context.vkCreateSemaphore )
+		{
+			VkSemaphoreCreateInfo createInfo{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO
+				, nullptr
+				, 0u };
+			auto res = context.vkCreateSemaphore( m_context.device
+				, &createInfo
+				, m_context.allocator
+				, &m_semaphore );
+			checkVkResult( res, name + " - Semaphore creation" );
+			crgRegisterObject( m_context, name, m_semaphore );
+		}
+
+		if ( m_context.vkAllocateCommandBuffers )
+		{
+			VkCommandBufferAllocateInfo allocateInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO
+				, nullptr
+				, getCommandPool()
+				, VK_COMMAND_BUFFER_LEVEL_PRIMARY
+				, 1u };
+			auto res = m_context.vkAllocateCommandBuffers( m_context.device
+				, &allocateInfo
+				, &m_commandBuffer );
+			checkVkResult( res, name + " - CommandBuffer allocation" );
+			crgRegisterObject( m_context, name, m_commandBuffer );
+
+			VkCommandBufferBeginInfo beginInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO
+				, nullptr
+				, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+				, nullptr };
+			m_context.vkBeginCommandBuffer( m_commandBuffer, &beginInfo );
+			m_context.vkEndCommandBuffer( m_commandBuffer );
+		}
+
+		Logger::logDebug( m_graph.getName() + " - Initialising resources" );
+
+		// Resources only used by culled passes are not created.
+		FramePassArray allPasses;
+		m_graph.m_defaultGroup->listPasses( allPasses );
+		std::set< ImageId > allImages;
+		std::set< ImageViewId > allViews;
+		std::set< ImageId > usedImages;
+		std::set< ImageViewId > usedViews;
+
+		for ( auto pass : allPasses )
+		{
+			rungrf::listResources( *pass, allImages, allViews );
+		}
+
+		for ( auto const & node : m_nodes )
+		{
+			if ( auto pass = getFramePass( *node ) )
+			{
+				rungrf::listResources( *pass, usedImages, usedViews );
+			}
+		}
+
+		m_lifetimes = rungrf::computeLifetimes( m_nodes );
+		auto transientImages = ( m_graph.hasTransientAttachments()
+			? rungrf::findTransientImages( m_lifetimes, m_graph, m_graph.m_imageViews )
+			: std::set< ImageId >{} );
+
+		for ( auto & img : m_graph.m_images )
+		{
+			if ( usedImages.end() != usedImages.find( img )
+				|| allImages.end() == allImages.find( img ) )
+			{
+				m_resources.createImage( img
+					, transientImages.end() != transientImages.find( img ) );
+			}
+		}
+
+		for ( auto & view : m_graph.m_imageViews )
+		{
+			if ( usedViews.end() != usedViews.find( view )
+				|| allViews.end() == allViews.find( view ) )
+			{
+				m_resources.createImageView( view );
+			}
+		}
+
+		BufferIdArray graphBuffers;
+
+		for ( auto & buffer : m_graph.m_buffers )
+		{
+			if ( m_resources.createBuffer( buffer ) )
+			{
+				graphBuffers.push_back( buffer );
+			}
+		}
+
+		for ( auto & aliases : rungrf::findBufferAliases( graphBuffers, m_resources.getHandler(), m_lifetimes ) )
+		{
+			BufferIdArray ids;
+
+			for ( auto & alias : aliases )
+			{
+				ids.push_back( alias.buffer );
+
+				if ( auto it = m_lifetimes.buffers.find( alias.handle );
+					it != m_lifetimes.buffers.end() )
+				{
+					it->second.size = alias.buffer.data->info.size;
+					it->second.usage = alias.buffer.data->info.usage;
+				}
+			}
+
+			m_resources.bindBufferMemory( ids );
+
+			// Each buffer's first access must wait for the accesses to the buffer previously using the memory.
+			for ( size_t i = 0u; aliases.size() > 1u && i < aliases.size(); ++i )
+			{
+				auto & prev = aliases[( i + aliases.size() - 1u ) % aliases.size()];
+				bool read{};
+				m_aliasStates.emplace( aliases[i].handle
+					, rungrf::getBufferAccess( *m_lifetimes.passes[prev.lastPass], prev.handle, read ) );
+			}
+		}
+
+		for ( auto & [buffer, provider] : m_graph.m_frameDataProviders )
 		{
-			VkSemaphoreCreateInfo createInfo{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO
-				, nullptr
-				, 0u };
-			auto res = context.vkCreateSemaphore( m_context.device
-				, &createInfo
-				, m_context.allocator
-				, &m_semaphore );
-			checkVkResult( res, name + " - Semaphore creation" );
-			crgRegisterObject( m_context, name, m_semaphore );
+			m_frameData.emplace_back( &provider, buffer );
 		}
 
-		if ( m_context.vkAllocateCommandBuffers )
+		for ( auto & [image, lifetime] : m_lifetimes.images )
 		{
-			VkCommandBufferAllocateInfo allocateInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO
-				, nullptr
-				, getCommandPool()
-				, VK_COMMAND_BUFFER_LEVEL_PRIMARY
-				, 1u };
-			auto res = m_context.vkAllocateCommandBuffers( m_context.device
-				, &allocateInfo
-				, &m_commandBuffer );
-			checkVkResult( res, name + " - CommandBuffer allocation" );
-			crgRegisterObject( m_context, name, m_commandBuffer );
-
-			VkCommandBufferBeginInfo beginInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO
-				, nullptr
-				, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
-				, nullptr };
-			m_context.vkBeginCommandBuffer( m_commandBuffer, &beginInfo );
-			m_context.vkEndCommandBuffer( m_commandBuffer );
+			lifetime.size = m_resources.getHandler().getMemory( image ).requirements.size;
 		}
 
-		Logger::logDebug( m_graph.getName() + " - Initialising resources" );
-
-		for ( auto & img : m_graph.m_images )
+		for ( auto & [view, lifetime] : m_lifetimes.views )
 		{
-			m_resources.createImage( img );
+			lifetime.size = m_resources.getHandler().getMemory( view.data->image ).requirements.size;
 		}
 
-		for ( auto & view : m_graph.m_imageViews )
+		m_renderPassChains = rungrf::findRenderPassChains( m_nodes );
+
+		for ( auto & chain : m_renderPassChains )
 		{
-			m_resources.createImageView( view );
+			std::string names;
+
+			for ( auto pass : chain )
+			{
+				names += ( names.empty() ? std::string{} : std::string{ ", " } ) + pass->getGroupName();
+			}
+
+			Logger::logDebug( m_graph.getName() + " - Subpass merge candidates: " + names );
 		}
 
+		m_unconsumedOutputs = rungrf::findUnconsumedOutputs( m_nodes, {} );
+
 		Logger::logDebug( m_graph.getName() + " - Creating runnable passes" );
 
 		for ( auto const & node : m_nodes )
@@ -253,6 +978,7 @@ namespace crg
 			}
 		}
 
+		doMergeSubpasses();
 		Logger::logDebug( m_graph.getName() + " - Initialising passes" );
 
 		for ( auto const & pass : m_passes )
@@ -262,6 +988,8 @@ namespace crg
 				pass->initialise( pass->getIndex() );
 			}
 		}
+
+		doBuildNextImageLayouts();
 	}
 
 	RunnableGraph::~RunnableGraph()noexcept
@@ -274,6 +1002,8 @@ namespace crg
 				, m_context.allocator );
 		}
 
+		doDestroyVariants();
+
 		if ( m_context.vkFreeCommandBuffers && m_commandBuffer )
 		{
 			crgUnregisterObject( m_context, m_commandBuffer );
@@ -285,6 +1015,151 @@ namespace crg
 	}
 
 	void RunnableGraph::record()
+	{
+		m_graph.registerFinalState( doRecordInto( m_commandBuffer
+			, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT ) );
+	}
+
+	void RunnableGraph::setMaxVariants( uint32_t count )
+	{
+		m_maxVariants = count;
+		m_variantsDirty = true;
+	}
+
+	void RunnableGraph::invalidateVariants()noexcept
+	{
+		m_variantsDirty = true;
+	}
+
+	void RunnableGraph::doMergeSubpasses()
+	{
+		RenderPassChainArray merged;
+
+		for ( auto const & chain : m_renderPassChains )
+		{
+			std::vector< RenderPassHolder::Subpass > subpasses;
+			auto flush = [&merged, &subpasses]()
+			{
+				if ( subpasses.size() > 1u )
+				{
+					RenderPassChain passes;
+
+					for ( auto & subpass : subpasses )
+					{
+						passes.push_back( &subpass.runnable->getPass() );
+					}
+
+					subpasses.front().holder->mergeSubpasses( subpasses );
+					merged.push_back( std::move( passes ) );
+				}
+
+				subpasses.clear();
+			};
+
+			// A chain is split at the passes that can't be recorded within a render pass begun by a previous pass.
+			for ( auto pass : chain )
+			{
+				if ( auto it = m_subpasses.find( pass );
+					it != m_subpasses.end()
+					&& !it->second.second->isDynamicRendering()
+					&& it->second.first->getMaxPassCount() == 1u
+					&& !it->second.first->hasPassActions() )
+				{
+					subpasses.push_back( { it->second.first, it->second.second } );
+				}
+				else
+				{
+					flush();
+				}
+			}
+
+			flush();
+		}
+
+		m_renderPassChains = std::move( merged );
+		m_unconsumedMergedOutputs = rungrf::findUnconsumedOutputs( m_nodes, m_renderPassChains );
+
+		for ( auto & chain : m_renderPassChains )
+		{
+			std::string names;
+
+			for ( auto pass : chain )
+			{
+				names += ( names.empty() ? std::string{} : std::string{ ", " } ) + pass->getGroupName();
+			}
+
+			Logger::logDebug( m_graph.getName() + " - Merged subpasses: " + names );
+		}
+	}
+
+	void RunnableGraph::doBuildNextImageLayouts()
+	{
+		m_nextImageLayouts.resize( m_passes.size() );
+
+		for ( size_t index = 0u; index < m_passes.size(); ++index )
+		{
+			auto & next = m_nextImageLayouts[index];
+			LayerLayoutStatesMap layouts;
+
+			for ( auto const & currentLayout : m_passes[index]->getImageLayouts() )
+			{
+				std::vector< NextImageUse > uses;
+
+				for ( auto nextIndex = index + 1u; nextIndex < m_passes.size(); ++nextIndex )
+				{
+					if ( auto states = rungrf::mergeRanges( m_passes[nextIndex]->getImageLayouts(), currentLayout );
+						!states.empty() )
+					{
+						uses.push_back( { uint32_t( nextIndex ), std::move( states ) } );
+					}
+				}
+
+				if ( !uses.empty() )
+				{
+					layouts.try_emplace( currentLayout.first, uses.front().states );
+					next.uses.try_emplace( currentLayout.first, std::move( uses ) );
+				}
+			}
+
+			next.layouts = std::make_shared< LayerLayoutStatesHandler const >( layouts );
+		}
+	}
+
+	std::shared_ptr< LayerLayoutStatesHandler const > RunnableGraph::doGetNextImageLayouts( size_t index )const
+	{
+		auto const & next = m_nextImageLayouts[index];
+		auto isEnabled = [this]( NextImageUse const & lookup )
+		{
+			return m_passes[lookup.pass]->isEnabled();
+		};
+
+		if ( std::all_of( next.uses.begin()
+			, next.uses.end()
+			, [&isEnabled]( auto const & lookup )
+			{
+				return isEnabled( lookup.second.front() );
+			} ) )
+		{
+			return next.layouts;
+		}
+
+		// Some of the next users are disabled, the layouts are patched with the first enabled ones.
+		LayerLayoutStatesMap layouts;
+
+		for ( auto const & [image, uses] : next.uses )
+		{
+			if ( auto it = std::find_if( uses.begin(), uses.end(), isEnabled );
+				it != uses.end() )
+			{
+				layouts.try_emplace( image, it->states );
+			}
+		}
+
+		return std::make_shared< LayerLayoutStatesHandler const >( layouts );
+	}
+
+	RecordContext RunnableGraph::doRecordInto( VkCommandBuffer commandBuffer
+		, VkCommandBufferUsageFlags usage )
 	{
 		auto block( m_timer.start() );
 		m_states.clear();
@@ -297,6 +1172,11 @@ namespace crg
 				, dependency->getFinalStates().getIndexState() );
 		}
 
+		for ( auto & [buffer, state] : m_aliasStates )
+		{
+			recordContext.setAccessState( buffer, { 0u, VK_WHOLE_SIZE }, state );
+		}
+
 		auto itGraph = m_states.try_emplace( &m_graph ).first;
 		itGraph->second.resize( m_passes.size() );
 
@@ -308,23 +1188,25 @@ namespace crg
 				, ( *currPass )->getImageLayouts() );
 			auto nextPass = std::next( currPass );
 			m_fence.wait( 0xFFFFFFFFFFFFFFFFULL );
-			m_context.vkResetCommandBuffer( m_commandBuffer, 0u );
+			m_context.vkResetCommandBuffer( commandBuffer, 0u );
 			VkCommandBufferBeginInfo beginInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO
 				, nullptr
-				, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+				, usage
 				, nullptr };
-			m_context.vkBeginCommandBuffer( m_commandBuffer, &beginInfo );
-			m_timer.beginPass( m_commandBuffer );
+			m_context.vkBeginCommandBuffer( commandBuffer, &beginInfo );
+			m_timer.beginPass( commandBuffer );
+			m_recording = true;
 
 			while ( currPass != m_passes.end() )
 			{
 				auto const & pass = *currPass;
+				auto index = size_t( std::distance( m_passes.begin(), currPass ) );
 				++currPass;
 
 				if ( nextPass != m_passes.end() )
 				{
 					recordContext.setNextPipelineState( rungrf::getNextState( pass->getPipelineState(), nextPass, m_passes.end() )
-						, rungrf::gatherNextImageLayouts( pass->getImageLayouts(), nextPass, m_passes.end() ) );
+						, doGetNextImageLayouts( index ) );
 					++nextPass;
 				}
 				else
@@ -333,15 +1215,142 @@ namespace crg
 						, m_graph.getOutputLayoutStates() );
 				}
 
-				*it = pass->recordCurrentInto( recordContext, m_commandBuffer );
+				*it = pass->recordCurrentInto( recordContext, commandBuffer );
 				++it;
 			}
 
-			m_timer.endPass( m_commandBuffer );
-			m_context.vkEndCommandBuffer( m_commandBuffer );
+			m_recording = false;
+
+			m_timer.endPass( commandBuffer );
+			m_context.vkEndCommandBuffer( commandBuffer );
+		}
+
+		m_elidedBarriers = recordContext.getElidedBarriersCount();
+		return recordContext;
+	}
+
+	RecordContext::PassIndexArray RunnableGraph::doGetVariantKey()const
+	{
+		// The initial states depend on the previous run, hence its indices are part of the key.
+		RecordContext::PassIndexArray result{ m_lastIndices };
+		result.push_back( uint32_t( m_lastIndices.size() ) );
+
+		for ( auto & pass : m_passes )
+		{
+			result.push_back( pass->getIndex() );
+		}
+
+		for ( auto & dependency : m_graph.getDependencies() )
+		{
+			auto & indices = dependency->getFinalStates().getIndexState();
+			result.insert( result.end(), indices.begin(), indices.end() );
+			result.push_back( uint32_t( indices.size() ) );
+		}
+
+		return result;
+	}
+
+	VkCommandBuffer RunnableGraph::doGetVariant()
+	{
+		m_fence.wait( 0xFFFFFFFFFFFFFFFFULL );
+
+		if ( m_variantsDirty )
+		{
+			doDestroyVariants();
+			m_variantsDirty = false;
+		}
+
+		auto key = doGetVariantKey();
+		m_lastIndices.clear();
+
+		for ( auto & pass : m_passes )
+		{
+			m_lastIndices.push_back( pass->getIndex() );
+		}
+
+		auto it = std::find_if( m_variants.begin()
+			, m_variants.end()
+			, [&key]( Variant const & lookup )
+			{
+				return lookup.key == key;
+			} );
+
+		if ( it != m_variants.end()
+			&& it->reusable )
+		{
+			m_states = it->states;
+			m_graph.registerFinalState( it->finalState );
+			return it->commandBuffer;
+		}
+
+		if ( it == m_variants.end() )
+		{
+			if ( m_variants.size() >= m_maxVariants
+				|| !m_context.vkAllocateCommandBuffers )
+			{
+				record();
+				return m_commandBuffer;
+			}
+
+			VkCommandBuffer commandBuffer{};
+			VkCommandBufferAllocateInfo allocateInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO
+				, nullptr
+				, getCommandPool()
+				, VK_COMMAND_BUFFER_LEVEL_PRIMARY
+				, 1u };
+			auto name = m_graph.getName() + "/Variant" + std::to_string( m_variants.size() );
+			auto res = m_context.vkAllocateCommandBuffers( m_context.device
+				, &allocateInfo
+				, &commandBuffer );
+			checkVkResult( res, name + " - CommandBuffer allocation" );
+			crgRegisterObject( m_context, name, commandBuffer );
+			it = m_variants.insert( m_variants.end()
+				, Variant{ std::move( key ), commandBuffer, RecordContext{ m_resources }, {}, false } );
 		}
 
+		// Commands recorded while a pass can't record its final commands (or while a pass is being reset) are not reused.
+		auto recordContext = doRecordInto( it->commandBuffer, 0u );
+		it->reusable = !recordContext.isVolatile() && !m_variantsDirty;
+		it->states = m_states;
+		it->finalState = recordContext;
 		m_graph.registerFinalState( recordContext );
+		return it->commandBuffer;
+	}
+
+	void RunnableGraph::doDestroyVariants()
+	{
+		for ( auto & variant : m_variants )
+		{
+			if ( m_context.vkFreeCommandBuffers && variant.commandBuffer )
+			{
+				crgUnregisterObject( m_context, variant.commandBuffer );
+				m_context.vkFreeCommandBuffers( m_context.device
+					, getCommandPool()
+					, 1u
+					, &variant.commandBuffer );
+			}
+		}
+
+		m_variants.clear();
+	}
+
+	void RunnableGraph::doWriteFrameData()
+	{
+		if ( m_frameData.empty() )
+		{
+			return;
+		}
+
+		// The previous submission must be over before its data is overwritten.
+		m_fence.wait( 0xFFFFFFFFFFFFFFFFULL );
+
+		for ( auto & [provider, buffer] : m_frameData )
+		{
+			if ( auto data = m_resources.getHandler().mapBufferMemory( m_context, buffer ) )
+			{
+				( *provider )( data, buffer.data->info.size );
+			}
+		}
 	}
 
 	SemaphoreWaitArray RunnableGraph::run( VkQueue queue )
@@ -362,7 +1371,18 @@ namespace crg
 	SemaphoreWaitArray RunnableGraph::run( SemaphoreWaitArray const & toWait
 		, VkQueue queue )
 	{
-		record();
+		auto commandBuffer = m_commandBuffer;
+
+		if ( m_maxVariants )
+		{
+			commandBuffer = doGetVariant();
+		}
+		else
+		{
+			record();
+		}
+
+		doWriteFrameData();
 		std::vector< VkSemaphore > semaphores;
 		std::vector< VkPipelineStageFlags > dstStageMasks;
 		convert( toWait, semaphores, dstStageMasks );
@@ -379,7 +1399,7 @@ namespace crg
 			, semaphores.data()
 			, dstStageMasks.data()
 			, 1u
-			, &m_commandBuffer
+			, &commandBuffer
 			, 1u
 			, &m_semaphore };
 		m_fence.reset();
@@ -476,8 +1496,134 @@ namespace crg
 		return result;
 	}
 
+	LayoutState RunnableGraph::getNextLayoutState( crg::RunnablePass const & runnable
+		, ImageViewId view )const
+	{
+		auto it = rungrf::findRunnable( m_passes, runnable );
+		auto result = doGetNextImageLayouts( size_t( std::distance( m_passes.begin(), it ) ) )->getLayoutState( view );
+
+		if ( result.layout == VK_IMAGE_LAYOUT_UNDEFINED )
+		{
+			// Next layout undefined means that there is no pass after this one in the graph.
+			result = getOutputLayoutState( view );
+		}
+
+		if ( result.layout == VK_IMAGE_LAYOUT_UNDEFINED )
+		{
+			// Prevent from outputing a VK_IMAGE_LAYOUT_UNDEFINED anyway.
+			result = runnable.getLayoutState( view );
+		}
+
+		return result;
+	}
+
+	PipelineState RunnableGraph::getNextPipelineState( crg::RunnablePass const & runnable )const
+	{
+		auto it = rungrf::findRunnable( m_passes, runnable );
+		return rungrf::getNextState( runnable.getPipelineState()
+			, std::next( it )
+			, m_passes.end() );
+	}
+
+	void RunnableGraph::registerSubpass( RunnablePass & runnable
+		, RenderPassHolder & holder )
+	{
+		m_subpasses.try_emplace( &runnable.getPass(), &runnable, &holder );
+	}
+
 	LayoutState RunnableGraph::getOutputLayoutState( ImageViewId view )const
 	{
 		return m_graph.getOutputLayoutState( view );
 	}
+
+	bool RunnableGraph::isOutputConsumed( FramePass const & pass
+		, ImageViewId view )const
+	{
+		return m_unconsumedOutputs.end() == m_unconsumedOutputs.find( { &pass, view } )
+			|| m_graph.getOutputLayoutState( view ).layout != VK_IMAGE_LAYOUT_UNDEFINED
+			|| m_graph.getInputLayoutState( view ).layout != VK_IMAGE_LAYOUT_UNDEFINED;
+	}
+
+	bool RunnableGraph::isMergedOutputConsumed( FramePass const & pass
+		, ImageViewId view )const
+	{
+		return m_unconsumedMergedOutputs.end() == m_unconsumedMergedOutputs.find( { &pass, view } )
+			|| m_graph.getOutputLayoutState( view ).layout != VK_IMAGE_LAYOUT_UNDEFINED
+			|| m_graph.getInputLayoutState( view ).layout != VK_IMAGE_LAYOUT_UNDEFINED;
+	}
+
+	GraphMemoryStats RunnableGraph::getMemoryStats()const
+	{
+		GraphMemoryStats result;
+		result.total = m_resources.getMemoryStats();
+		auto & handler = m_resources.getHandler();
+		result.timeline.reserve( m_lifetimes.passes.size() );
+
+		for ( auto pass : m_lifetimes.passes )
+		{
+			result.timeline.push_back( { pass, 0u } );
+		}
+
+		auto addResource = [this, &result]( ResourceMemory const & memory
+			, uint32_t firstPass
+			, uint32_t lastPass )
+		{
+			result.groups[&m_lifetimes.passes[firstPass]->group].add( memory );
+
+			for ( auto index = firstPass; index <= lastPass; ++index )
+			{
+				result.timeline[index].liveSize += memory.requirements.size;
+			}
+		};
+
+		for ( auto const & [image, lifetime] : m_lifetimes.images )
+		{
+			if ( auto memory = handler.getMemory( image );
+				memory.requirements.size )
+			{
+				addResource( memory, lifetime.firstPass, lifetime.lastPass );
+			}
+		}
+
+		// Aliased graph buffers share their memory block, which lives from the first to the last pass using one of them.
+		std::map< VkDeviceMemory, std::pair< uint32_t, uint32_t > > blocks;
+
+		for ( auto & buffer : m_graph.m_buffers )
+		{
+			auto block = handler.getMemoryBlock( buffer );
+			auto it = m_lifetimes.buffers.find( *handler.getBufferHandle( buffer ) );
+
+			if ( block == VkDeviceMemory{}
+				|| it == m_lifetimes.buffers.end() )
+			{
+				continue;
+			}
+
+			auto [blockIt, inserted] = blocks.emplace( block
+				, std::make_pair( it->second.firstPass, it->second.lastPass ) );
+
+			if ( !inserted )
+			{
+				blockIt->second.first = std::min( blockIt->second.first, it->second.firstPass );
+				blockIt->second.second = std::max( blockIt->second.second, it->second.lastPass );
+			}
+		}
+
+		for ( auto & buffer : m_graph.m_buffers )
+		{
+			if ( auto it = blocks.find( handler.getMemoryBlock( buffer ) );
+				it != blocks.end() )
+			{
+				addResource( handler.getMemory( buffer ), it->second.first, it->second.second );
+				blocks.erase( it );
+			}
+		}
+
+		for ( auto const & usage : result.timeline )
+		{
+			result.livePeak = std::max( result.livePeak, usage.liveSize );
+		}
+
+		return result;
+	}
 }
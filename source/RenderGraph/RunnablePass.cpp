@@ -9,6 +9,7 @@ See LICENSE file in root folder.
 #include "RenderGraph/RunnableGraph.hpp"
 
 #include <cassert>
+#include <utility>
 
 #pragma warning( push )
 #pragma warning( disable: 5262 )
@@ -296,6 +297,12 @@ namespace crg
 						, attach.getPipelineStageFlags( m_callbacks.isComputePass() ) } );
 			}
 		}
+
+		// Built once, each record only registers the shared transitions.
+		for ( auto const & [view, action] : m_ruConfig.implicitActions )
+		{
+			m_implicitTransitions.push_back( std::make_shared< RecordContext::ImplicitTransition const >( RecordContext::ImplicitTransition{ this, view, action } ) );
+		}
 	}
 
 	RunnablePass::~RunnablePass()noexcept
@@ -387,95 +394,23 @@ namespace crg
 #pragma GCC diagnostic pop
 			m_timer.beginPass( commandBuffer );
 
-			for ( auto & attach : m_pass.images )
+			// The barriers of a pass recorded as a subpass are recorded before the render pass, by prepareSubpass.
+			if ( !std::exchange( m_subpassPrepared, false ) )
 			{
-				auto view = attach.view( index );
-				context.runImplicitTransition( commandBuffer
-					, index
-					, view );
+				// The attachments transitions are batched, to coalesce the ones on adjacent subresources.
+				context.beginBarriersBatch();
 
-				if ( !attach.isNoTransition()
-					&& ( attach.isSampledView() || attach.isStorageView() || attach.isTransferView() || attach.isTransitionView() ) )
+				for ( auto & attach : m_pass.images )
 				{
-					auto needed = makeLayoutState( attach.getImageLayout( m_context.separateDepthStencilLayouts ) );
-					auto currentLayout = ( !attach.isInput()
-						? crg::makeLayoutState( VK_IMAGE_LAYOUT_UNDEFINED )
-						: m_graph.getCurrentLayoutState( context, view ) );
-					checkUndefinedInput( "Record", attach, view, currentLayout.layout );
-
-					if ( attach.isClearableImage() )
-					{
-						context.memoryBarrier( commandBuffer
-							, view
-							, currentLayout.layout
-							, LayoutState{ VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, { VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT } } );
-
-						if ( isColourFormat( getFormat( view ) ) )
-						{
-							VkClearColorValue colour{};
-							m_context.vkCmdClearColorImage( commandBuffer
-								, m_graph.createImage( view.data->image )
-								, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
-								, &colour
-								, 1u
-								, &view.data->info.subresourceRange );
-						}
-						else
-						{
-							VkClearDepthStencilValue depthStencil{};
-							m_context.vkCmdClearDepthStencilImage( commandBuffer
-								, m_graph.createImage( view.data->image )
-								, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
-								, &depthStencil
-								, 1u
-								, &view.data->info.subresourceRange );
-						}
-
-						currentLayout.layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-						currentLayout.state.access = VK_ACCESS_TRANSFER_WRITE_BIT;
-						currentLayout.state.pipelineStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-					}
-
-					context.memoryBarrier( commandBuffer
-						, view
-						, currentLayout.layout
-						, needed );
+					doRecordImageBarrier( context, commandBuffer, index, attach );
 				}
-			}
 
-			for ( auto & attach : m_pass.buffers )
-			{
-				if ( !attach.isNoTransition()
-					&& ( attach.isStorageBuffer() || attach.isTransferBuffer() || attach.isTransitionBuffer() ) )
+				for ( auto & attach : m_pass.buffers )
 				{
-					auto & range = attach.getBufferRange();
-					auto buffer = attach.buffer( index );
-					auto currentState = context.getAccessState( buffer, range );
-
-					if ( attach.isClearableBuffer() )
-					{
-						context.memoryBarrier( commandBuffer
-							, buffer
-							, range
-							, currentState.access
-							, currentState.pipelineStage
-							, { VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT } );
-						m_context.vkCmdFillBuffer( commandBuffer
-							, buffer
-							, range.offset == 0u ? 0u : details::getAlignedSize( range.offset, 4u )
-							, range.size == VK_WHOLE_SIZE ? VK_WHOLE_SIZE : details::getAlignedSize( range.size, 4u )
-							, 0u );
-						currentState.access = VK_ACCESS_TRANSFER_WRITE_BIT;
-						currentState.pipelineStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-					}
-
-					context.memoryBarrier( commandBuffer
-						, buffer
-						, range
-						, currentState.access
-						, currentState.pipelineStage
-						, { attach.getAccessMask(), attach.getPipelineStageFlags( m_callbacks.isComputePass() ) } );
+					doRecordBufferBarrier( context, commandBuffer, index, attach );
 				}
+
+				context.endBarriersBatch( commandBuffer );
 			}
 
 			for ( auto const & action : m_ruConfig.prePassActions )
@@ -494,9 +429,151 @@ namespace crg
 			m_context.vkCmdEndDebugBlock( commandBuffer );
 		}
 
-		for ( auto const & [view, action] : m_ruConfig.implicitActions )
+		for ( auto const & transition : m_implicitTransitions )
+		{
+			context.registerImplicitTransition( transition );
+		}
+	}
+
+	void RunnablePass::prepareSubpass( RecordContext & context
+		, VkCommandBuffer commandBuffer
+		, std::set< ImageViewId > const & attachments )
+	{
+		if ( !isEnabled() )
+		{
+			return;
+		}
+
+		auto index = m_callbacks.getPassIndex();
+		m_timer.resetPass( commandBuffer );
+		context.beginBarriersBatch();
+
+		for ( auto & attach : m_pass.images )
+		{
+			if ( auto view = attach.view( index );
+				attachments.end() != attachments.find( view ) )
+			{
+				context.runImplicitTransition( commandBuffer
+					, index
+					, view );
+			}
+			else
+			{
+				doRecordImageBarrier( context, commandBuffer, index, attach );
+			}
+		}
+
+		for ( auto & attach : m_pass.buffers )
 		{
-			context.registerImplicitTransition( *this, view, action );
+			doRecordBufferBarrier( context, commandBuffer, index, attach );
+		}
+
+		context.endBarriersBatch( commandBuffer );
+		m_subpassPrepared = true;
+	}
+
+	bool RunnablePass::hasPassActions()const
+	{
+		return !m_ruConfig.prePassActions.empty()
+			|| !m_ruConfig.postPassActions.empty();
+	}
+
+	void RunnablePass::doRecordImageBarrier( RecordContext & context
+		, VkCommandBuffer commandBuffer
+		, uint32_t index
+		, Attachment const & attach )
+	{
+		auto view = attach.view( index );
+		context.runImplicitTransition( commandBuffer
+			, index
+			, view );
+
+		if ( !attach.isNoTransition()
+			&& ( attach.isSampledView() || attach.isStorageView() || attach.isTransferView() || attach.isTransitionView() ) )
+		{
+			auto needed = makeLayoutState( attach.getImageLayout( m_context.separateDepthStencilLayouts ) );
+			auto currentLayout = ( !attach.isInput()
+				? crg::makeLayoutState( VK_IMAGE_LAYOUT_UNDEFINED )
+				: m_graph.getCurrentLayoutState( context, view ) );
+			checkUndefinedInput( "Record", attach, view, currentLayout.layout );
+
+			if ( attach.isClearableImage() )
+			{
+				context.memoryBarrier( commandBuffer
+					, view
+					, currentLayout.layout
+					, LayoutState{ VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, { VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT } } );
+				context.flushBarriers( commandBuffer );
+
+				if ( isColourFormat( getFormat( view ) ) )
+				{
+					VkClearColorValue colour{};
+					m_context.vkCmdClearColorImage( commandBuffer
+						, m_graph.createImage( view.data->image )
+						, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+						, &colour
+						, 1u
+						, &view.data->info.subresourceRange );
+				}
+				else
+				{
+					VkClearDepthStencilValue depthStencil{};
+					m_context.vkCmdClearDepthStencilImage( commandBuffer
+						, m_graph.createImage( view.data->image )
+						, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+						, &depthStencil
+						, 1u
+						, &view.data->info.subresourceRange );
+				}
+
+				currentLayout.layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+				currentLayout.state.access = VK_ACCESS_TRANSFER_WRITE_BIT;
+				currentLayout.state.pipelineStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+			}
+
+			context.memoryBarrier( commandBuffer
+				, view
+				, currentLayout.layout
+				, needed );
+		}
+	}
+
+	void RunnablePass::doRecordBufferBarrier( RecordContext & context
+		, VkCommandBuffer commandBuffer
+		, uint32_t index
+		, Attachment const & attach )
+	{
+		if ( !attach.isNoTransition()
+			&& ( attach.isStorageBuffer() || attach.isTransferBuffer() || attach.isTransitionBuffer() ) )
+		{
+			auto & range = attach.getBufferRange();
+			auto buffer = attach.buffer( index );
+			auto currentState = context.getAccessState( buffer, range );
+
+			if ( attach.isClearableBuffer() )
+			{
+				context.memoryBarrier( commandBuffer
+					, buffer
+					, range
+					, currentState.access
+					, currentState.pipelineStage
+					, { VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT } );
+				context.flushBarriers( commandBuffer );
+				m_context.vkCmdFillBuffer( commandBuffer
+					, buffer
+					, range.offset == 0u ? 0u : details::getAlignedSize( range.offset, 4u )
+					, range.size == VK_WHOLE_SIZE ? VK_WHOLE_SIZE : details::getAlignedSize( range.size, 4u )
+					, 0u );
+				currentState.access = VK_ACCESS_TRANSFER_WRITE_BIT;
+				currentState.pipelineStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+			}
+
+			context.memoryBarrier( commandBuffer
+				, buffer
+				, range
+				, currentState.access
+				, currentState.pipelineStage
+				, { attach.getAccessMask(), attach.getPipelineStageFlags( m_callbacks.isComputePass() ) } );
 		}
 	}
 
@@ -511,6 +588,7 @@ namespace crg
 			{
 				pass.fence.wait( 0xFFFFFFFFFFFFFFFFULL );
 				pass.commandBuffer.recorded = false;
+				m_graph.invalidateVariants();
 				m_context.vkResetCommandBuffer( pass.commandBuffer.commandBuffer
 					, VK_COMMAND_BUFFER_RESET_RELEASE_RESOURCES_BIT );
 			}
@@ -3,15 +3,31 @@ This file belongs to FrameGraph.
 See LICENSE file in root folder.
 */
 #include "RenderGraph/RunnablePasses/BufferCopy.hpp"
+#include "CopyBatch.hpp"
 
 #include "RenderGraph/GraphContext.hpp"
 #include "RenderGraph/ImageData.hpp"
 #include "RenderGraph/RunnableGraph.hpp"
+#include "RenderGraph/UploadRing.hpp"
 
+#include <algorithm>
 #include <array>
 
 namespace crg
 {
+	namespace bufCopy
+	{
+		static BufferCopyRegionArray getDefaultRegions( FramePass const & pass
+			, VkDeviceSize copyOffset
+			, VkDeviceSize copyRange )
+		{
+			// The first buffer is copied into the last one.
+			return { BufferCopyRegion{ 0u
+				, uint32_t( std::max( pass.buffers.size(), size_t( 1u ) ) - 1u )
+				, VkBufferCopy{ copyOffset, copyOffset, copyRange } } };
+		}
+	}
+
 	BufferCopy::BufferCopy( FramePass const & pass
 		, GraphContext & context
 		, RunnableGraph & graph
@@ -20,6 +36,23 @@ namespace crg
 		, ru::Config ruConfig
 		, GetPassIndexCallback passIndex
 		, IsEnabledCallback isEnabled )
+		: BufferCopy{ pass
+			, context
+			, graph
+			, bufCopy::getDefaultRegions( pass, copyOffset, copyRange )
+			, std::move( ruConfig )
+			, std::move( passIndex )
+			, std::move( isEnabled ) }
+	{
+	}
+
+	BufferCopy::BufferCopy( FramePass const & pass
+		, GraphContext & context
+		, RunnableGraph & graph
+		, BufferCopyRegionArray regions
+		, ru::Config ruConfig
+		, GetPassIndexCallback passIndex
+		, IsEnabledCallback isEnabled )
 		: RunnablePass{ pass
 			, context
 			, graph
@@ -29,45 +62,126 @@ namespace crg
 				, std::move( passIndex )
 				, std::move( isEnabled ) }
 			, std::move( ruConfig ) }
-		, m_copyOffset{ copyOffset }
-		, m_copyRange{ copyRange }
+		, m_regions{ std::move( regions ) }
 	{
+		copyBatch::checkRegions( m_regions, m_pass.buffers.size(), m_pass.buffers.size() );
+	}
+
+	BufferCopy::BufferCopy( FramePass const & pass
+		, GraphContext & context
+		, RunnableGraph & graph
+		, UploadRing & uploadRing
+		, VkDeviceSize copyOffset
+		, VkDeviceSize copyRange
+		, ru::Config ruConfig
+		, GetPassIndexCallback passIndex
+		, IsEnabledCallback isEnabled )
+		: BufferCopy{ pass
+			, context
+			, graph
+			, copyOffset
+			, copyRange
+			, std::move( ruConfig )
+			, std::move( passIndex )
+			, std::move( isEnabled ) }
+	{
+		// The uploaded data is read from its start.
+		m_regions.front().region.srcOffset = 0u;
+		m_uploadRing = &uploadRing;
 	}
 
 	void BufferCopy::doRecordInto( RecordContext & context
 		, VkCommandBuffer commandBuffer
 		, uint32_t index )const
 	{
-		auto srcBufferRange{ m_pass.buffers.front().getBufferRange() };
-		auto dstBufferRange{ m_pass.buffers.back().getBufferRange() };
-		auto srcBuffer{ m_pass.buffers.front().buffer( index ) };
-		auto dstBuffer{ m_pass.buffers.back().buffer( index ) };
-		// Copy source to target.
-		VkBufferCopy copyRegion{ srcBufferRange.offset + m_copyOffset
-			, dstBufferRange.offset + m_copyOffset
-			, m_copyRange };
-		context.memoryBarrier( commandBuffer
-			, srcBuffer
-			, srcBufferRange
-			, VK_ACCESS_SHADER_WRITE_BIT
-			, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT
-			, crg::AccessState{ VK_ACCESS_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT } );
-		context.memoryBarrier( commandBuffer
-			, dstBuffer
-			, dstBufferRange
-			, crg::AccessState{ VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT } );
-		context->vkCmdCopyBuffer( commandBuffer
-			, srcBuffer
-			, dstBuffer
-			, 1u
-			, &copyRegion );
-		context.memoryBarrier( commandBuffer
-			, dstBuffer
-			, dstBufferRange
-			, crg::AccessState{ VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT } );
-		context.memoryBarrier( commandBuffer
-			, srcBuffer
-			, srcBufferRange
-			, crg::AccessState{ VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT } );
+		UploadRing::Upload upload{};
+
+		if ( m_uploadRing )
+		{
+			// The uploaded data changes each frame, so must the recorded copy.
+			context.setVolatile();
+
+			if ( !m_uploadRing->takeUpload( m_pass, m_graph.getFence(), upload ) )
+			{
+				return;
+			}
+		}
+
+		// The regions sharing the same source and destination buffers are copied with a single call.
+		copyBatch::CopyArrayT< VkBuffer, VkBuffer, VkBufferCopy > copies;
+		context.beginBarriersBatch();
+
+		for ( auto & copyRegion : m_regions )
+		{
+			auto & dstAttach = m_pass.buffers[copyRegion.dst];
+			auto dstBufferRange{ dstAttach.getBufferRange() };
+			auto dstBuffer{ dstAttach.buffer( index ) };
+			auto region = copyRegion.region;
+			region.dstOffset += dstBufferRange.offset;
+			VkBuffer srcBuffer{};
+
+			if ( m_uploadRing )
+			{
+				if ( region.srcOffset >= upload.size )
+				{
+					continue;
+				}
+
+				// The ring memory is host coherent, the submission makes the host writes visible.
+				srcBuffer = m_uploadRing->getBuffer().buffer();
+				region.size = std::min( region.size, upload.size - region.srcOffset );
+				region.srcOffset += upload.offset;
+			}
+			else
+			{
+				auto & srcAttach = m_pass.buffers[copyRegion.src];
+				auto srcBufferRange{ srcAttach.getBufferRange() };
+				srcBuffer = srcAttach.buffer( index );
+				region.srcOffset += srcBufferRange.offset;
+				context.memoryBarrier( commandBuffer
+					, srcBuffer
+					, srcBufferRange
+					, VK_ACCESS_SHADER_WRITE_BIT
+					, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT
+					, crg::AccessState{ VK_ACCESS_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT } );
+			}
+
+			copyBatch::addRegion( copies, srcBuffer, dstBuffer, region );
+			context.memoryBarrier( commandBuffer
+				, dstBuffer
+				, dstBufferRange
+				, crg::AccessState{ VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT } );
+		}
+
+		context.flushBarriers( commandBuffer );
+
+		for ( auto & copy : copies )
+		{
+			context->vkCmdCopyBuffer( commandBuffer
+				, copy.src
+				, copy.dst
+				, uint32_t( copy.regions.size() )
+				, copy.regions.data() );
+		}
+
+		for ( auto & copyRegion : m_regions )
+		{
+			auto & dstAttach = m_pass.buffers[copyRegion.dst];
+			context.memoryBarrier( commandBuffer
+				, dstAttach.buffer( index )
+				, dstAttach.getBufferRange()
+				, crg::AccessState{ VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT } );
+
+			if ( !m_uploadRing )
+			{
+				auto & srcAttach = m_pass.buffers[copyRegion.src];
+				context.memoryBarrier( commandBuffer
+					, srcAttach.buffer( index )
+					, srcAttach.getBufferRange()
+					, crg::AccessState{ VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT } );
+			}
+		}
+
+		context.endBarriersBatch( commandBuffer );
 	}
 }
@@ -3,11 +3,16 @@ This file belongs to FrameGraph.
 See LICENSE file in root folder.
 */
 #include "RenderGraph/RunnablePasses/BufferToImageCopy.hpp"
+#include "CopyBatch.hpp"
+#include "CopySize.hpp"
 
 #include "RenderGraph/GraphContext.hpp"
 #include "RenderGraph/ImageData.hpp"
+#include "RenderGraph/Log.hpp"
 #include "RenderGraph/RunnableGraph.hpp"
+#include "RenderGraph/UploadRing.hpp"
 
+#include <algorithm>
 #include <array>
 
 namespace crg
@@ -21,6 +26,16 @@ namespace crg
 				, range.baseArrayLayer
 				, range.layerCount };
 		}
+
+		static BufferImageCopyRegionArray getDefaultRegions( FramePass const & pass
+			, VkOffset3D copyOffset
+			, VkExtent3D copySize )
+		{
+			// The first buffer is copied into the last image.
+			return { BufferImageCopyRegion{ 0u
+				, uint32_t( std::max( pass.images.size(), size_t( 1u ) ) - 1u )
+				, VkBufferImageCopy{ 0u, 0u, 0u, {}, copyOffset, copySize } } };
+		}
 	}
 
 	BufferToImageCopy::BufferToImageCopy( FramePass const & pass
@@ -31,6 +46,42 @@ namespace crg
 		, ru::Config ruConfig
 		, GetPassIndexCallback passIndex
 		, IsEnabledCallback isEnabled )
+		: BufferToImageCopy{ pass
+			, context
+			, graph
+			, bufToImg::getDefaultRegions( pass, copyOffset, copySize )
+			, std::move( ruConfig )
+			, std::move( passIndex )
+			, std::move( isEnabled ) }
+	{
+	}
+
+	BufferToImageCopy::BufferToImageCopy( FramePass const & pass
+		, GraphContext & context
+		, RunnableGraph & graph
+		, BufferImageCopyRegionArray regions
+		, ru::Config ruConfig
+		, GetPassIndexCallback passIndex
+		, IsEnabledCallback isEnabled )
+		: BufferToImageCopy{ pass
+			, context
+			, graph
+			, nullptr
+			, std::move( regions )
+			, std::move( ruConfig )
+			, std::move( passIndex )
+			, std::move( isEnabled ) }
+	{
+	}
+
+	BufferToImageCopy::BufferToImageCopy( FramePass const & pass
+		, GraphContext & context
+		, RunnableGraph & graph
+		, UploadRing * uploadRing
+		, BufferImageCopyRegionArray regions
+		, ru::Config ruConfig
+		, GetPassIndexCallback passIndex
+		, IsEnabledCallback isEnabled )
 		: RunnablePass{ pass
 			, context
 			, graph
@@ -40,8 +91,32 @@ namespace crg
 				, std::move( passIndex )
 				, std::move( isEnabled ) }
 			, std::move( ruConfig ) }
-		, m_copyOffset{ copyOffset }
-		, m_copySize{ copySize }
+		, m_regions{ std::move( regions ) }
+		, m_uploadRing{ uploadRing }
+	{
+		// With an upload ring, the ring is the only source.
+		copyBatch::checkRegions( m_regions
+			, m_uploadRing ? 1u : m_pass.buffers.size()
+			, m_pass.images.size() );
+	}
+
+	BufferToImageCopy::BufferToImageCopy( FramePass const & pass
+		, GraphContext & context
+		, RunnableGraph & graph
+		, UploadRing & uploadRing
+		, VkOffset3D copyOffset
+		, VkExtent3D copySize
+		, ru::Config ruConfig
+		, GetPassIndexCallback passIndex
+		, IsEnabledCallback isEnabled )
+		: BufferToImageCopy{ pass
+			, context
+			, graph
+			, &uploadRing
+			, bufToImg::getDefaultRegions( pass, copyOffset, copySize )
+			, std::move( ruConfig )
+			, std::move( passIndex )
+			, std::move( isEnabled ) }
 	{
 	}
 
@@ -49,22 +124,60 @@ namespace crg
 		, VkCommandBuffer commandBuffer
 		, uint32_t index )const
 	{
-		auto dstAttach{ m_pass.images.back().view( index ) };
-		auto srcBuffer{ m_pass.buffers.front().buffer( index ) };
-		auto dstImage{ m_graph.createImage( dstAttach.data->image ) };
-		// Copy source to target.
-		auto range = bufToImg::convert( dstAttach.data->info.subresourceRange );
-		VkBufferImageCopy copyRegion{ 0ULL
-			, 0u
-			, 0u
-			, range
-			, m_copyOffset
-			, m_copySize };
-		context->vkCmdCopyBufferToImage( commandBuffer
-			, srcBuffer
-			, dstImage
-			, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
-			, 1u
-			, &copyRegion );
+		UploadRing::Upload upload{};
+
+		if ( m_uploadRing )
+		{
+			// The uploaded data changes each frame, so must the recorded copy.
+			context.setVolatile();
+
+			if ( !m_uploadRing->takeUpload( m_pass, m_graph.getFence(), upload ) )
+			{
+				return;
+			}
+		}
+
+		// The regions sharing the same buffer and image are copied with a single call.
+		copyBatch::CopyArrayT< VkBuffer, VkImage, VkBufferImageCopy > copies;
+
+		for ( auto & copyRegion : m_regions )
+		{
+			auto dstAttach{ m_pass.images[copyRegion.dst].view( index ) };
+			auto region = copyRegion.region;
+			region.imageSubresource = bufToImg::convert( dstAttach.data->info.subresourceRange );
+			VkBuffer srcBuffer{};
+
+			if ( m_uploadRing )
+			{
+				// The regions offsets are relative to the uploaded data.
+				if ( upload.size < region.bufferOffset + getCopySize( *dstAttach.data, region.imageExtent ) )
+				{
+					Logger::logWarning( m_pass.getGroupName() + " - Uploaded data is too small for image " + dstAttach.data->name );
+					continue;
+				}
+
+				srcBuffer = m_uploadRing->getBuffer().buffer();
+				region.bufferOffset += upload.offset;
+			}
+			else
+			{
+				srcBuffer = m_pass.buffers[copyRegion.src].buffer( index );
+			}
+
+			copyBatch::addRegion( copies
+				, srcBuffer
+				, m_graph.createImage( dstAttach.data->image )
+				, region );
+		}
+
+		for ( auto & copy : copies )
+		{
+			context->vkCmdCopyBufferToImage( commandBuffer
+				, copy.src
+				, copy.dst
+				, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+				, uint32_t( copy.regions.size() )
+				, copy.regions.data() );
+		}
 	}
 }
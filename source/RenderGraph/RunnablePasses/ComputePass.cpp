@@ -38,7 +38,8 @@ namespace crg
 			, cpConfig.m_getGroupCountX ? std::optional< cp::GetGroupCountCallback >( std::move( *cpConfig.m_getGroupCountX ) ) : std::nullopt
 			, cpConfig.m_getGroupCountY ? std::optional< cp::GetGroupCountCallback >( std::move( *cpConfig.m_getGroupCountY ) ) : std::nullopt
 			, cpConfig.m_getGroupCountZ ? std::optional< cp::GetGroupCountCallback >( std::move( *cpConfig.m_getGroupCountZ ) ) : std::nullopt
-			, cpConfig.m_indirectBuffer ? *cpConfig.m_indirectBuffer : getDefaultV < IndirectBuffer >() }
+			, cpConfig.m_indirectBuffer ? *cpConfig.m_indirectBuffer : getDefaultV < IndirectBuffer >()
+			, cpConfig.m_getDispatches ? std::optional< cp::GetDispatchesCallback >( std::move( *cpConfig.m_getDispatches ) ) : std::nullopt }
 		, m_pipeline{ pass
 			, context
 			, graph
@@ -85,11 +86,19 @@ namespace crg
 		, VkCommandBuffer commandBuffer
 		, uint32_t index )
 	{
-		m_pipeline.recordInto( context, commandBuffer, index );
+		if ( !m_pipeline.recordInto( context, commandBuffer, index ) )
+		{
+			return;
+		}
+
 		m_cpConfig.recordInto( context, commandBuffer, index );
 
-		if ( auto indirectBuffer = m_cpConfig.indirectBuffer.buffer.buffer( index ) )
-		{ 
+		if ( m_cpConfig.getDispatches )
+		{
+			doRecordDispatches( context, commandBuffer );
+		}
+		else if ( auto indirectBuffer = m_cpConfig.indirectBuffer.buffer.buffer( index ) )
+		{
 			context->vkCmdDispatchIndirect( commandBuffer, indirectBuffer, m_cpConfig.indirectBuffer.offset );
 		}
 		else
@@ -103,6 +112,48 @@ namespace crg
 		m_cpConfig.end( context, commandBuffer, index );
 	}
 
+	void ComputePass::doRecordDispatches( RecordContext & context
+		, VkCommandBuffer commandBuffer )const
+	{
+		auto dispatches = ( *m_cpConfig.getDispatches )();
+
+		for ( auto it = dispatches.begin(); it != dispatches.end(); ++it )
+		{
+			if ( it->dependsOnPrevious && it != dispatches.begin() )
+			{
+				VkMemoryBarrier barrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER
+					, nullptr
+					, VK_ACCESS_SHADER_WRITE_BIT
+					, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT };
+				context->vkCmdPipelineBarrier( commandBuffer
+					, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT
+					, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT
+					, 0u
+					, 1u
+					, &barrier
+					, 0u
+					, nullptr
+					, 0u
+					, nullptr );
+			}
+
+			if ( !it->pushConstants.empty() )
+			{
+				context->vkCmdPushConstants( commandBuffer
+					, getPipelineLayout()
+					, VK_SHADER_STAGE_COMPUTE_BIT
+					, it->pushConstantsOffset
+					, uint32_t( it->pushConstants.size() )
+					, it->pushConstants.data() );
+			}
+
+			context->vkCmdDispatch( commandBuffer
+				, it->groupCountX
+				, it->groupCountY
+				, it->groupCountZ );
+		}
+	}
+
 	void ComputePass::doCreatePipeline( uint32_t index )
 	{
 		auto & program = m_pipeline.getProgram( index );
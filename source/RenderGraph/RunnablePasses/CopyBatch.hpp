@@ -0,0 +1,73 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#pragma once
+
+#include "RenderGraph/Exception.hpp"
+#include "RenderGraph/RunnablePasses/CopyRegion.hpp"
+
+#include <algorithm>
+
+namespace crg
+{
+	namespace copyBatch
+	{
+		/**
+		*\brief
+		*	The regions copied between two resources, recorded with a single vkCmdCopy* call.
+		*/
+		template< typename SrcT, typename DstT, typename RegionT >
+		struct CopyT
+		{
+			SrcT src;
+			DstT dst;
+			std::vector< RegionT > regions;
+		};
+
+		template< typename SrcT, typename DstT, typename RegionT >
+		using CopyArrayT = std::vector< CopyT< SrcT, DstT, RegionT > >;
+
+		/**
+		*\brief
+		*	Checks that the regions only refer to attachments of the pass.
+		*\param[in] srcCount, dstCount
+		*	The number of attachments the source and destination indices refer to.
+		*/
+		template< typename RegionT >
+		void checkRegions( std::vector< CopyRegionT< RegionT > > const & regions
+			, size_t srcCount
+			, size_t dstCount )
+		{
+			for ( auto & region : regions )
+			{
+				if ( region.src >= srcCount || region.dst >= dstCount )
+				{
+					CRG_Exception( "Copy region attachment index out of range" );
+				}
+			}
+		}
+
+		template< typename SrcT, typename DstT, typename RegionT >
+		void addRegion( CopyArrayT< SrcT, DstT, RegionT > & copies
+			, SrcT src
+			, DstT dst
+			, RegionT const & region )
+		{
+			auto it = std::find_if( copies.begin()
+				, copies.end()
+				, [src, dst]( CopyT< SrcT, DstT, RegionT > const & lookup )
+				{
+					return lookup.src == src
+						&& lookup.dst == dst;
+				} );
+
+			if ( it == copies.end() )
+			{
+				it = copies.insert( copies.end(), CopyT< SrcT, DstT, RegionT >{ src, dst, {} } );
+			}
+
+			it->regions.push_back( region );
+		}
+	}
+}
@@ -0,0 +1,131 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#include "CopySize.hpp"
+
+#include "RenderGraph/ImageViewData.hpp"
+
+namespace crg
+{
+	namespace cpysize
+	{
+		struct TexelBlock
+		{
+			VkDeviceSize size;
+			uint32_t extent;
+		};
+
+		static TexelBlock getTexelBlock( VkFormat format
+			, VkImageAspectFlags aspect )
+		{
+			if ( aspect == VK_IMAGE_ASPECT_STENCIL_BIT )
+			{
+				return { 1u, 1u };
+			}
+
+			if ( format == VK_FORMAT_D16_UNORM_S8_UINT )
+			{
+				return { 2u, 1u };
+			}
+
+			if ( format == VK_FORMAT_D24_UNORM_S8_UINT
+				|| format == VK_FORMAT_D32_SFLOAT_S8_UINT )
+			{
+				return { 4u, 1u };
+			}
+
+			auto value = int( format );
+			auto between = [value]( VkFormat first, VkFormat last )
+				{
+					return value >= int( first ) && value <= int( last );
+				};
+
+			if ( between( VK_FORMAT_R4G4_UNORM_PACK8, VK_FORMAT_R4G4_UNORM_PACK8 )
+				|| between( VK_FORMAT_R8_UNORM, VK_FORMAT_R8_SRGB )
+				|| between( VK_FORMAT_S8_UINT, VK_FORMAT_S8_UINT ) )
+			{
+				return { 1u, 1u };
+			}
+
+			if ( between( VK_FORMAT_R4G4B4A4_UNORM_PACK16, VK_FORMAT_A1R5G5B5_UNORM_PACK16 )
+				|| between( VK_FORMAT_R8G8_UNORM, VK_FORMAT_R8G8_SRGB )
+				|| between( VK_FORMAT_R16_UNORM, VK_FORMAT_R16_SFLOAT )
+				|| between( VK_FORMAT_D16_UNORM, VK_FORMAT_D16_UNORM ) )
+			{
+				return { 2u, 1u };
+			}
+
+			if ( between( VK_FORMAT_R8G8B8_UNORM, VK_FORMAT_B8G8R8_SRGB ) )
+			{
+				return { 3u, 1u };
+			}
+
+			if ( between( VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_A2B10G10R10_SINT_PACK32 )
+				|| between( VK_FORMAT_R16G16_UNORM, VK_FORMAT_R16G16_SFLOAT )
+				|| between( VK_FORMAT_R32_UINT, VK_FORMAT_R32_SFLOAT )
+				|| between( VK_FORMAT_B10G11R11_UFLOAT_PACK32, VK_FORMAT_D32_SFLOAT ) )
+			{
+				return { 4u, 1u };
+			}
+
+			if ( between( VK_FORMAT_R16G16B16_UNORM, VK_FORMAT_R16G16B16_SFLOAT ) )
+			{
+				return { 6u, 1u };
+			}
+
+			if ( between( VK_FORMAT_R16G16B16A16_UNORM, VK_FORMAT_R16G16B16A16_SFLOAT )
+				|| between( VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32_SFLOAT )
+				|| between( VK_FORMAT_R64_UINT, VK_FORMAT_R64_SFLOAT ) )
+			{
+				return { 8u, 1u };
+			}
+
+			if ( between( VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32_SFLOAT ) )
+			{
+				return { 12u, 1u };
+			}
+
+			if ( between( VK_FORMAT_R32G32B32A32_UINT, VK_FORMAT_R32G32B32A32_SFLOAT )
+				|| between( VK_FORMAT_R64G64_UINT, VK_FORMAT_R64G64_SFLOAT ) )
+			{
+				return { 16u, 1u };
+			}
+
+			if ( between( VK_FORMAT_R64G64B64_UINT, VK_FORMAT_R64G64B64_SFLOAT ) )
+			{
+				return { 24u, 1u };
+			}
+
+			if ( between( VK_FORMAT_R64G64B64A64_UINT, VK_FORMAT_R64G64B64A64_SFLOAT ) )
+			{
+				return { 32u, 1u };
+			}
+
+			if ( between( VK_FORMAT_BC1_RGB_UNORM_BLOCK, VK_FORMAT_BC1_RGBA_SRGB_BLOCK )
+				|| between( VK_FORMAT_BC4_UNORM_BLOCK, VK_FORMAT_BC4_SNORM_BLOCK ) )
+			{
+				return { 8u, 4u };
+			}
+
+			if ( between( VK_FORMAT_BC2_UNORM_BLOCK, VK_FORMAT_BC7_SRGB_BLOCK ) )
+			{
+				return { 16u, 4u };
+			}
+
+			// Unknown block layout, the size can't be checked.
+			return { 0u, 1u };
+		}
+	}
+
+	VkDeviceSize getCopySize( ImageViewData const & view
+		, VkExtent3D const & copySize )
+	{
+		auto block = cpysize::getTexelBlock( view.info.format, view.info.subresourceRange.aspectMask );
+		return block.size
+			* ( ( copySize.width + block.extent - 1u ) / block.extent )
+			* ( ( copySize.height + block.extent - 1u ) / block.extent )
+			* copySize.depth
+			* view.info.subresourceRange.layerCount;
+	}
+}
@@ -0,0 +1,19 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#pragma once
+
+#include "RenderGraph/FrameGraphPrerequisites.hpp"
+
+namespace crg
+{
+	/**
+	*\brief
+	*	Computes the bytes size of a copy between a buffer and given image view, for given extent.
+	*\return
+	*	0 if the texel block layout of the view format is unknown, in which case the size can't be checked.
+	*/
+	VkDeviceSize getCopySize( ImageViewData const & view
+		, VkExtent3D const & copySize );
+}
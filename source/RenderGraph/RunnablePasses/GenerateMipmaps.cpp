@@ -8,6 +8,7 @@ See LICENSE file in root folder.
 #include "RenderGraph/RunnableGraph.hpp"
 
 #include <array>
+#include <iterator>
 
 namespace crg
 {
@@ -19,11 +20,62 @@ namespace crg
 		{
 			return std::max( T( 1 ), T( extent >> mipLevel ) );
 		}
+
+		struct MipChain
+		{
+			ImageViewId viewId;
+			ImageId imageId;
+			VkImage image;
+			VkExtent3D extent;
+			VkImageAspectFlags aspectMask;
+			uint32_t baseArrayLayer;
+			uint32_t layerCount;
+			uint32_t mipLevels;
+			LayoutState nextLayoutState;
+		};
+
+		static VkOffset3D getMipOffset( VkExtent3D const & extent
+			, uint32_t level )
+		{
+			return { getSubresourceDimension( int32_t( extent.width ), level )
+				, getSubresourceDimension( int32_t( extent.height ), level )
+				, getSubresourceDimension( int32_t( extent.depth ), level ) };
+		}
+
+		static VkImageBlit getBlit( MipChain const & chain
+			, uint32_t level )
+		{
+			VkImageBlit result{};
+			result.srcSubresource = { chain.aspectMask, level - 1u, chain.baseArrayLayer, chain.layerCount };
+			result.srcOffsets[1] = getMipOffset( chain.extent, level - 1u );
+			result.dstSubresource = { chain.aspectMask, level, chain.baseArrayLayer, chain.layerCount };
+			result.dstOffsets[1] = getMipOffset( chain.extent, level );
+			return result;
+		}
+	}
+
+	GenerateMipmaps::GenerateMipmaps( FramePass const & pass
+		, GraphContext & context
+		, RunnableGraph & graph
+		, VkImageLayout outputLayout
+		, ru::Config ruConfig
+		, GetPassIndexCallback passIndex
+		, IsEnabledCallback isEnabled )
+		: GenerateMipmaps{ pass
+			, context
+			, graph
+			, gm::Config{}
+			, outputLayout
+			, std::move( ruConfig )
+			, std::move( passIndex )
+			, std::move( isEnabled ) }
+	{
 	}
 
 	GenerateMipmaps::GenerateMipmaps( FramePass const & pass
 		, GraphContext & context
 		, RunnableGraph & graph
+		, gm::Config config
 		, VkImageLayout outputLayout
 		, ru::Config ruConfig
 		, GetPassIndexCallback passIndex
@@ -37,6 +89,7 @@ namespace crg
 				, std::move( passIndex )
 				, std::move( isEnabled ) }
 			, std::move( ruConfig ) }
+		, m_config{ std::move( config ) }
 		, m_outputLayout{ outputLayout
 			, getAccessMask( outputLayout )
 			, getStageMask( outputLayout ) }
@@ -47,121 +100,140 @@ namespace crg
 		, VkCommandBuffer commandBuffer
 		, uint32_t index )
 	{
-		auto viewId{ m_pass.images.front().view( index ) };
-		auto imageId{ viewId.data->image };
-		auto image{ m_graph.createImage( imageId ) };
-		auto extent = getExtent( imageId );
-		auto format = getFormat( imageId );
-		auto baseArrayLayer = viewId.data->info.subresourceRange.baseArrayLayer;
-		auto layerCount = viewId.data->info.subresourceRange.layerCount;
-		auto mipLevels = imageId.data->info.mipLevels;
-		auto nextLayoutState = m_graph.getNextLayoutState( context
-			, *this
-			, viewId );
-
-		auto const width = int32_t( extent.width );
-		auto const height = int32_t( extent.height );
-		auto const depth = int32_t( extent.depth );
-		auto const aspectMask = getAspectMask( format );
-
-		for ( uint32_t i = 0u; i < layerCount; ++i )
+		// Each processed image (or each of its layers) gets its own chain, the chains are interleaved level by level,
+		// so that the blits of a level don't wait for each other.
+		std::vector< genMips::MipChain > chains;
+		uint32_t maxLevels{};
+		auto imagesEnd = m_config.m_allImages
+			? m_pass.images.end()
+			: std::next( m_pass.images.begin() );
+
+		for ( auto it = m_pass.images.begin(); it != imagesEnd; ++it )
+		{
+			auto viewId{ it->view( index ) };
+			auto imageId{ viewId.data->image };
+			genMips::MipChain chain{ viewId
+				, imageId
+				, m_graph.createImage( imageId )
+				, getExtent( imageId )
+				, getAspectMask( getFormat( imageId ) )
+				, viewId.data->info.subresourceRange.baseArrayLayer
+				, viewId.data->info.subresourceRange.layerCount
+				, imageId.data->info.mipLevels
+				, m_graph.getNextLayoutState( context, *this, viewId ) };
+			maxLevels = std::max( maxLevels, chain.mipLevels );
+
+			if ( m_config.m_batchLayers )
+			{
+				chains.push_back( chain );
+			}
+			else
+			{
+				auto layerCount = chain.layerCount;
+				chain.layerCount = 1u;
+
+				for ( uint32_t layer = 0u; layer < layerCount; ++layer )
+				{
+					chains.push_back( chain );
+					++chain.baseArrayLayer;
+				}
+			}
+		}
+
+		// First mip level to transfer source, other levels to transfer destination.
+		context.beginBarriersBatch();
+
+		for ( auto & chain : chains )
 		{
-			auto layer = baseArrayLayer + i;
-			VkImageSubresourceRange mipSubRange{ aspectMask
+			VkImageSubresourceRange firstRange{ chain.aspectMask
 				, 0u
 				, 1u
-				, layer
-				, 1u };
-			VkImageBlit imageBlit{};
-			imageBlit.dstSubresource.aspectMask = aspectMask;
-			imageBlit.dstSubresource.baseArrayLayer = mipSubRange.baseArrayLayer;
-			imageBlit.dstSubresource.layerCount = 1;
-			imageBlit.dstSubresource.mipLevel = mipSubRange.baseMipLevel;
-			imageBlit.dstOffsets[0].x = 0;
-			imageBlit.dstOffsets[0].y = 0;
-			imageBlit.dstOffsets[0].z = 0;
-			imageBlit.dstOffsets[1].x = genMips::getSubresourceDimension( width, mipSubRange.baseMipLevel );
-			imageBlit.dstOffsets[1].y = genMips::getSubresourceDimension( height, mipSubRange.baseMipLevel );
-			imageBlit.dstOffsets[1].z = genMips::getSubresourceDimension( depth, mipSubRange.baseMipLevel );
-
-			// Transition first mip level to transfer source for read in next iteration
+				, chain.baseArrayLayer
+				, chain.layerCount };
 			auto firstLayoutState = m_graph.getCurrentLayoutState( context
-				, imageId
-				, viewId.data->info.viewType
-				, mipSubRange );
+				, chain.imageId
+				, chain.viewId.data->info.viewType
+				, firstRange );
 			context.memoryBarrier( commandBuffer
-				, imageId
-				, mipSubRange
+				, chain.imageId
+				, firstRange
 				, firstLayoutState.layout
 				, { VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
 					, VK_ACCESS_TRANSFER_READ_BIT
 					, VK_PIPELINE_STAGE_TRANSFER_BIT } );
 
-			// Copy down mips
-			while ( ++mipSubRange.baseMipLevel < mipLevels )
+			if ( chain.mipLevels > 1u )
 			{
-				// Blit from previous level
-				// Blit source is previous blit destination
-				imageBlit.srcSubresource = imageBlit.dstSubresource;
-				imageBlit.srcOffsets[0] = imageBlit.dstOffsets[0];
-				imageBlit.srcOffsets[1] = imageBlit.dstOffsets[1];
-
-				// Update blit destination
-				imageBlit.dstSubresource.mipLevel = mipSubRange.baseMipLevel;
-				imageBlit.dstOffsets[1].x = genMips::getSubresourceDimension( width, mipSubRange.baseMipLevel );
-				imageBlit.dstOffsets[1].y = genMips::getSubresourceDimension( height, mipSubRange.baseMipLevel );
-				imageBlit.dstOffsets[1].z = genMips::getSubresourceDimension( depth, mipSubRange.baseMipLevel );
-
-				// Transition current mip level to transfer dest
 				context.memoryBarrier( commandBuffer
-					, imageId
-					, mipSubRange
+					, chain.imageId
+					, { chain.aspectMask, 1u, chain.mipLevels - 1u, chain.baseArrayLayer, chain.layerCount }
 					, { VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
 						, getAccessMask( VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL )
 						, getStageMask( VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL ) } );
+			}
+		}
 
-				// Perform blit
-				m_context.vkCmdBlitImage( commandBuffer 
-					, image
-					, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
-					, image
-					, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
-					, 1u
-					, &imageBlit
-					, VK_FILTER_LINEAR );
-
-				// Transition previous mip level to wanted output layout
-				context.memoryBarrier( commandBuffer
-					, imageId
-					, { mipSubRange.aspectMask
-						, mipSubRange.baseMipLevel - 1u
-						, 1u
-						, mipSubRange.baseArrayLayer
-						, 1u }
-					, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
-					, nextLayoutState );
+		context.flushBarriers( commandBuffer );
 
-				if ( mipSubRange.baseMipLevel == ( mipLevels - 1u ) )
+		// Copy down mips, all the layers of a level at once.
+		for ( uint32_t level = 1u; level < maxLevels; ++level )
+		{
+			for ( auto & chain : chains )
+			{
+				if ( level < chain.mipLevels )
 				{
-					// Transition final mip level to wanted output layout
-					context.memoryBarrier( commandBuffer
-						, imageId
-						, mipSubRange
+					auto imageBlit = genMips::getBlit( chain, level );
+					m_context.vkCmdBlitImage( commandBuffer
+						, chain.image
+						, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+						, chain.image
 						, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
-						, nextLayoutState );
+						, 1u
+						, &imageBlit
+						, VK_FILTER_LINEAR );
 				}
-				else
+			}
+
+			// Transition current mip level to transfer source for read in next iteration
+			for ( auto & chain : chains )
+			{
+				if ( level + 1u < chain.mipLevels )
 				{
-					// Transition current mip level to transfer source for read in next iteration
 					context.memoryBarrier( commandBuffer
-						, imageId
-						, mipSubRange
+						, chain.imageId
+						, { chain.aspectMask, level, 1u, chain.baseArrayLayer, chain.layerCount }
 						, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
 						, { VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
 							, getAccessMask( VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL )
 							, getStageMask( VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL ) } );
 				}
 			}
+
+			context.flushBarriers( commandBuffer );
 		}
+
+		// All levels to wanted output layout, the last one is still a transfer destination.
+		for ( auto & chain : chains )
+		{
+			auto srcLevels = chain.mipLevels > 1u
+				? chain.mipLevels - 1u
+				: 1u;
+			context.memoryBarrier( commandBuffer
+				, chain.imageId
+				, { chain.aspectMask, 0u, srcLevels, chain.baseArrayLayer, chain.layerCount }
+				, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+				, chain.nextLayoutState );
+
+			if ( chain.mipLevels > 1u )
+			{
+				context.memoryBarrier( commandBuffer
+					, chain.imageId
+					, { chain.aspectMask, chain.mipLevels - 1u, 1u, chain.baseArrayLayer, chain.layerCount }
+					, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+					, chain.nextLayoutState );
+			}
+		}
+
+		context.endBarriersBatch( commandBuffer );
 	}
 }
@@ -3,6 +3,7 @@ This file belongs to FrameGraph.
 See LICENSE file in root folder.
 */
 #include "RenderGraph/RunnablePasses/ImageBlit.hpp"
+#include "CopyBatch.hpp"
 
 #include "RenderGraph/GraphContext.hpp"
 #include "RenderGraph/ImageData.hpp"
@@ -21,6 +22,13 @@ namespace crg
 				, range.baseArrayLayer
 				, range.layerCount };
 		}
+
+		static VkOffset3D convert( VkExtent3D const & extent )
+		{
+			return VkOffset3D{ int32_t( extent.width )
+				, int32_t( extent.height )
+				, int32_t( extent.depth ) };
+		}
 	}
 
 	ImageBlit::ImageBlit( FramePass const & pass
@@ -34,6 +42,31 @@ namespace crg
 		, ru::Config ruConfig
 		, GetPassIndexCallback passIndex
 		, IsEnabledCallback isEnabled )
+		: ImageBlit{ pass
+			, context
+			, graph
+			, { ImageBlitRegion{ 0u
+				, 1u
+				, VkImageBlit{ {}
+					, { blitSrcOffset, imgBlit::convert( blitSrcSize ) }
+					, {}
+					, { blitDstOffset, imgBlit::convert( blitDstSize ) } } } }
+			, filter
+			, std::move( ruConfig )
+			, std::move( passIndex )
+			, std::move( isEnabled ) }
+	{
+		assert( pass.images.size() == 2u );
+	}
+
+	ImageBlit::ImageBlit( FramePass const & pass
+		, GraphContext & context
+		, RunnableGraph & graph
+		, ImageBlitRegionArray regions
+		, VkFilter filter
+		, ru::Config ruConfig
+		, GetPassIndexCallback passIndex
+		, IsEnabledCallback isEnabled )
 		: RunnablePass{ pass
 			, context
 			, graph
@@ -43,34 +76,42 @@ namespace crg
 				, std::move( passIndex )
 				, std::move( isEnabled ) }
 			, std::move( ruConfig ) }
-		, m_srcOffset{ std::move( blitSrcOffset ) }
-		, m_srcSize{ std::move( blitSrcSize ) }
-		, m_dstOffset{ std::move( blitDstOffset ) }
-		, m_dstSize{ std::move( blitDstSize ) }
+		, m_regions{ std::move( regions ) }
 		, m_filter{ filter }
 	{
-		assert( pass.images.size() == 2u );
+		copyBatch::checkRegions( m_regions, m_pass.images.size(), m_pass.images.size() );
 	}
 
 	void ImageBlit::doRecordInto( RecordContext & context
 		, VkCommandBuffer commandBuffer
 		, uint32_t index )
 	{
-		auto srcAttach{ m_pass.images.front().view( index ) };
-		auto dstAttach{ m_pass.images.back().view( index ) };
-		auto srcImage{ m_graph.createImage( srcAttach.data->image ) };
-		auto dstImage{ m_graph.createImage( dstAttach.data->image ) };
-		VkImageBlit blitRegion{ imgBlit::convert( srcAttach.data->info.subresourceRange )
-			, { m_srcOffset, VkOffset3D{ int32_t( m_srcSize.width ), int32_t( m_srcSize.height ), int32_t( m_srcSize.depth ) } }
-			, imgBlit::convert( dstAttach.data->info.subresourceRange )
-			, { m_dstOffset, VkOffset3D{ int32_t( m_dstSize.width ), int32_t( m_dstSize.height ), int32_t( m_dstSize.depth ) } } };
-		context->vkCmdBlitImage( commandBuffer
-			, srcImage
-			, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
-			, dstImage
-			, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
-			, 1u
-			, &blitRegion
-			, m_filter );
+		// The regions sharing the same source and destination images are blitted with a single call.
+		copyBatch::CopyArrayT< VkImage, VkImage, VkImageBlit > blits;
+
+		for ( auto & blitRegion : m_regions )
+		{
+			auto srcAttach{ m_pass.images[blitRegion.src].view( index ) };
+			auto dstAttach{ m_pass.images[blitRegion.dst].view( index ) };
+			auto region = blitRegion.region;
+			region.srcSubresource = imgBlit::convert( srcAttach.data->info.subresourceRange );
+			region.dstSubresource = imgBlit::convert( dstAttach.data->info.subresourceRange );
+			copyBatch::addRegion( blits
+				, m_graph.createImage( srcAttach.data->image )
+				, m_graph.createImage( dstAttach.data->image )
+				, region );
+		}
+
+		for ( auto & blit : blits )
+		{
+			context->vkCmdBlitImage( commandBuffer
+				, blit.src
+				, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+				, blit.dst
+				, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+				, uint32_t( blit.regions.size() )
+				, blit.regions.data()
+				, m_filter );
+		}
 	}
 }
@@ -3,6 +3,7 @@ This file belongs to FrameGraph.
 See LICENSE file in root folder.
 */
 #include "RenderGraph/RunnablePasses/ImageCopy.hpp"
+#include "CopyBatch.hpp"
 
 #include "RenderGraph/GraphContext.hpp"
 #include "RenderGraph/ImageData.hpp"
@@ -21,6 +22,22 @@ namespace crg
 				, range.baseArrayLayer
 				, range.layerCount };
 		}
+
+		static ImageCopyRegionArray getDefaultRegions( FramePass const & pass
+			, VkExtent3D copySize )
+		{
+			// The images are taken as (source, destination) pairs.
+			ImageCopyRegionArray result;
+
+			for ( uint32_t i = 0u; i + 1u < pass.images.size(); i += 2u )
+			{
+				result.push_back( ImageCopyRegion{ i
+					, i + 1u
+					, VkImageCopy{ {}, {}, {}, {}, copySize } } );
+			}
+
+			return result;
+		}
 	}
 
 	ImageCopy::ImageCopy( FramePass const & pass
@@ -31,17 +48,14 @@ namespace crg
 		, ru::Config ruConfig
 		, GetPassIndexCallback passIndex
 		, IsEnabledCallback isEnabled )
-		: RunnablePass{ pass
+		: ImageCopy{ pass
 			, context
 			, graph
-			, { defaultV< InitialiseCallback >
-				, GetPipelineStateCallback( [](){ return crg::getPipelineState( VK_PIPELINE_STAGE_TRANSFER_BIT ); } )
-				, [this]( RecordContext & recContext, VkCommandBuffer cb, uint32_t i ){ doRecordInto( recContext, cb, i ); }
-				, std::move( passIndex )
-				, std::move( isEnabled ) }
-			, std::move( ruConfig ) }
-		, m_copySize{std::move( copySize ) }
-		, m_finalOutputLayout{ finalOutputLayout }
+			, imgCopy::getDefaultRegions( pass, copySize )
+			, finalOutputLayout
+			, std::move( ruConfig )
+			, std::move( passIndex )
+			, std::move( isEnabled ) }
 	{
 		assert( ( pass.images.size() % 2u ) == 0u );
 	}
@@ -62,49 +76,74 @@ namespace crg
 			, std::move( passIndex )
 			, std::move( isEnabled ) }
 	{
-		assert( ( pass.images.size() % 2u ) == 0u );
+	}
+
+	ImageCopy::ImageCopy( FramePass const & pass
+		, GraphContext & context
+		, RunnableGraph & graph
+		, ImageCopyRegionArray regions
+		, VkImageLayout finalOutputLayout
+		, ru::Config ruConfig
+		, GetPassIndexCallback passIndex
+		, IsEnabledCallback isEnabled )
+		: RunnablePass{ pass
+			, context
+			, graph
+			, { defaultV< InitialiseCallback >
+				, GetPipelineStateCallback( [](){ return crg::getPipelineState( VK_PIPELINE_STAGE_TRANSFER_BIT ); } )
+				, [this]( RecordContext & recContext, VkCommandBuffer cb, uint32_t i ){ doRecordInto( recContext, cb, i ); }
+				, std::move( passIndex )
+				, std::move( isEnabled ) }
+			, std::move( ruConfig ) }
+		, m_regions{ std::move( regions ) }
+		, m_finalOutputLayout{ finalOutputLayout }
+	{
+		copyBatch::checkRegions( m_regions, m_pass.images.size(), m_pass.images.size() );
 	}
 
 	void ImageCopy::doRecordInto( RecordContext & context
 		, VkCommandBuffer commandBuffer
 		, uint32_t index )
 	{
-		auto srcIt = m_pass.images.begin();
-		auto dstIt = std::next( srcIt );
+		// The regions sharing the same source and destination images are copied with a single call.
+		copyBatch::CopyArrayT< VkImage, VkImage, VkImageCopy > copies;
+
+		for ( auto & copyRegion : m_regions )
+		{
+			auto srcAttach{ m_pass.images[copyRegion.src].view( index ) };
+			auto dstAttach{ m_pass.images[copyRegion.dst].view( index ) };
+			auto region = copyRegion.region;
+			region.srcSubresource = imgCopy::convert( srcAttach.data->info.subresourceRange );
+			region.dstSubresource = imgCopy::convert( dstAttach.data->info.subresourceRange );
+			copyBatch::addRegion( copies
+				, m_graph.createImage( srcAttach.data->image )
+				, m_graph.createImage( dstAttach.data->image )
+				, region );
+		}
 
-		while ( srcIt != m_pass.images.end() )
+		for ( auto & copy : copies )
 		{
-			auto srcAttach{ srcIt->view( index ) };
-			auto dstAttach{ dstIt->view( index ) };
-			auto srcImage{ m_graph.createImage( srcAttach.data->image ) };
-			auto dstImage{ m_graph.createImage( dstAttach.data->image ) };
-			// Copy source to target.
-			VkImageCopy copyRegion{ imgCopy::convert( srcAttach.data->info.subresourceRange )
-				, {}
-				, imgCopy::convert( dstAttach.data->info.subresourceRange )
-				, {}
-				, m_copySize };
 			context->vkCmdCopyImage( commandBuffer
-				, srcImage
+				, copy.src
 				, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
-				, dstImage
+				, copy.dst
 				, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
-				, 1u
-				, &copyRegion );
+				, uint32_t( copy.regions.size() )
+				, copy.regions.data() );
+		}
+
+		if ( m_finalOutputLayout != VK_IMAGE_LAYOUT_UNDEFINED )
+		{
+			context.beginBarriersBatch();
 
-			if ( m_finalOutputLayout != VK_IMAGE_LAYOUT_UNDEFINED )
+			for ( auto & copyRegion : m_regions )
 			{
 				context.memoryBarrier( commandBuffer
-					, dstAttach
+					, m_pass.images[copyRegion.dst].view( index )
 					, crg::makeLayoutState( m_finalOutputLayout ) );
 			}
 
-			srcIt = std::next( dstIt );
-
-			if ( srcIt != m_pass.images.end() )
-			{
-				dstIt = std::next( srcIt );
-			}
+			context.endBarriersBatch( commandBuffer );
 		}
 	}
 }
@@ -0,0 +1,139 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#include "RenderGraph/RunnablePasses/ImageReadback.hpp"
+#include "CopySize.hpp"
+#include "../HostVisibleBuffer.hpp"
+
+#include "RenderGraph/Exception.hpp"
+#include "RenderGraph/GraphContext.hpp"
+#include "RenderGraph/ImageData.hpp"
+#include "RenderGraph/RunnableGraph.hpp"
+
+#include <algorithm>
+
+namespace crg
+{
+	namespace imgRbk
+	{
+		static VkImageSubresourceLayers convert( VkImageSubresourceRange const & range )
+		{
+			return VkImageSubresourceLayers{ range.aspectMask
+				, range.baseMipLevel
+				, range.baseArrayLayer
+				, range.layerCount };
+		}
+	}
+
+	ImageReadback::ImageReadback( FramePass const & pass
+		, GraphContext & context
+		, RunnableGraph & graph
+		, VkOffset3D copyOffset
+		, VkExtent3D copySize
+		, VkDeviceSize frameSize
+		, ReadbackCallback callback
+		, uint32_t frameCount
+		, ru::Config ruConfig
+		, GetPassIndexCallback passIndex
+		, IsEnabledCallback isEnabled )
+		: RunnablePass{ pass
+			, context
+			, graph
+			, { defaultV< InitialiseCallback >
+				, GetPipelineStateCallback( [](){ return crg::getPipelineState( VK_PIPELINE_STAGE_TRANSFER_BIT ); } )
+				, [this]( RecordContext & recContext, VkCommandBuffer cb, uint32_t i ){ doRecordInto( recContext, cb, i ); }
+				, std::move( passIndex )
+				, std::move( isEnabled ) }
+			, std::move( ruConfig ) }
+		, m_copyOffset{ std::move( copyOffset ) }
+		, m_copySize{ std::move( copySize ) }
+		, m_frameSize{ frameSize }
+		, m_callback{ std::move( callback ) }
+		, m_pending( std::max( 1u, frameCount ), false )
+	{
+		if ( m_pass.images.empty() )
+		{
+			CRG_Exception( m_pass.getGroupName() + " - No image to read back" );
+		}
+
+		if ( getCopySize( *m_pass.images.back().view().data, m_copySize ) > m_frameSize )
+		{
+			CRG_Exception( m_pass.getGroupName() + " - The copied region doesn't fit in the readback frame size" );
+		}
+
+		// Cached memory is preferred, host reads from uncached memory are slow.
+		createHostVisibleBuffer( m_context
+			, m_pass.getGroupName() + "/Readback"
+			, m_frameSize * m_pending.size()
+			, VK_BUFFER_USAGE_TRANSFER_DST_BIT
+			, VK_MEMORY_PROPERTY_HOST_CACHED_BIT
+			, m_buffer
+			, m_memory
+			, m_data );
+	}
+
+	ImageReadback::~ImageReadback()noexcept
+	{
+		// Data of the frames still in flight is dropped.
+		destroyHostVisibleBuffer( m_context
+			, m_buffer
+			, m_memory
+			, m_data );
+	}
+
+	void ImageReadback::doRecordInto( RecordContext & context
+		, VkCommandBuffer commandBuffer
+		, uint32_t index )
+	{
+		// The readback segment changes each frame, so must the recorded copy.
+		context.setVolatile();
+		doDeliver();
+
+		auto srcAttach{ m_pass.images.back().view( index ) };
+		auto srcImage{ m_graph.createImage( srcAttach.data->image ) };
+		auto range = imgRbk::convert( srcAttach.data->info.subresourceRange );
+		VkDeviceSize offset = m_current * m_frameSize;
+		VkBufferImageCopy copyRegion{ offset
+			, 0u
+			, 0u
+			, range
+			, m_copyOffset
+			, m_copySize };
+		context->vkCmdCopyImageToBuffer( commandBuffer
+			, srcImage
+			, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+			, m_buffer
+			, 1u
+			, &copyRegion );
+		// Make the transfer writes available to the host reads.
+		context.memoryBarrier( commandBuffer
+			, m_buffer
+			, BufferSubresourceRange{ offset, m_frameSize }
+			, VK_ACCESS_TRANSFER_WRITE_BIT
+			, VK_PIPELINE_STAGE_TRANSFER_BIT
+			, AccessState{ VK_ACCESS_HOST_READ_BIT, VK_PIPELINE_STAGE_HOST_BIT } );
+		m_pending[m_current] = true;
+		m_current = uint32_t( ( m_current + 1u ) % m_pending.size() );
+	}
+
+	void ImageReadback::doDeliver()
+	{
+		// The graph waits for its fence before recording, so every frame recorded
+		// before this one has completed: their segments can be handed to the host.
+		for ( uint32_t i = 0u; i < m_pending.size(); ++i )
+		{
+			auto segment = uint32_t( ( m_current + i ) % m_pending.size() );
+
+			if ( m_pending[segment] )
+			{
+				m_pending[segment] = false;
+
+				if ( m_data && m_callback )
+				{
+					m_callback( m_data + segment * m_frameSize, m_frameSize );
+				}
+			}
+		}
+	}
+}
@@ -3,11 +3,13 @@ This file belongs to FrameGraph.
 See LICENSE file in root folder.
 */
 #include "RenderGraph/RunnablePasses/ImageToBufferCopy.hpp"
+#include "CopyBatch.hpp"
 
 #include "RenderGraph/GraphContext.hpp"
 #include "RenderGraph/ImageData.hpp"
 #include "RenderGraph/RunnableGraph.hpp"
 
+#include <algorithm>
 #include <array>
 
 namespace crg
@@ -21,6 +23,16 @@ namespace crg
 				, range.baseArrayLayer
 				, range.layerCount };
 		}
+
+		static BufferImageCopyRegionArray getDefaultRegions( FramePass const & pass
+			, VkOffset3D copyOffset
+			, VkExtent3D copySize )
+		{
+			// The last image is copied into the first buffer.
+			return { BufferImageCopyRegion{ uint32_t( std::max( pass.images.size(), size_t( 1u ) ) - 1u )
+				, 0u
+				, VkBufferImageCopy{ 0u, 0u, 0u, {}, copyOffset, copySize } } };
+		}
 	}
 
 	ImageToBufferCopy::ImageToBufferCopy( FramePass const & pass
@@ -31,6 +43,23 @@ namespace crg
 		, ru::Config ruConfig
 		, GetPassIndexCallback passIndex
 		, IsEnabledCallback isEnabled )
+		: ImageToBufferCopy{ pass
+			, context
+			, graph
+			, imToBuf::getDefaultRegions( pass, copyOffset, copySize )
+			, std::move( ruConfig )
+			, std::move( passIndex )
+			, std::move( isEnabled ) }
+	{
+	}
+
+	ImageToBufferCopy::ImageToBufferCopy( FramePass const & pass
+		, GraphContext & context
+		, RunnableGraph & graph
+		, BufferImageCopyRegionArray regions
+		, ru::Config ruConfig
+		, GetPassIndexCallback passIndex
+		, IsEnabledCallback isEnabled )
 		: RunnablePass{ pass
 			, context
 			, graph
@@ -40,31 +69,37 @@ namespace crg
 				, std::move( passIndex )
 				, std::move( isEnabled ) }
 			, std::move( ruConfig ) }
-		, m_copyOffset{ std::move( copyOffset ) }
-		, m_copySize{ std::move( copySize ) }
+		, m_regions{ std::move( regions ) }
 	{
+		copyBatch::checkRegions( m_regions, m_pass.images.size(), m_pass.buffers.size() );
 	}
 
 	void ImageToBufferCopy::doRecordInto( RecordContext & context
 		, VkCommandBuffer commandBuffer
 		, uint32_t index )
 	{
-		auto srcAttach{ m_pass.images.back().view( index ) };
-		auto dstBuffer{ m_pass.buffers.front().buffer( index ) };
-		auto srcImage{ m_graph.createImage( srcAttach.data->image ) };
-		// Copy source to target.
-		auto range = imToBuf::convert( srcAttach.data->info.subresourceRange );
-		VkBufferImageCopy copyRegion{ 0ULL
-			, 0u
-			, 0u
-			, range
-			, m_copyOffset
-			, m_copySize };
-		context->vkCmdCopyImageToBuffer( commandBuffer
-			, srcImage
-			, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
-			, dstBuffer
-			, 1u
-			, &copyRegion );
+		// The regions sharing the same image and buffer are copied with a single call.
+		copyBatch::CopyArrayT< VkImage, VkBuffer, VkBufferImageCopy > copies;
+
+		for ( auto & copyRegion : m_regions )
+		{
+			auto srcAttach{ m_pass.images[copyRegion.src].view( index ) };
+			auto region = copyRegion.region;
+			region.imageSubresource = imToBuf::convert( srcAttach.data->info.subresourceRange );
+			copyBatch::addRegion( copies
+				, m_graph.createImage( srcAttach.data->image )
+				, m_pass.buffers[copyRegion.dst].buffer( index )
+				, region );
+		}
+
+		for ( auto & copy : copies )
+		{
+			context->vkCmdCopyImageToBuffer( commandBuffer
+				, copy.src
+				, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+				, copy.dst
+				, uint32_t( copy.regions.size() )
+				, copy.regions.data() );
+		}
 	}
 }
@@ -4,13 +4,98 @@ See LICENSE file in root folder.
 #include "RenderGraph/RunnablePasses/PipelineHolder.hpp"
 
 #include "RenderGraph/GraphContext.hpp"
+#include "RenderGraph/Log.hpp"
 #include "RenderGraph/RunnableGraph.hpp"
 #include "RenderGraph/RunnablePasses/RenderPass.hpp"
 
 #include <cassert>
+#include <chrono>
 
 namespace crg
 {
+	namespace pphdl
+	{
+		static VkResult createPipeline( GraphContext & context
+			, VkGraphicsPipelineCreateInfo const & createInfo
+			, VkPipeline & pipeline )
+		{
+			return context.vkCreateGraphicsPipelines( context.device
+				, context.cache
+				, 1u
+				, &createInfo
+				, context.allocator
+				, &pipeline );
+		}
+
+		static VkResult createPipeline( GraphContext & context
+			, VkComputePipelineCreateInfo const & createInfo
+			, VkPipeline & pipeline )
+		{
+			return context.vkCreateComputePipelines( context.device
+				, context.cache
+				, 1u
+				, &createInfo
+				, context.allocator
+				, &pipeline );
+		}
+
+		static VkGraphicsPipelineCreateInfo replaceProgram( VkGraphicsPipelineCreateInfo createInfo
+			, VkPipelineShaderStageCreateInfoArray const & program )
+		{
+			createInfo.stageCount = uint32_t( program.size() );
+			createInfo.pStages = program.data();
+			return createInfo;
+		}
+
+		static VkComputePipelineCreateInfo replaceProgram( VkComputePipelineCreateInfo createInfo
+			, VkPipelineShaderStageCreateInfoArray const & program )
+		{
+			createInfo.stage = program.front();
+			return createInfo;
+		}
+
+		static VkPipelineShaderStageCreateInfoArray getProgram( VkGraphicsPipelineCreateInfo const & createInfo )
+		{
+			return { createInfo.pStages, createInfo.pStages + createInfo.stageCount };
+		}
+
+		static VkPipelineShaderStageCreateInfoArray getProgram( VkComputePipelineCreateInfo const & createInfo )
+		{
+			return { createInfo.stage };
+		}
+
+		static void destroyPipeline( GraphContext & context
+			, VkPipeline & pipeline )noexcept
+		{
+			if ( pipeline != VkPipeline{} )
+			{
+				crgUnregisterObject( context, pipeline );
+				context.vkDestroyPipeline( context.device
+					, pipeline
+					, context.allocator );
+				pipeline = {};
+			}
+		}
+
+		static void deferDestroyPipeline( GraphContext & context
+			, VkPipeline & pipeline )
+		{
+			if ( pipeline != VkPipeline{} )
+			{
+				context.delQueue.push( [toDestroy = pipeline]( GraphContext & ctx )
+					{
+						crgUnregisterObject( ctx, toDestroy );
+						ctx.vkDestroyPipeline( ctx.device
+							, toDestroy
+							, ctx.allocator );
+					} );
+				pipeline = {};
+			}
+		}
+	}
+
+	//*********************************************************************************************
+
 	PipelineHolder::PipelineHolder( FramePass const & pass
 		, GraphContext & context
 		, RunnableGraph & graph
@@ -23,7 +108,10 @@ namespace crg
 		, m_baseConfig{ config.m_programs ? std::move( *config.m_programs ) : defaultV< std::vector< VkPipelineShaderStageCreateInfoArray > >
 			, config.m_programCreator ? std::move( *config.m_programCreator ) : defaultV< ProgramCreator >
 			, config.m_layouts ? std::move( *config.m_layouts ) : defaultV< std::vector< VkDescriptorSetLayout > >
-			, config.m_pushConstants ? std::move( *config.m_pushConstants ) : defaultV< std::vector< VkPushConstantRange > > }
+			, config.m_pushConstants ? std::move( *config.m_pushConstants ) : defaultV< std::vector< VkPushConstantRange > >
+			, config.m_asyncCompile ? *config.m_asyncCompile : false
+			, config.m_fallbackProgram ? std::move( *config.m_fallbackProgram ) : defaultV< VkPipelineShaderStageCreateInfoArray >
+			, config.m_pushConstantsData ? *config.m_pushConstantsData : nullptr }
 		, m_bindingPoint{ bindingPoint }
 	{
 		if ( m_baseConfig.m_programCreator.create )
@@ -36,6 +124,8 @@ namespace crg
 			m_pipelines.resize( m_baseConfig.m_programs.size(), VkPipeline{} );
 		}
 
+		m_fallbackPipelines.resize( m_pipelines.size(), VkPipeline{} );
+		m_pendingPipelines.resize( m_pipelines.size() );
 		m_descriptorSets.resize( maxPassCount );
 	}
 
@@ -57,6 +147,21 @@ namespace crg
 
 	void PipelineHolder::cleanup()noexcept
 	{
+		for ( uint32_t index = 0u; index < m_pendingPipelines.size(); ++index )
+		{
+			if ( m_pendingPipelines[index].pipeline.valid() )
+			{
+				try
+				{
+					doRetrievePipeline( index );
+				}
+				catch ( std::exception & exc )
+				{
+					Logger::logError( exc.what() );
+				}
+			}
+		}
+
 		m_descriptorBindings.clear();
 
 		for ( auto & descriptorSet : m_descriptorSets )
@@ -80,14 +185,12 @@ namespace crg
 
 		for ( auto & pipeline : m_pipelines )
 		{
-			if ( pipeline != VkPipeline{} )
-			{
-				crgUnregisterObject( m_context, pipeline );
-				m_context.vkDestroyPipeline( m_context.device
-					, pipeline
-					, m_context.allocator );
-				pipeline = {};
-			}
+			pphdl::destroyPipeline( m_context, pipeline );
+		}
+
+		for ( auto & pipeline : m_fallbackPipelines )
+		{
+			pphdl::destroyPipeline( m_context, pipeline );
 		}
 
 		if ( m_pipelineLayout )
@@ -128,14 +231,7 @@ namespace crg
 
 	VkPipeline & PipelineHolder::getPipeline( uint32_t index )
 	{
-		if ( m_baseConfig.m_programs.size() == 1u )
-		{
-			assert( m_pipelines.size() == 1u );
-			return m_pipelines[0];
-		}
-
-		assert( m_pipelines.size() > index );
-		return m_pipelines[index];
+		return m_pipelines[doGetPipelineIndex( index )];
 	}
 
 	void PipelineHolder::createPipeline( uint32_t index
@@ -144,15 +240,7 @@ namespace crg
 	{
 		if ( m_context.vkCreateGraphicsPipelines )
 		{
-			auto & pipeline = getPipeline( index );
-			auto res = m_context.vkCreateGraphicsPipelines( m_context.device
-				, m_context.cache
-				, 1u
-				, &createInfo
-				, m_context.allocator
-				, &pipeline );
-			crg::checkVkResult( res, name + " - Pipeline creation" );
-			crgRegisterObject( m_context, name, pipeline );
+			doCreatePipeline( index, name, createInfo );
 		}
 	}
 
@@ -170,15 +258,7 @@ namespace crg
 	{
 		if ( m_context.vkCreateComputePipelines )
 		{
-			auto & pipeline = getPipeline( index );
-			auto res = m_context.vkCreateComputePipelines( m_context.device
-				, m_context.cache
-				, 1u
-				, &createInfo
-				, m_context.allocator
-				, &pipeline );
-			checkVkResult( res, name + " - Pipeline creation" );
-			crgRegisterObject( m_context, name, pipeline );
+			doCreatePipeline( index, name, createInfo );
 		}
 	}
 
@@ -190,46 +270,85 @@ namespace crg
 			, createInfo );
 	}
 
-	void PipelineHolder::recordInto( RecordContext & context
+	bool PipelineHolder::recordInto( RecordContext & context
 		, VkCommandBuffer commandBuffer
 		, uint32_t index )
 	{
+		auto pipeline = getPipeline( index );
+
+		if ( m_baseConfig.m_asyncCompile
+			&& !isPipelineReady( index ) )
+		{
+			context.setVolatile();
+			pipeline = m_fallbackPipelines[doGetPipelineIndex( index )];
+
+			if ( !pipeline )
+			{
+				return false;
+			}
+		}
+
 		createDescriptorSet( index );
-		auto & pipeline = getPipeline( index );
 		context->vkCmdBindPipeline( commandBuffer, m_bindingPoint, pipeline );
 		context->vkCmdBindDescriptorSets( commandBuffer, m_bindingPoint, m_pipelineLayout, 0u, 1u, &m_descriptorSets[index].set, 0u, nullptr );
+
+		if ( auto data = static_cast< uint8_t const * >( m_baseConfig.m_pushConstantsData ) )
+		{
+			// The values are read at record time, so the pass can't be pre-recorded.
+			context.setVolatile();
+
+			for ( auto & range : m_baseConfig.m_pushConstants )
+			{
+				context->vkCmdPushConstants( commandBuffer, m_pipelineLayout, range.stageFlags, range.offset, range.size, data + range.offset );
+			}
+		}
+
+		return true;
 	}
 
 	void PipelineHolder::resetPipeline( VkPipelineShaderStageCreateInfoArray config
 		, uint32_t index )
 	{
-		assert( m_pipelines.size() == 1u || index < m_pipelines.size() );
+		auto programCount = uint32_t( m_baseConfig.m_programs.size() );
+		assert( programCount == 1u || index < programCount );
 
-		if ( m_pipelines.size() == 1u )
+		if ( programCount == 1u )
 		{
 			index = 0u;
 		}
 
-		if ( m_pipelines[index] )
+		// Pending compilations of any index may still read the pipeline states
+		// about to be modified by the caller, since they all share them.
+		doWaitPendingPipelines();
+		m_graph.invalidateVariants();
+
+		// The program is shared by all the pipeline sets.
+		for ( auto pipelineIndex = index; pipelineIndex < m_pipelines.size(); pipelineIndex += programCount )
 		{
-			auto pipeline = m_pipelines[index];
-			m_context.delQueue.push( [pipeline]( GraphContext & context )
-				{
-					crgUnregisterObject( context, pipeline );
-					context.vkDestroyPipeline( context.device
-						, pipeline
-						, context.allocator );
-				} );
-			m_pipelines[index] = {};
+			pphdl::deferDestroyPipeline( m_context, m_pipelines[pipelineIndex] );
+			pphdl::deferDestroyPipeline( m_context, m_fallbackPipelines[pipelineIndex] );
 		}
 
 		if ( !config.empty() )
 		{
-			assert( m_baseConfig.m_programs.size() > index );
 			m_baseConfig.m_programs[index] = std::move( config );
 		}
 	}
 
+	void PipelineHolder::selectPipelineSet( uint32_t set )
+	{
+		auto size = ( set + 1u ) * m_baseConfig.m_programs.size();
+
+		if ( m_pipelines.size() < size )
+		{
+			m_pipelines.resize( size, VkPipeline{} );
+			m_fallbackPipelines.resize( size, VkPipeline{} );
+			m_pendingPipelines.resize( size );
+		}
+
+		m_currentSet = set;
+	}
+
 	void PipelineHolder::createDescriptorSet( uint32_t index )
 	{
 		auto & descriptorSet = m_descriptorSets[index];
@@ -294,6 +413,27 @@ namespace crg
 			, nullptr );
 	}
 
+	bool PipelineHolder::isPipelineReady( uint32_t index )
+	{
+		index = doGetPipelineIndex( index );
+
+		if ( auto & pending = m_pendingPipelines[index];
+			pending.pipeline.valid()
+			&& pending.pipeline.wait_for( std::chrono::seconds{} ) == std::future_status::ready )
+		{
+			doRetrievePipeline( index );
+		}
+
+		return m_pipelines[index] != VkPipeline{};
+	}
+
+	bool PipelineHolder::hasPipeline( uint32_t index )const
+	{
+		index = doGetPipelineIndex( index );
+		return m_pipelines[index] != VkPipeline{}
+			|| m_pendingPipelines[index].pipeline.valid();
+	}
+
 	void PipelineHolder::doFillDescriptorBindings()
 	{
 		m_descriptorBindings.clear();
@@ -394,4 +534,85 @@ namespace crg
 			crgRegisterObject( m_context, m_pass.getGroupName(), m_descriptorSetPool );
 		}
 	}
+
+	uint32_t PipelineHolder::doGetPipelineIndex( uint32_t index )const
+	{
+		auto programCount = uint32_t( m_baseConfig.m_programs.size() );
+
+		if ( programCount == 1u )
+		{
+			index = 0u;
+		}
+
+		assert( programCount > index );
+		return m_currentSet * programCount + index;
+	}
+
+	template< typename CreateInfoT >
+	void PipelineHolder::doCreatePipeline( uint32_t index
+		, std::string const & name
+		, CreateInfoT const & createInfo )
+	{
+		index = doGetPipelineIndex( index );
+
+		if ( !m_baseConfig.m_asyncCompile )
+		{
+			auto & pipeline = m_pipelines[index];
+			auto res = pphdl::createPipeline( m_context, createInfo, pipeline );
+			checkVkResult( res, name + " - Pipeline creation" );
+			crgRegisterObject( m_context, name, pipeline );
+			return;
+		}
+
+		auto & pending = m_pendingPipelines[index];
+
+		if ( pending.pipeline.valid() )
+		{
+			return;
+		}
+
+		if ( auto & fallback = m_fallbackPipelines[index];
+			!fallback && !m_baseConfig.m_fallbackProgram.empty() )
+		{
+			auto res = pphdl::createPipeline( m_context
+				, pphdl::replaceProgram( createInfo, m_baseConfig.m_fallbackProgram )
+				, fallback );
+			checkVkResult( res, name + " - Fallback pipeline creation" );
+			crgRegisterObject( m_context, name + "/Fallback", fallback );
+		}
+
+		// The create info and the program are copied, since the program may be recreated by getProgram.
+		// The other states it points to are owned by the pipeline users, which only modify them
+		// after resetPipeline, which waits for all pending compilations.
+		pending.name = name;
+		pending.pipeline = std::async( std::launch::async
+			, [&context = m_context, createInfo, program = pphdl::getProgram( createInfo ), name]()
+			{
+				VkPipeline result{};
+				auto res = pphdl::createPipeline( context, pphdl::replaceProgram( createInfo, program ), result );
+				checkVkResult( res, name + " - Pipeline creation" );
+				return result;
+			} );
+	}
+
+	void PipelineHolder::doRetrievePipeline( uint32_t index )
+	{
+		auto & pending = m_pendingPipelines[index];
+		auto & pipeline = m_pipelines[index];
+		auto result = pending.pipeline.get();
+		pphdl::destroyPipeline( m_context, pipeline );
+		pipeline = result;
+		crgRegisterObject( m_context, pending.name, pipeline );
+	}
+
+	void PipelineHolder::doWaitPendingPipelines()
+	{
+		for ( uint32_t index = 0u; index < m_pendingPipelines.size(); ++index )
+		{
+			if ( m_pendingPipelines[index].pipeline.valid() )
+			{
+				doRetrievePipeline( index );
+			}
+		}
+	}
 }
@@ -35,6 +35,11 @@ namespace crg
 			, ruConfig.maxPassCount
 			, m_renderMesh.getRenderSize() }
 	{
+		// The end callback records commands after the render pass, this can't be done for a subpass.
+		if ( !m_renderMesh.hasEnd() )
+		{
+			graph.registerSubpass( *this, m_renderPass );
+		}
 	}
 
 	void RenderMesh::resetPipeline( VkPipelineShaderStageCreateInfoArray config
@@ -55,12 +60,18 @@ namespace crg
 			m_renderMesh.initialise( m_renderPass.getRenderSize()
 				, m_renderPass.getRenderPass( index )
 				, m_renderPass.createBlendState()
-				, index );
+				, index
+				, m_renderPass.getRenderingFormats( index )
+				, m_renderPass.getSubpass() );
 		}
 
 		m_renderPass.begin( context, commandBuffer, VK_SUBPASS_CONTENTS_INLINE, index );
-		m_renderMesh.record( context, commandBuffer, index );
+		auto recorded = m_renderMesh.record( context, commandBuffer, index );
 		m_renderPass.end( context, commandBuffer );
-		m_renderMesh.end( context, commandBuffer, index );
+
+		if ( recorded )
+		{
+			m_renderMesh.end( context, commandBuffer, index );
+		}
 	}
 }
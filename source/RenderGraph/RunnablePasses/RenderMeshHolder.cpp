@@ -3,6 +3,9 @@ This file belongs to FrameGraph.
 See LICENSE file in root folder.
 */
 #include "RenderGraph/RunnablePasses/RenderMeshHolder.hpp"
+#include "RenderGraph/Exception.hpp"
+
+#include <cassert>
 
 namespace crg
 {
@@ -25,7 +28,8 @@ namespace crg
 			, config.m_getCullMode ? std::move( *config.m_getCullMode ) : getDefaultV< GetCullModeCallback >()
 			, config.m_vertexBuffer ? std::move( *config.m_vertexBuffer ) : getDefaultV< VertexBuffer >()
 			, config.m_indexBuffer ? std::move( *config.m_indexBuffer ) : getDefaultV< IndexBuffer >()
-			, config.m_indirectBuffer ? *config.m_indirectBuffer : getDefaultV< IndirectBuffer >() }
+			, config.m_indirectBuffer ? *config.m_indirectBuffer : getDefaultV< IndirectBuffer >()
+			, config.m_indirectCountBuffer ? *config.m_indirectCountBuffer : getDefaultV< IndirectCountBuffer >() }
 		, m_pipeline{ pass
 			, context
 			, graph
@@ -33,7 +37,19 @@ namespace crg
 			, VK_PIPELINE_BIND_POINT_GRAPHICS
 			, maxPassCount }
 		, m_renderSize{ config.m_renderSize ? *config.m_renderSize : getDefaultV< VkExtent2D >() }
+		, m_passStates( maxPassCount, 0u )
+		, m_hasEnd{ config.m_end }
 	{
+		if ( m_config.indirectCountBuffer.buffer.buffer() )
+		{
+#if VK_VERSION_1_2
+			if ( !context.vkCmdDrawIndexedIndirectCount || !context.vkCmdDrawIndirectCount )
+#endif
+			{
+				CRG_Exception( "Indirect count draws are not supported by the device" );
+			}
+		}
+
 		m_iaState = { VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO
 			, nullptr
 			, 0u
@@ -66,20 +82,12 @@ namespace crg
 	void RenderMeshHolder::initialise( VkExtent2D const & renderSize
 		, VkRenderPass renderPass
 		, VkPipelineColorBlendStateCreateInfo blendState
-		, uint32_t index )
+		, uint32_t index
+		, RenderingFormats const & formats
+		, uint32_t subpass )
 	{
 		m_pipeline.initialise();
-
-		if ( !m_renderPass )
-		{
-			doPreparePipelineStates( renderSize, renderPass, std::move( blendState ) );
-		}
-		else if ( m_renderPass != renderPass )
-		{
-			resetRenderPass( renderSize, renderPass, std::move( blendState ), index );
-		}
-
-		doCreatePipeline( index );
+		resetRenderPass( renderSize, renderPass, std::move( blendState ), index, formats, subpass );
 	}
 
 	void RenderMeshHolder::cleanup()
@@ -90,10 +98,14 @@ namespace crg
 	void RenderMeshHolder::resetRenderPass( VkExtent2D const & renderSize
 		, VkRenderPass renderPass
 		, VkPipelineColorBlendStateCreateInfo blendState
-		, uint32_t index )
+		, uint32_t index
+		, RenderingFormats const & formats
+		, uint32_t subpass )
 	{
-		m_pipeline.resetPipeline( {}, index );
-		doPreparePipelineStates( renderSize, renderPass, std::move( blendState ) );
+		assert( m_passStates.size() > index );
+		m_passStates[index] = doPreparePipelineStates( renderSize, renderPass, std::move( blendState ), formats, subpass );
+		m_renderSize = renderSize;
+		m_prepared = true;
 		doCreatePipeline( index );
 	}
 
@@ -102,18 +114,23 @@ namespace crg
 	{
 		m_pipeline.resetPipeline( std::move( config ), index );
 
-		if ( m_renderPass )
+		if ( m_prepared )
 		{
 			doCreatePipeline( index );
 		}
 	}
 
-	void RenderMeshHolder::record( RecordContext & context
+	bool RenderMeshHolder::record( RecordContext & context
 		, VkCommandBuffer commandBuffer
 		, uint32_t index )
 	{
 		doCreatePipeline( index );
-		m_pipeline.recordInto( context, commandBuffer, index );
+
+		if ( !m_pipeline.recordInto( context, commandBuffer, index ) )
+		{
+			return false;
+		}
+
 		m_config.recordInto( context, commandBuffer, index );
 		VkDeviceSize offset{};
 
@@ -124,15 +141,14 @@ namespace crg
 
 		if ( auto indirectBuffer = m_config.indirectBuffer.buffer.buffer( index ) )
 		{
-			if ( auto indexBuffer = m_config.indexBuffer.buffer.buffer( index ) )
+			auto indexBuffer = m_config.indexBuffer.buffer.buffer( index );
+
+			if ( indexBuffer )
 			{
 				context->vkCmdBindIndexBuffer( commandBuffer, indexBuffer, offset, m_config.getIndexType() );
-				context->vkCmdDrawIndexedIndirect( commandBuffer, indirectBuffer, m_config.indirectBuffer.offset, 1u, m_config.indirectBuffer.stride );
-			}
-			else
-			{
-				context->vkCmdDrawIndirect( commandBuffer, indirectBuffer, m_config.indirectBuffer.offset, 1u, m_config.indirectBuffer.stride );
 			}
+
+			doRecordIndirectDraw( context, commandBuffer, indirectBuffer, indexBuffer != VkBuffer{}, index );
 		}
 		else if ( auto indexBuffer = m_config.indexBuffer.buffer.buffer( index ) )
 		{
@@ -143,6 +159,43 @@ namespace crg
 		{
 			context->vkCmdDraw( commandBuffer, m_config.getVertexCount(), 1u, 0u, 0u );
 		}
+
+		return true;
+	}
+
+	void RenderMeshHolder::doRecordIndirectDraw( RecordContext & context
+		, VkCommandBuffer commandBuffer
+		, VkBuffer indirectBuffer
+		, bool indexed
+		, uint32_t index )const
+	{
+		auto & indirect = m_config.indirectBuffer;
+#if VK_VERSION_1_2
+		auto & count = m_config.indirectCountBuffer;
+
+		if ( auto countBuffer = count.buffer.buffer( index ) )
+		{
+			if ( indexed )
+			{
+				context->vkCmdDrawIndexedIndirectCount( commandBuffer, indirectBuffer, indirect.offset, countBuffer, count.offset, count.maxDrawCount, indirect.stride );
+			}
+			else
+			{
+				context->vkCmdDrawIndirectCount( commandBuffer, indirectBuffer, indirect.offset, countBuffer, count.offset, count.maxDrawCount, indirect.stride );
+			}
+
+			return;
+		}
+#endif
+
+		if ( indexed )
+		{
+			context->vkCmdDrawIndexedIndirect( commandBuffer, indirectBuffer, indirect.offset, 1u, indirect.stride );
+		}
+		else
+		{
+			context->vkCmdDrawIndirect( commandBuffer, indirectBuffer, indirect.offset, 1u, indirect.stride );
+		}
 	}
 
 	void RenderMeshHolder::end( RecordContext & context
@@ -167,25 +220,63 @@ namespace crg
 		return m_renderSize;
 	}
 
-	void RenderMeshHolder::doPreparePipelineStates( VkExtent2D const & renderSize
+	uint32_t RenderMeshHolder::doPreparePipelineStates( VkExtent2D const & renderSize
 		, VkRenderPass renderPass
-		, VkPipelineColorBlendStateCreateInfo blendState )
+		, VkPipelineColorBlendStateCreateInfo blendState
+		, RenderingFormats const & formats
+		, uint32_t subpass )
 	{
-		m_vpState = doCreateViewportState( renderSize, m_viewport, m_scissor );
-		m_renderSize = renderSize;
-		m_renderPass = renderPass;
-		m_blendAttachs = { blendState.pAttachments, blendState.pAttachments + blendState.attachmentCount };
-		m_blendState = std::move( blendState );
-		m_blendState.pAttachments = m_blendAttachs.data();
+		// The pipelines are kept for each encountered states, so switching back to a known render pass
+		// neither recompiles them nor invalidates the pre-recorded command buffers.
+		auto it = std::find_if( m_states.begin()
+			, m_states.end()
+			, [&renderSize, renderPass, &formats, subpass]( std::unique_ptr< PipelineStates > const & lookup )
+			{
+				return lookup->renderSize.width == renderSize.width
+					&& lookup->renderSize.height == renderSize.height
+					&& lookup->renderPass == renderPass
+					&& lookup->subpass == subpass
+					&& lookup->formats == formats;
+			} );
+
+		if ( it != m_states.end() )
+		{
+			return uint32_t( std::distance( m_states.begin(), it ) );
+		}
+
+		// The states are allocated separately, since pending compilations point to them.
+		auto & states = *m_states.emplace_back( std::make_unique< PipelineStates >() );
+		states.vpState = doCreateViewportState( renderSize, states.viewport, states.scissor );
+		states.renderSize = renderSize;
+		states.renderPass = renderPass;
+		states.subpass = subpass;
+		states.blendAttachs = { blendState.pAttachments, blendState.pAttachments + blendState.attachmentCount };
+		states.blendState = std::move( blendState );
+		states.blendState.pAttachments = states.blendAttachs.data();
+		states.formats = formats;
+#if VK_KHR_dynamic_rendering
+		states.renderingInfo = { VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR
+			, nullptr
+			, 0u
+			, uint32_t( states.formats.colour.size() )
+			, states.formats.colour.data()
+			, states.formats.depth
+			, states.formats.stencil };
+#endif
+		return uint32_t( m_states.size() - 1u );
 	}
 
 	void RenderMeshHolder::doCreatePipeline( uint32_t index )
 	{
-		if ( m_pipeline.getPipeline( index ) )
+		m_pipeline.selectPipelineSet( m_passStates[index] );
+
+		if ( m_pipeline.hasPipeline( index ) )
 		{
 			return;
 		}
 
+		auto & states = *m_states[m_passStates[index]];
+
 		auto & program = m_pipeline.getProgram( index );
 		VkGraphicsPipelineCreateInfo createInfo{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO
 			, nullptr
@@ -195,17 +286,23 @@ namespace crg
 			, &m_config.vertexBuffer.inputState
 			, &m_iaState
 			, nullptr
-			, &m_vpState
+			, &states.vpState
 			, &m_rsState
 			, &m_msState
 			, &m_config.depthStencilState
-			, &m_blendState
+			, &states.blendState
 			, nullptr
 			, m_pipeline.getPipelineLayout()
-			, m_renderPass
-			, 0u
+			, states.renderPass
+			, states.subpass
 			, VkPipeline{}
 			, 0u };
+#if VK_KHR_dynamic_rendering
+		if ( !states.renderPass )
+		{
+			createInfo.pNext = &states.renderingInfo;
+		}
+#endif
 		m_pipeline.createPipeline( index, createInfo );
 
 	}
@@ -10,6 +10,8 @@ See LICENSE file in root folder.
 #include "RenderGraph/RunnableGraph.hpp"
 
 #include <array>
+#include <set>
+#include <utility>
 
 namespace crg
 {
@@ -17,6 +19,40 @@ namespace crg
 
 	namespace rpHolder
 	{
+		// The stages and accesses of the attachments, in a subpass.
+		static VkPipelineStageFlags constexpr attachStages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT
+			| VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT
+			| VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		static VkAccessFlags constexpr attachAccesses = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+			| VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		// The stages and accesses of a subpass reading the previous subpasses outputs.
+		static VkPipelineStageFlags constexpr subpassStages = attachStages
+			| VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		static VkAccessFlags constexpr subpassAccesses = attachAccesses
+			| VK_ACCESS_COLOR_ATTACHMENT_READ_BIT
+			| VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT
+			| VK_ACCESS_INPUT_ATTACHMENT_READ_BIT
+			| VK_ACCESS_SHADER_READ_BIT;
+
+		static VkAttachmentLoadOp getLoadOp( VkAttachmentLoadOp loadOp
+			, LayoutState const & initialLayout )
+		{
+			// Nothing was produced before, the previous content is undefined.
+			return ( initialLayout.layout == VK_IMAGE_LAYOUT_UNDEFINED
+					&& loadOp == VK_ATTACHMENT_LOAD_OP_LOAD )
+				? VK_ATTACHMENT_LOAD_OP_CLEAR
+				: loadOp;
+		}
+
+		static VkAttachmentStoreOp getStoreOp( VkAttachmentStoreOp storeOp
+			, bool isConsumed )
+		{
+			// Nothing reads the written content afterwards.
+			return isConsumed
+				? storeOp
+				: VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		}
+
 		static VkAttachmentReference addAttach( RecordContext & context
 			, Attachment const & attach
 			, ImageViewId view
@@ -25,6 +61,7 @@ namespace crg
 			, std::vector< VkClearValue > & clearValues
 			, LayoutState initialLayout
 			, LayoutState finalLayout
+			, bool isConsumed
 			, bool separateDepthStencilLayouts )
 		{
 			VkAttachmentReference result{ uint32_t( attaches.size() )
@@ -32,12 +69,10 @@ namespace crg
 			attaches.push_back( { 0u
 				, view.data->info.format
 				, view.data->image.data->info.samples
-				, ( initialLayout.layout == VK_IMAGE_LAYOUT_UNDEFINED
-					? VK_ATTACHMENT_LOAD_OP_CLEAR
-					: attach.getLoadOp() )
-				, attach.getStoreOp()
-				, attach.getStencilLoadOp()
-				, attach.getStencilStoreOp()
+				, getLoadOp( attach.getLoadOp(), initialLayout )
+				, getStoreOp( attach.getStoreOp(), isConsumed )
+				, getLoadOp( attach.getStencilLoadOp(), initialLayout )
+				, getStoreOp( attach.getStencilStoreOp(), isConsumed )
 				, initialLayout.layout
 				, finalLayout.layout } );
 			viewAttaches.push_back( { view, initialLayout, finalLayout } );
@@ -67,6 +102,7 @@ namespace crg
 			, VkPipelineColorBlendAttachmentStateArray & blendAttachs
 			, LayoutState initialLayout
 			, LayoutState finalLayout
+			, bool isConsumed
 			, bool separateDepthStencilLayouts )
 		{
 			blendAttachs.push_back( attach.getBlendState() );
@@ -78,6 +114,7 @@ namespace crg
 				, clearValues
 				, initialLayout
 				, finalLayout
+				, isConsumed
 				, separateDepthStencilLayouts );
 		}
 
@@ -112,26 +149,15 @@ namespace crg
 
 	//*********************************************************************************************
 
-	void RenderPassHolder::PassData::cleanup( crg::GraphContext & context )noexcept
+	void RenderPassHolder::PassData::cleanup( ContextResourcesCache & resources )noexcept
 	{
 		attaches.clear();
 		clearValues.clear();
-
-		if ( frameBuffer )
-		{
-			crgUnregisterObject( context, frameBuffer );
-			context.vkDestroyFramebuffer( context.device
-				, frameBuffer
-				, context.allocator );
-			frameBuffer = {};
-		}
+		initialised = false;
 
 		if ( renderPass )
 		{
-			crgUnregisterObject( context, renderPass );
-			context.vkDestroyRenderPass( context.device
-				, renderPass
-				, context.allocator );
+			resources.destroyRenderPass( renderPass );
 			renderPass = {};
 		}
 	}
@@ -147,15 +173,33 @@ namespace crg
 		, m_context{ context }
 		, m_graph{ graph }
 		, m_size{ std::move( size ) }
+#if VK_KHR_dynamic_rendering
+		, m_dynamicRendering{ m_context.dynamicRendering
+			&& m_context.vkCmdBeginRenderingKHR
+			&& m_context.vkCmdEndRenderingKHR }
+#endif
 	{
 		m_passes.resize( maxPassCount );
+
+		for ( auto & pass : m_passes )
+		{
+			pass.states.resize( 1u );
+		}
 	}
 
 	RenderPassHolder::~RenderPassHolder()noexcept
 	{
-		for ( auto & data : m_passes )
+		for ( auto & pass : m_passes )
+		{
+			for ( auto & data : pass.states )
+			{
+				data.cleanup( m_graph.getResources() );
+			}
+		}
+
+		for ( auto & data : m_merged.states )
 		{
-			data.cleanup( m_context );
+			data.cleanup( m_graph.getResources() );
 		}
 	}
 
@@ -165,19 +209,54 @@ namespace crg
 	{
 		using rpHolder::operator==;
 
-		auto & data = m_passes[passIndex];
+		if ( m_leader == this )
+		{
+			m_merging = doIsMergeable();
+		}
+
+		if ( m_leader && m_leader->m_merging )
+		{
+			// The first pass creates the merged render pass, the next ones use it.
+			auto renderPass = ( m_leader == this
+				? doInitialiseMerged( context )
+				: m_leader->doGetMergedData().renderPass );
+			return std::exchange( m_mergedRenderPass, renderPass ) != renderPass;
+		}
+
+		auto wasMerged = std::exchange( m_mergedRenderPass, VkRenderPass{} ) != VkRenderPass{};
+		auto & pass = m_passes[passIndex];
 		auto previousState = context.getPrevPipelineState();
 		auto nextState = context.getNextPipelineState();
+		auto isSameState = [&context, &previousState, &nextState, passIndex]( PassData const & lookup )
+			{
+				return lookup.initialised
+					&& rpHolder::checkAttaches( context, lookup.attaches, passIndex )
+					&& lookup.previousState == previousState
+					&& lookup.nextState == nextState;
+			};
+
+		if ( isSameState( pass.states[pass.current] ) )
+		{
+			return wasMerged;
+		}
+
+		// The render passes of the previous states are kept alive, since pre-recorded command buffers may still use them.
+		auto it = std::find_if( pass.states.begin()
+			, pass.states.end()
+			, isSameState );
 
-		if ( data.renderPass
-			&& rpHolder::checkAttaches( context, data.attaches, passIndex )
-			&& data.previousState == previousState
-			&& data.nextState == nextState )
+		if ( it != pass.states.end() )
 		{
-			return false;
+			pass.current = size_t( std::distance( pass.states.begin(), it ) );
+			return true;
+		}
+
+		if ( pass.states[pass.current].initialised )
+		{
+			pass.states.emplace_back();
+			pass.current = pass.states.size() - 1u;
 		}
 
-		data.cleanup( m_context );
 		doCreateRenderPass( context
 			, runnable
 			, previousState
@@ -192,7 +271,7 @@ namespace crg
 		auto frameBuffer = getFramebuffer( index );
 		return VkRenderPassBeginInfo{ VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO
 			, nullptr
-			, getRenderPass( index )
+			, doGetPassData( index ).renderPass
 			, frameBuffer
 			, getRenderArea( index )
 			, uint32_t( getClearValues( index ).size() )
@@ -205,7 +284,22 @@ namespace crg
 		, uint32_t index )
 	{
 		m_index = index;
-		m_currentPass = &m_passes[m_index];
+
+		if ( m_mergedRenderPass )
+		{
+			if ( m_leader == this )
+			{
+				doBeginMerged( context, commandBuffer, subpassContents );
+			}
+			else
+			{
+				m_context.vkCmdNextSubpass( commandBuffer, subpassContents );
+			}
+
+			return;
+		}
+
+		m_currentPass = &doGetPassData( m_index );
 
 		for ( auto & attach : m_currentPass->attaches )
 		{
@@ -213,6 +307,12 @@ namespace crg
 				, attach.input );
 		}
 
+		if ( m_dynamicRendering )
+		{
+			doBeginRendering( context, commandBuffer );
+			return;
+		}
+
 		auto beginInfo = getBeginInfo( m_index );
 		m_context.vkCmdBeginRenderPass( commandBuffer
 			, &beginInfo
@@ -222,7 +322,33 @@ namespace crg
 	void RenderPassHolder::end( RecordContext & context
 			, VkCommandBuffer commandBuffer )
 	{
-		m_context.vkCmdEndRenderPass( commandBuffer );
+		if ( m_mergedRenderPass )
+		{
+			// The merged render pass is ended by its last subpass.
+			if ( m_leader->m_subpasses.back().holder == this )
+			{
+				m_context.vkCmdEndRenderPass( commandBuffer );
+
+				for ( auto & attach : m_leader->doGetMergedData().attaches )
+				{
+					context.setLayoutState( resolveView( attach.view, m_index )
+						, attach.output );
+				}
+
+				m_leader->m_merging = false;
+			}
+
+			return;
+		}
+
+		if ( m_dynamicRendering )
+		{
+			doEndRendering( context, commandBuffer );
+		}
+		else
+		{
+			m_context.vkCmdEndRenderPass( commandBuffer );
+		}
 
 		for ( auto & attach : m_currentPass->attaches )
 		{
@@ -242,7 +368,7 @@ namespace crg
 		VkAttachmentDescriptionArray attaches;
 		VkAttachmentReferenceArray colorReferences;
 		VkAttachmentReference depthReference{};
-		auto & data = m_passes[passIndex];
+		auto & data = doGetPassData( passIndex );
 		m_blendAttachs.clear();
 
 		for ( auto & attach : m_pass.images )
@@ -255,6 +381,7 @@ namespace crg
 				auto resolved = resolveView( view, passIndex );
 				auto currentLayout = m_graph.getCurrentLayoutState( context, resolved );
 				auto nextLayout = m_graph.getNextLayoutState( context, runnable, resolved );
+				auto isConsumed = m_graph.isOutputConsumed( m_pass, view );
 				auto from = ( !attach.isInput()
 					? crg::makeLayoutState( VK_IMAGE_LAYOUT_UNDEFINED )
 					: currentLayout );
@@ -262,6 +389,16 @@ namespace crg
 
 				if ( attach.isDepthAttach() || attach.isStencilAttach() )
 				{
+					if ( attach.isDepthAttach() )
+					{
+						data.formats.depth = view.data->info.format;
+					}
+
+					if ( attach.isStencilAttach() )
+					{
+						data.formats.stencil = view.data->info.format;
+					}
+
 					depthReference = rpHolder::addAttach( context
 						, attach
 						, view
@@ -270,10 +407,12 @@ namespace crg
 						, data.clearValues
 						, from
 						, nextLayout
+						, isConsumed
 						, m_context.separateDepthStencilLayouts );
 				}
 				else if ( attach.isColourAttach() )
 				{
+					data.formats.colour.push_back( view.data->info.format );
 					colorReferences.push_back( rpHolder::addAttach( context
 						, attach
 						, view
@@ -283,11 +422,34 @@ namespace crg
 						, m_blendAttachs
 						, from
 						, nextLayout
+						, isConsumed
 						, m_context.separateDepthStencilLayouts ) );
 				}
 			}
 		}
 
+		data.previousState = previousState;
+		data.nextState = nextState;
+
+		if ( m_dynamicRendering )
+		{
+			data.layouts.resize( attaches.size() );
+
+			for ( auto & reference : colorReferences )
+			{
+				data.layouts[reference.attachment] = reference.layout;
+			}
+
+			if ( depthReference.layout )
+			{
+				data.layouts[depthReference.attachment] = depthReference.layout;
+			}
+
+			data.descriptions = std::move( attaches );
+			data.initialised = true;
+			return;
+		}
+
 		VkSubpassDescription subpassDesc{ 0u
 			, VK_PIPELINE_BIND_POINT_GRAPHICS
 			, 0u
@@ -298,8 +460,6 @@ namespace crg
 			, depthReference.layout ? &depthReference : nullptr
 			, 0u
 			, nullptr };
-		data.previousState = previousState;
-		data.nextState = nextState;
 		VkSubpassDependencyArray dependencies{
 			{ VK_SUBPASS_EXTERNAL
 				, 0u
@@ -324,12 +484,9 @@ namespace crg
 			, &subpassDesc
 			, uint32_t( dependencies.size() )
 			, dependencies.data() };
-		auto res = m_context.vkCreateRenderPass( m_context.device
-			, &createInfo
-			, m_context.allocator
-			, &data.renderPass );
-		checkVkResult( res, m_pass.getGroupName() + " - RenderPass creation" );
-		crgRegisterObject( m_context, m_pass.getGroupName() + std::to_string( m_count++ ), data.renderPass );
+		data.renderPass = m_graph.getResources().createRenderPass( m_pass.getGroupName() + std::to_string( m_count++ )
+			, createInfo );
+		data.initialised = true;
 	}
 
 	VkPipelineColorBlendStateCreateInfo RenderPassHolder::createBlendState()
@@ -346,14 +503,44 @@ namespace crg
 
 	VkFramebuffer RenderPassHolder::getFramebuffer( uint32_t index )const
 	{
-		return doCreateFramebuffer( index );
+		return doGetFramebuffer( doGetPassData( index ), index );
+	}
+
+	void RenderPassHolder::mergeSubpasses( std::vector< Subpass > subpasses )
+	{
+		for ( uint32_t subpass = 0u; subpass < subpasses.size(); ++subpass )
+		{
+			subpasses[subpass].holder->m_leader = this;
+			subpasses[subpass].holder->m_subpass = subpass;
+		}
+
+		m_subpasses = std::move( subpasses );
+		m_merged.states.resize( 1u );
+	}
+
+	VkFramebuffer RenderPassHolder::doGetFramebuffer( PassData const & data
+		, uint32_t index )const
+	{
+		VkImageViewArray attachments;
+
+		for ( auto & attach : data.attachments )
+		{
+			attachments.push_back( m_graph.createImageView( attach->view( index ) ) );
+		}
+
+		return m_graph.getResources().createFramebuffer( m_pass.getGroupName() + std::string( "[" ) + std::to_string( index ) + std::string( "]" )
+			, data.renderPass
+			, attachments
+			, data.renderArea.extent
+			, m_layers );
 	}
 
 	void RenderPassHolder::doInitialiseRenderArea( uint32_t index )
 	{
 		uint32_t width{ m_size.width };
 		uint32_t height{ m_size.height };
-		m_passes[index].attachments.clear();
+		auto & data = doGetPassData( index );
+		data.attachments.clear();
 		m_layers = 1u;
 
 		for ( auto & attach : m_pass.images )
@@ -363,7 +550,7 @@ namespace crg
 				|| attach.isStencilAttach() )
 			{
 				auto view = attach.view();
-				m_passes[index].attachments.push_back( &attach );
+				data.attachments.push_back( &attach );
 				width = std::max( width
 					, view.data->image.data->info.extent.width >> view.data->info.subresourceRange.baseMipLevel );
 				height = std::max( height
@@ -373,42 +560,377 @@ namespace crg
 			}
 		}
 
-		m_passes[index].renderArea.extent.width = width;
-		m_passes[index].renderArea.extent.height = height;
+		data.renderArea.extent.width = width;
+		data.renderArea.extent.height = height;
+	}
+
+	bool RenderPassHolder::doIsMergeable()const
+	{
+		// Passes re-recorded on their own are not merged.
+		return m_graph.isRecording()
+			&& std::all_of( m_subpasses.begin()
+				, m_subpasses.end()
+				, []( Subpass const & lookup )
+				{
+					return lookup.runnable->isEnabled();
+				} );
+	}
+
+	VkRenderPass RenderPassHolder::doInitialiseMerged( RecordContext & context )
+	{
+		using rpHolder::operator==;
+
+		auto previousState = context.getPrevPipelineState();
+		auto nextState = m_graph.getNextPipelineState( *m_subpasses.back().runnable );
+		auto isSameState = [&context, &previousState, &nextState]( PassData const & lookup )
+			{
+				return lookup.initialised
+					&& rpHolder::checkAttaches( context, lookup.attaches, 0u )
+					&& lookup.previousState == previousState
+					&& lookup.nextState == nextState;
+			};
+
+		if ( auto it = std::find_if( m_merged.states.begin()
+				, m_merged.states.end()
+				, isSameState );
+			it != m_merged.states.end() )
+		{
+			m_merged.current = size_t( std::distance( m_merged.states.begin(), it ) );
+		}
+		else
+		{
+			if ( m_merged.states[m_merged.current].initialised )
+			{
+				m_merged.states.emplace_back();
+				m_merged.current = m_merged.states.size() - 1u;
+			}
+
+			doCreateMergedRenderPass( context
+				, previousState
+				, nextState );
+		}
+
+		return doGetMergedData().renderPass;
+	}
+
+	void RenderPassHolder::doCreateMergedRenderPass( RecordContext & context
+		, PipelineState const & previousState
+		, PipelineState const & nextState )
+	{
+		struct MergedAttach
+		{
+			Attachment const * first;
+			Attachment const * lastWriter;
+			std::set< uint32_t > users;
+		};
+		struct SubpassReferences
+		{
+			VkAttachmentReferenceArray colour;
+			VkAttachmentReference depth{};
+			VkAttachmentReferenceArray input;
+			std::vector< uint32_t > preserve;
+			std::set< uint32_t > sources;
+		};
+		auto & data = m_merged.states[m_merged.current];
+		std::vector< MergedAttach > merged;
+		std::vector< SubpassReferences > subpasses( m_subpasses.size() );
+
+		for ( uint32_t subpass = 0u; subpass < m_subpasses.size(); ++subpass )
+		{
+			auto & holder = *m_subpasses[subpass].holder;
+			auto & references = subpasses[subpass];
+			holder.m_blendAttachs.clear();
+
+			for ( auto & attach : holder.m_pass.images )
+			{
+				auto isTarget = attach.isColourAttach()
+					|| attach.isDepthAttach()
+					|| attach.isStencilAttach();
+				auto view = attach.view();
+				auto it = std::find_if( merged.begin()
+					, merged.end()
+					, [&view]( MergedAttach const & lookup )
+					{
+						return lookup.first->view() == view;
+					} );
+
+				// A view read at the same pixel is an input attachment only if it is rendered to in this render pass.
+				if ( !isTarget
+					&& ( !attach.isSamePixelView() || it == merged.end() ) )
+				{
+					continue;
+				}
+
+				if ( it == merged.end() )
+				{
+					it = merged.insert( merged.end(), MergedAttach{ &attach, nullptr, {} } );
+				}
+
+				// The subpass depends on the previous ones accessing the same attachments.
+				references.sources.insert( it->users.begin(), it->users.end() );
+				it->users.insert( subpass );
+
+				if ( attach.isOutput() )
+				{
+					it->lastWriter = &attach;
+				}
+
+				VkAttachmentReference reference{ uint32_t( std::distance( merged.begin(), it ) )
+					, attach.getImageLayout( m_context.separateDepthStencilLayouts ) };
+
+				if ( attach.isColourAttach() )
+				{
+					references.colour.push_back( reference );
+					holder.m_blendAttachs.push_back( attach.getBlendState() );
+				}
+				else if ( isTarget )
+				{
+					references.depth = reference;
+				}
+				else
+				{
+					references.input.push_back( reference );
+				}
+			}
+		}
+
+		VkAttachmentDescriptionArray attaches;
+		uint32_t width{ m_size.width };
+		uint32_t height{ m_size.height };
+		m_layers = 1u;
+
+		for ( uint32_t index = 0u; index < merged.size(); ++index )
+		{
+			auto & attach = merged[index];
+			auto & first = *attach.first;
+			auto & last = ( attach.lastWriter ? *attach.lastWriter : first );
+			auto view = first.view();
+			auto resolved = resolveView( view, 0u );
+			auto from = ( !first.isInput()
+				? crg::makeLayoutState( VK_IMAGE_LAYOUT_UNDEFINED )
+				: m_graph.getCurrentLayoutState( context, resolved ) );
+			checkUndefinedInput( "RenderPass", first, resolved, from.layout );
+			auto to = m_graph.getNextLayoutState( *m_subpasses[*attach.users.rbegin()].runnable, resolved );
+			auto isConsumed = ( !attach.lastWriter
+				|| m_graph.isMergedOutputConsumed( *last.pass, view ) );
+			attaches.push_back( { 0u
+				, view.data->info.format
+				, view.data->image.data->info.samples
+				, rpHolder::getLoadOp( first.getLoadOp(), from )
+				, rpHolder::getStoreOp( last.getStoreOp(), isConsumed )
+				, rpHolder::getLoadOp( first.getStencilLoadOp(), from )
+				, rpHolder::getStoreOp( last.getStencilStoreOp(), isConsumed )
+				, from.layout
+				, to.layout } );
+			data.attaches.push_back( { view, from, to } );
+			data.clearValues.push_back( first.getClearValue() );
+			data.attachments.push_back( &first );
+			width = std::max( width
+				, view.data->image.data->info.extent.width >> view.data->info.subresourceRange.baseMipLevel );
+			height = std::max( height
+				, view.data->image.data->info.extent.height >> view.data->info.subresourceRange.baseMipLevel );
+			m_layers = std::max( m_layers
+				, view.data->info.subresourceRange.layerCount );
+
+			// The subpasses in between the ones using the attachment must keep its content.
+			for ( auto subpass = *attach.users.begin() + 1u; subpass < *attach.users.rbegin(); ++subpass )
+			{
+				if ( attach.users.end() == attach.users.find( subpass ) )
+				{
+					subpasses[subpass].preserve.push_back( index );
+				}
+			}
+		}
+
+		VkSubpassDescriptionArray descriptions;
+		VkSubpassDependencyArray dependencies;
+
+		for ( uint32_t subpass = 0u; subpass < subpasses.size(); ++subpass )
+		{
+			auto & references = subpasses[subpass];
+			descriptions.push_back( { 0u
+				, VK_PIPELINE_BIND_POINT_GRAPHICS
+				, uint32_t( references.input.size() )
+				, references.input.data()
+				, uint32_t( references.colour.size() )
+				, references.colour.data()
+				, nullptr
+				, references.depth.layout ? &references.depth : nullptr
+				, uint32_t( references.preserve.size() )
+				, references.preserve.data() } );
+			dependencies.push_back( { VK_SUBPASS_EXTERNAL
+				, subpass
+				, previousState.pipelineStage
+				, rpHolder::subpassStages
+				, previousState.access
+				, rpHolder::subpassAccesses
+				, VK_DEPENDENCY_BY_REGION_BIT } );
+
+			for ( auto source : references.sources )
+			{
+				dependencies.push_back( { source
+					, subpass
+					, rpHolder::attachStages
+					, rpHolder::subpassStages
+					, rpHolder::attachAccesses
+					, rpHolder::subpassAccesses
+					, VK_DEPENDENCY_BY_REGION_BIT } );
+			}
+
+			dependencies.push_back( { subpass
+				, VK_SUBPASS_EXTERNAL
+				, rpHolder::attachStages
+				, nextState.pipelineStage
+				, rpHolder::attachAccesses
+				, nextState.access
+				, VK_DEPENDENCY_BY_REGION_BIT } );
+		}
+
+		VkRenderPassCreateInfo createInfo{ VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO
+			, nullptr
+			, 0u
+			, uint32_t( attaches.size() )
+			, attaches.data()
+			, uint32_t( descriptions.size() )
+			, descriptions.data()
+			, uint32_t( dependencies.size() )
+			, dependencies.data() };
+		data.renderPass = m_graph.getResources().createRenderPass( m_pass.getGroupName() + "/Subpasses" + std::to_string( m_count++ )
+			, createInfo );
+		data.renderArea.extent.width = width;
+		data.renderArea.extent.height = height;
+		data.previousState = previousState;
+		data.nextState = nextState;
+		data.initialised = true;
 	}
 
-	VkFramebuffer RenderPassHolder::doCreateFramebuffer( uint32_t passIndex )const
+	void RenderPassHolder::doBeginMerged( RecordContext & context
+		, VkCommandBuffer commandBuffer
+		, VkSubpassContents subpassContents )
 	{
-		auto & data = m_passes[passIndex];
-		auto frameBuffer = &data.frameBuffer;
+		auto & data = doGetMergedData();
+		std::set< ImageViewId > views;
+
+		for ( auto & attach : data.attaches )
+		{
+			views.insert( attach.view );
+		}
+
+		// The next passes can't record their barriers once the render pass is begun.
+		for ( auto it = std::next( m_subpasses.begin() ); it != m_subpasses.end(); ++it )
+		{
+			it->runnable->prepareSubpass( context, commandBuffer, views );
+		}
 
-		if ( !*frameBuffer )
+		for ( auto & attach : data.attaches )
 		{
-			VkImageViewArray attachments;
+			context.setLayoutState( resolveView( attach.view, m_index )
+				, attach.input );
+		}
+
+		VkRenderPassBeginInfo beginInfo{ VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO
+			, nullptr
+			, data.renderPass
+			, doGetFramebuffer( data, m_index )
+			, data.renderArea
+			, uint32_t( data.clearValues.size() )
+			, data.clearValues.data() };
+		m_context.vkCmdBeginRenderPass( commandBuffer
+			, &beginInfo
+			, subpassContents );
 
-			for ( auto & attach : data.attachments )
+		// Within the render pass, the views read at the same pixel are in the layout their readers expect.
+		for ( auto & subpass : m_subpasses )
+		{
+			for ( auto & attach : subpass.holder->m_pass.images )
 			{
-				attachments.push_back( m_graph.createImageView( attach->view( passIndex ) ) );
+				if ( attach.isSamePixelView()
+					&& views.end() != views.find( attach.view() ) )
+				{
+					context.setLayoutState( resolveView( attach.view(), m_index )
+						, makeLayoutState( attach.getImageLayout( m_context.separateDepthStencilLayouts ) ) );
+				}
 			}
+		}
+	}
 
-			VkFramebufferCreateInfo createInfo{ VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO
+	void RenderPassHolder::doBeginRendering( RecordContext & context
+		, VkCommandBuffer commandBuffer )
+	{
+#if VK_KHR_dynamic_rendering
+		auto & data = *m_currentPass;
+		std::vector< VkRenderingAttachmentInfoKHR > colourAttaches;
+		VkRenderingAttachmentInfoKHR depthAttach{};
+		VkRenderingAttachmentInfoKHR stencilAttach{};
+
+		for ( size_t i = 0u; i < data.attaches.size(); ++i )
+		{
+			auto & entry = data.attaches[i];
+			auto & description = data.descriptions[i];
+			auto & attach = *data.attachments[i];
+			auto layout = data.layouts[i];
+			// No render pass to do the layout transitions, they are done explicitly.
+			context.memoryBarrier( commandBuffer
+				, resolveView( entry.view, m_index )
+				, description.initialLayout
+				, makeLayoutState( layout ) );
+			VkRenderingAttachmentInfoKHR attachInfo{ VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR
 				, nullptr
-				, 0u
-				, data.renderPass
-				, uint32_t( attachments.size() )
-				, attachments.data()
-				, data.renderArea.extent.width
-				, data.renderArea.extent.height
-				, m_layers };
-			auto res = m_context.vkCreateFramebuffer( m_context.device
-				, &createInfo
-				, m_context.allocator
-				, frameBuffer );
-			auto name = m_pass.getGroupName() + std::string( "[" ) + std::to_string( passIndex ) + std::string( "]" );
-			checkVkResult( res, name + " - Framebuffer creation" );
-			crgRegisterObject( m_context, name, *frameBuffer );
-		}
-
-		return *frameBuffer;
+				, m_graph.createImageView( entry.view )
+				, layout
+				, VK_RESOLVE_MODE_NONE
+				, VkImageView{}
+				, VK_IMAGE_LAYOUT_UNDEFINED
+				, description.loadOp
+				, description.storeOp
+				, data.clearValues[i] };
+
+			if ( attach.isColourAttach() )
+			{
+				colourAttaches.push_back( attachInfo );
+			}
+			else
+			{
+				if ( attach.isDepthAttach() )
+				{
+					depthAttach = attachInfo;
+				}
+
+				if ( attach.isStencilAttach() )
+				{
+					stencilAttach = attachInfo;
+					stencilAttach.loadOp = description.stencilLoadOp;
+					stencilAttach.storeOp = description.stencilStoreOp;
+				}
+			}
+		}
+
+		VkRenderingInfoKHR renderingInfo{ VK_STRUCTURE_TYPE_RENDERING_INFO_KHR
+			, nullptr
+			, 0u
+			, data.renderArea
+			, m_layers
+			, 0u
+			, uint32_t( colourAttaches.size() )
+			, colourAttaches.data()
+			, ( depthAttach.imageView ? &depthAttach : nullptr )
+			, ( stencilAttach.imageView ? &stencilAttach : nullptr ) };
+		m_context.vkCmdBeginRenderingKHR( commandBuffer, &renderingInfo );
+#endif
+	}
+
+	void RenderPassHolder::doEndRendering( RecordContext & context
+		, VkCommandBuffer commandBuffer )
+	{
+#if VK_KHR_dynamic_rendering
+		m_context.vkCmdEndRenderingKHR( commandBuffer );
+
+		for ( auto & attach : m_currentPass->attaches )
+		{
+			context.memoryBarrier( commandBuffer
+				, resolveView( attach.view, m_index )
+				, attach.output );
+		}
+#endif
 	}
 }
@@ -35,6 +35,11 @@ namespace crg
 			, ruConfig.maxPassCount
 			, rqConfig.m_renderSize ? *rqConfig.m_renderSize : getDefaultV< VkExtent2D >() }
 	{
+		// The end callback records commands after the render pass, this can't be done for a subpass.
+		if ( !m_renderQuad.hasEnd() )
+		{
+			graph.registerSubpass( *this, m_renderPass );
+		}
 	}
 
 	void RenderQuad::resetPipeline( VkPipelineShaderStageCreateInfoArray config
@@ -54,12 +59,18 @@ namespace crg
 			m_renderQuad.initialise( m_renderPass.getRenderSize()
 				, m_renderPass.getRenderPass( index )
 				, m_renderPass.createBlendState()
-				, index );
+				, index
+				, m_renderPass.getRenderingFormats( index )
+				, m_renderPass.getSubpass() );
 		}
 
 		m_renderPass.begin( context, commandBuffer, VK_SUBPASS_CONTENTS_INLINE, index );
-		m_renderQuad.record( context, commandBuffer, index );
+		auto recorded = m_renderQuad.record( context, commandBuffer, index );
 		m_renderPass.end( context, commandBuffer );
-		m_renderQuad.end( context, commandBuffer, index );
+
+		if ( recorded )
+		{
+			m_renderQuad.end( context, commandBuffer, index );
+		}
 	}
 }
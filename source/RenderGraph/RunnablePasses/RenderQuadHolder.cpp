@@ -6,6 +6,8 @@ See LICENSE file in root folder.
 
 #include "RenderGraph/GraphContext.hpp"
 
+#include <cassert>
+
 namespace crg
 {
 	//*********************************************************************************************
@@ -33,6 +35,8 @@ namespace crg
 			, VK_PIPELINE_BIND_POINT_GRAPHICS
 			, maxPassCount }
 		, m_useTexCoord{ config.m_texcoordConfig }
+		, m_hasEnd{ config.m_end }
+		, m_passStates( maxPassCount, 0u )
 	{
 		m_iaState = { VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO
 			, nullptr
@@ -66,30 +70,29 @@ namespace crg
 	void RenderQuadHolder::initialise( VkExtent2D const & renderSize
 		, VkRenderPass renderPass
 		, VkPipelineColorBlendStateCreateInfo blendState
-		, uint32_t index )
+		, uint32_t index
+		, RenderingFormats const & formats
+		, uint32_t subpass )
 	{
 		if ( !m_vertexBuffer )
 		{
 			m_pipeline.initialise();
 			m_vertexBuffer = &m_graph.createQuadTriVertexBuffer( m_useTexCoord
 				, m_config.texcoordConfig );
-			doPreparePipelineStates( renderSize, renderPass, std::move( blendState ) );
-		}
-		else if ( m_renderPass != renderPass )
-		{
-			resetRenderPass( renderSize, renderPass, std::move( blendState ), index );
 		}
 
-		doCreatePipeline( index );
+		resetRenderPass( renderSize, renderPass, std::move( blendState ), index, formats, subpass );
 	}
 
 	void RenderQuadHolder::resetRenderPass( VkExtent2D const & renderSize
 		, VkRenderPass renderPass
 		, VkPipelineColorBlendStateCreateInfo blendState
-		, uint32_t index )
+		, uint32_t index
+		, RenderingFormats const & formats
+		, uint32_t subpass )
 	{
-		m_pipeline.resetPipeline( {}, index );
-		doPreparePipelineStates( renderSize, renderPass, std::move( blendState ) );
+		assert( m_passStates.size() > index );
+		m_passStates[index] = doPreparePipelineStates( renderSize, renderPass, std::move( blendState ), formats, subpass );
 		doCreatePipeline( index );
 	}
 
@@ -98,18 +101,23 @@ namespace crg
 	{
 		m_pipeline.resetPipeline( std::move( config ), index );
 
-		if ( m_renderPass )
+		if ( isInitialised() )
 		{
 			doCreatePipeline( index );
 		}
 	}
 
-	void RenderQuadHolder::record( RecordContext & context
+	bool RenderQuadHolder::record( RecordContext & context
 		, VkCommandBuffer commandBuffer
 		, uint32_t index )
 	{
 		doCreatePipeline( index );
-		m_pipeline.recordInto( context, commandBuffer, index );
+
+		if ( !m_pipeline.recordInto( context, commandBuffer, index ) )
+		{
+			return false;
+		}
+
 		m_config.recordInto( context, commandBuffer, index );
 		VkDeviceSize offset{};
 
@@ -127,6 +135,8 @@ namespace crg
 		{
 			context->vkCmdDraw( commandBuffer, 3u, m_config.m_instances, 0u, 0u );
 		}
+
+		return true;
 	}
 
 	void RenderQuadHolder::end( RecordContext & context
@@ -150,25 +160,63 @@ namespace crg
 			: ( m_config.enabled ? *m_config.enabled : true ) );
 	}
 
-	void RenderQuadHolder::doPreparePipelineStates( VkExtent2D const & renderSize
+	uint32_t RenderQuadHolder::doPreparePipelineStates( VkExtent2D const & renderSize
 		, VkRenderPass renderPass
-		, VkPipelineColorBlendStateCreateInfo blendState )
+		, VkPipelineColorBlendStateCreateInfo blendState
+		, RenderingFormats const & formats
+		, uint32_t subpass )
 	{
-		m_vpState = doCreateViewportState( renderSize, m_viewport, m_scissor );
-		m_renderSize = renderSize;
-		m_renderPass = renderPass;
-		m_blendAttachs = { blendState.pAttachments, blendState.pAttachments + blendState.attachmentCount };
-		m_blendState = std::move( blendState );
-		m_blendState.pAttachments = m_blendAttachs.data();
+		// The pipelines are kept for each encountered states, so switching back to a known render pass
+		// neither recompiles them nor invalidates the pre-recorded command buffers.
+		auto it = std::find_if( m_states.begin()
+			, m_states.end()
+			, [&renderSize, renderPass, &formats, subpass]( std::unique_ptr< PipelineStates > const & lookup )
+			{
+				return lookup->renderSize.width == renderSize.width
+					&& lookup->renderSize.height == renderSize.height
+					&& lookup->renderPass == renderPass
+					&& lookup->subpass == subpass
+					&& lookup->formats == formats;
+			} );
+
+		if ( it != m_states.end() )
+		{
+			return uint32_t( std::distance( m_states.begin(), it ) );
+		}
+
+		// The states are allocated separately, since pending compilations point to them.
+		auto & states = *m_states.emplace_back( std::make_unique< PipelineStates >() );
+		states.vpState = doCreateViewportState( renderSize, states.viewport, states.scissor );
+		states.renderSize = renderSize;
+		states.renderPass = renderPass;
+		states.subpass = subpass;
+		states.blendAttachs = { blendState.pAttachments, blendState.pAttachments + blendState.attachmentCount };
+		states.blendState = std::move( blendState );
+		states.blendState.pAttachments = states.blendAttachs.data();
+		states.formats = formats;
+#if VK_KHR_dynamic_rendering
+		states.renderingInfo = { VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR
+			, nullptr
+			, 0u
+			, uint32_t( states.formats.colour.size() )
+			, states.formats.colour.data()
+			, states.formats.depth
+			, states.formats.stencil };
+#endif
+		return uint32_t( m_states.size() - 1u );
 	}
 
 	void RenderQuadHolder::doCreatePipeline( uint32_t index )
 	{
-		if ( m_pipeline.getPipeline( index ) )
+		m_pipeline.selectPipelineSet( m_passStates[index] );
+
+		if ( m_pipeline.hasPipeline( index ) )
 		{
 			return;
 		}
 
+		auto & states = *m_states[m_passStates[index]];
+
 		auto & program = m_pipeline.getProgram( index );
 		VkGraphicsPipelineCreateInfo createInfo{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO
 			, nullptr
@@ -178,17 +226,23 @@ namespace crg
 			, &getInputState()
 			, &m_iaState
 			, nullptr
-			, &m_vpState
+			, &states.vpState
 			, &m_rsState
 			, &m_msState
 			, &m_config.depthStencilState
-			, &m_blendState
+			, &states.blendState
 			, nullptr
 			, m_pipeline.getPipelineLayout()
-			, m_renderPass
-			, 0u
+			, states.renderPass
+			, states.subpass
 			, VkPipeline{}
 			, 0u };
+#if VK_KHR_dynamic_rendering
+		if ( !states.renderPass )
+		{
+			createInfo.pNext = &states.renderingInfo;
+		}
+#endif
 		m_pipeline.createPipeline( index, createInfo );
 	}
 
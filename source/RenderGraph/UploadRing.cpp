@@ -0,0 +1,143 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#include "RenderGraph/UploadRing.hpp"
+#include "HostVisibleBuffer.hpp"
+
+#include "RenderGraph/GraphContext.hpp"
+#include "RenderGraph/RunnablePass.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace crg
+{
+	namespace upring
+	{
+		static VkDeviceSize alignUp( VkDeviceSize value
+			, VkDeviceSize alignment )
+		{
+			return alignment > 1u
+				? ( ( value + alignment - 1u ) / alignment ) * alignment
+				: value;
+		}
+	}
+
+	UploadRing::UploadRing( GraphContext & context
+		, std::string name
+		, VkDeviceSize frameSize
+		, uint32_t frameCount )
+		: m_context{ context }
+		, m_name{ std::move( name ) }
+		, m_frameSize{ frameSize }
+		, m_buffer{ VkBuffer{}, m_name }
+		, m_segments( std::max( 1u, frameCount ) )
+	{
+		createHostVisibleBuffer( m_context
+			, m_name
+			, m_frameSize * m_segments.size()
+			, VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+			, 0u
+			, m_buffer.buffer()
+			, m_memory
+			, m_data );
+	}
+
+	UploadRing::~UploadRing()noexcept
+	{
+		destroyHostVisibleBuffer( m_context
+			, m_buffer.buffer()
+			, m_memory
+			, m_data );
+	}
+
+	bool UploadRing::upload( FramePass const & pass
+		, void const * data
+		, VkDeviceSize size
+		, VkDeviceSize alignment )
+	{
+		auto & segment = m_segments[m_current];
+
+		if ( segment.closed )
+		{
+			doReclaim( segment );
+		}
+
+		auto offset = upring::alignUp( segment.head, alignment );
+
+		if ( !m_data || offset + size > m_frameSize )
+		{
+			return false;
+		}
+
+		offset += m_current * m_frameSize;
+		std::memcpy( m_data + offset, data, size_t( size ) );
+		segment.head = offset + size - m_current * m_frameSize;
+		m_pending[&pass] = { offset, size };
+		m_dirty = true;
+		return true;
+	}
+
+	bool UploadRing::takeUpload( FramePass const & pass
+		, Fence & fence
+		, Upload & result )
+	{
+		auto it = m_pending.find( &pass );
+
+		if ( it == m_pending.end() )
+		{
+			return false;
+		}
+
+		result = it->second;
+		m_pending.erase( it );
+
+		// The segment can be read by several graphs, each one using its own fence.
+		auto & fences = m_segments[result.offset / m_frameSize].fences;
+
+		if ( fences.end() == std::find( fences.begin(), fences.end(), &fence ) )
+		{
+			fences.push_back( &fence );
+		}
+
+		if ( m_dirty )
+		{
+			// The remaining uploads of this segment are taken while recording the same frame,
+			// the next host writes go to the next segment.
+			m_segments[m_current].closed = true;
+			m_current = uint32_t( ( m_current + 1u ) % m_segments.size() );
+			m_dirty = false;
+		}
+
+		return true;
+	}
+
+	void UploadRing::doReclaim( Segment & segment )
+	{
+		for ( auto fence : segment.fences )
+		{
+			fence->wait( 0xFFFFFFFFFFFFFFFFULL );
+		}
+
+		segment.fences.clear();
+
+		auto index = uint32_t( std::distance( m_segments.data(), &segment ) );
+
+		for ( auto it = m_pending.begin(); it != m_pending.end(); )
+		{
+			if ( it->second.offset / m_frameSize == index )
+			{
+				it = m_pending.erase( it );
+			}
+			else
+			{
+				++it;
+			}
+		}
+
+		segment.head = 0u;
+		segment.closed = false;
+	}
+}
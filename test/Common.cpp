@@ -9,6 +9,7 @@
 #include <RenderGraph/FrameGraph.hpp>
 #include <RenderGraph/RunnableGraph.hpp>
 
+#include <array>
 #include <atomic>
 #include <functional>
 #include <map>
@@ -398,6 +399,30 @@ namespace test
 				}
 				return VK_SUCCESS;
 			} );
+		context.vkCreatePipelineCache = PFN_vkCreatePipelineCache( []( VkDevice, const VkPipelineCacheCreateInfo *, const VkAllocationCallbacks *, VkPipelineCache * pPipelineCache )
+			{
+				*pPipelineCache = VkPipelineCache( counter.load() );
+				++counter;
+				return VK_SUCCESS;
+			} );
+		context.vkGetPipelineCacheData = PFN_vkGetPipelineCacheData( []( VkDevice, VkPipelineCache, size_t * pDataSize, void * pData )
+			{
+				static uint32_t constexpr HeaderSize = 16u + VK_UUID_SIZE;
+
+				if ( pData )
+				{
+					std::array< uint32_t, 4u > header{ HeaderSize
+						, uint32_t( VK_PIPELINE_CACHE_HEADER_VERSION_ONE )
+						, Properties.vendorID
+						, Properties.deviceID };
+					auto dst = static_cast< uint8_t * >( pData );
+					std::memcpy( dst, header.data(), sizeof( header ) );
+					std::memcpy( dst + sizeof( header ), Properties.pipelineCacheUUID, VK_UUID_SIZE );
+				}
+
+				*pDataSize = HeaderSize;
+				return VK_SUCCESS;
+			} );
 		context.vkCreatePipelineLayout = PFN_vkCreatePipelineLayout( []( VkDevice, const VkPipelineLayoutCreateInfo *, const VkAllocationCallbacks *, VkPipelineLayout * pPipelineLayout )
 			{
 				*pPipelineLayout = VkPipelineLayout( counter.load() );
@@ -514,6 +539,7 @@ namespace test
 			} );
 
 		context.vkDestroyPipeline = PFN_vkDestroyPipeline( []( VkDevice, VkPipeline, const VkAllocationCallbacks * ){} );
+		context.vkDestroyPipelineCache = PFN_vkDestroyPipelineCache( []( VkDevice, VkPipelineCache, const VkAllocationCallbacks * ){} );
 		context.vkDestroyPipelineLayout = PFN_vkDestroyPipelineLayout( []( VkDevice, VkPipelineLayout, const VkAllocationCallbacks * ){} );
 		context.vkDestroyDescriptorSetLayout = PFN_vkDestroyDescriptorSetLayout( []( VkDevice, VkDescriptorSetLayout, const VkAllocationCallbacks* ){} );
 		context.vkDestroyDescriptorPool = PFN_vkDestroyDescriptorPool( []( VkDevice, VkDescriptorPool, const VkAllocationCallbacks * ){} );
@@ -580,8 +606,17 @@ namespace test
 		context.vkCmdDrawIndexed = PFN_vkCmdDrawIndexed( []( VkCommandBuffer, uint32_t, uint32_t, uint32_t, int32_t, uint32_t ){} );
 		context.vkCmdDrawIndexedIndirect = PFN_vkCmdDrawIndexedIndirect( []( VkCommandBuffer, VkBuffer, VkDeviceSize, uint32_t, uint32_t ){} );
 		context.vkCmdDrawIndirect = PFN_vkCmdDrawIndirect( []( VkCommandBuffer, VkBuffer, VkDeviceSize, uint32_t, uint32_t ){} );
+#if VK_VERSION_1_2
+		context.vkCmdDrawIndexedIndirectCount = PFN_vkCmdDrawIndexedIndirectCount( []( VkCommandBuffer, VkBuffer, VkDeviceSize, VkBuffer, VkDeviceSize, uint32_t, uint32_t ){} );
+		context.vkCmdDrawIndirectCount = PFN_vkCmdDrawIndirectCount( []( VkCommandBuffer, VkBuffer, VkDeviceSize, VkBuffer, VkDeviceSize, uint32_t, uint32_t ){} );
+#endif
 		context.vkCmdBeginRenderPass = PFN_vkCmdBeginRenderPass( []( VkCommandBuffer, const VkRenderPassBeginInfo *, VkSubpassContents ){} );
 		context.vkCmdEndRenderPass = PFN_vkCmdEndRenderPass( []( VkCommandBuffer ){} );
+		context.vkCmdNextSubpass = PFN_vkCmdNextSubpass( []( VkCommandBuffer, VkSubpassContents ){} );
+#if VK_KHR_dynamic_rendering
+		context.vkCmdBeginRenderingKHR = PFN_vkCmdBeginRenderingKHR( []( VkCommandBuffer, const VkRenderingInfoKHR * ){} );
+		context.vkCmdEndRenderingKHR = PFN_vkCmdEndRenderingKHR( []( VkCommandBuffer ){} );
+#endif
 		context.vkCmdPushConstants = PFN_vkCmdPushConstants( []( VkCommandBuffer, VkPipelineLayout, VkShaderStageFlags, uint32_t, uint32_t, const void * ){} );
 		context.vkCmdResetQueryPool = PFN_vkCmdResetQueryPool( []( VkCommandBuffer, VkQueryPool, uint32_t, uint32_t ){} );
 		context.vkCmdWriteTimestamp = PFN_vkCmdWriteTimestamp( []( VkCommandBuffer, VkPipelineStageFlagBits, VkQueryPool, uint32_t ){} );
@@ -1,10 +1,12 @@
 #pragma once
 
 #include <RenderGraph/FrameGraphPrerequisites.hpp>
+#include <RenderGraph/GraphContext.hpp>
 #include <RenderGraph/RunnablePass.hpp>
 
 #include "BaseTest.hpp"
 
+#include <functional>
 #include <sstream>
 
 namespace test
@@ -62,6 +64,71 @@ namespace test
 		return { 0u, nullptr };
 	}
 
+	/**
+	*\brief
+	*	Replaces a GraphContext function by a hook, for the lifetime of the ContextHook.
+	*\remarks
+	*	The replaced function is restored on destruction, and can be called from the hook through next().
+	*	Only one hook can be active for a given function.
+	*/
+	template< auto FunctionT >
+	class ContextHook;
+
+	template< typename RetT, typename ... ParamsT, RetT( VKAPI_PTR * crg::GraphContext::* FunctionT )( ParamsT ... ) >
+	class ContextHook< FunctionT >
+	{
+	public:
+		using PfnT = RetT( VKAPI_PTR * )( ParamsT ... );
+		using HookT = std::function< RetT( ParamsT ... ) >;
+
+		ContextHook( ContextHook const & ) = delete;
+		ContextHook & operator=( ContextHook const & ) = delete;
+		ContextHook( ContextHook && ) = delete;
+		ContextHook & operator=( ContextHook && ) = delete;
+
+		ContextHook( crg::GraphContext & context
+			, HookT hook )
+			: m_context{ context }
+		{
+			getNext() = m_context.*FunctionT;
+			getHook() = std::move( hook );
+			m_context.*FunctionT = &ContextHook::call;
+		}
+
+		~ContextHook()noexcept
+		{
+			m_context.*FunctionT = getNext();
+			getHook() = nullptr;
+			getNext() = nullptr;
+		}
+
+		static RetT next( ParamsT ... params )
+		{
+			return getNext()( params ... );
+		}
+
+	private:
+		static RetT VKAPI_PTR call( ParamsT ... params )
+		{
+			return getHook()( params ... );
+		}
+
+		static PfnT & getNext()
+		{
+			static PfnT result{};
+			return result;
+		}
+
+		static HookT & getHook()
+		{
+			static HookT result{};
+			return result;
+		}
+
+	private:
+		crg::GraphContext & m_context;
+	};
+
 	using CheckViews = std::function< void( test::TestCounts &
 		, crg::FramePass const &
 		, crg::RunnableGraph const &
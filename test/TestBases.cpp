@@ -3,11 +3,15 @@
 #include <RenderGraph/FrameGraph.hpp>
 #include <RenderGraph/FramePassTimer.hpp>
 #include <RenderGraph/ImageData.hpp>
+#include <RenderGraph/PipelineCache.hpp>
 #include <RenderGraph/ResourceHandler.hpp>
 #include <RenderGraph/RunnableGraph.hpp>
 #include <RenderGraph/RunnablePass.hpp>
 #include <RenderGraph/RunnablePasses/GenerateMipmaps.hpp>
 
+#include <array>
+#include <cstring>
+#include <filesystem>
 #include <sstream>
 #include <thread>
 
@@ -166,6 +170,43 @@ namespace
 		testEnd()
 	}
 
+	void testPipelineCache( test::TestCounts & testCounts )
+	{
+		testBegin( "testPipelineCache" )
+		auto & context = getContext();
+		auto filePath = ( std::filesystem::temp_directory_path() / ( testCounts.testName + ".bin" ) ).string();
+		std::filesystem::remove( filePath );
+		auto previous = context.cache;
+		{
+			crg::PipelineCache cache{ context, filePath };
+			check( context.cache == cache.getCache() )
+			check( !cache.isLoaded() )
+			check( cache.save() )
+			check( std::filesystem::exists( filePath ) )
+			check( !std::filesystem::exists( filePath + ".tmp" ) )
+		}
+		check( context.cache == previous )
+		{
+			crg::PipelineCache cache{ context, filePath };
+			check( cache.isLoaded() )
+		}
+		std::array< uint32_t, 4u > header{ 16u + VK_UUID_SIZE
+			, uint32_t( VK_PIPELINE_CACHE_HEADER_VERSION_ONE )
+			, context.properties.vendorID
+			, context.properties.deviceID };
+		std::vector< uint8_t > data( sizeof( header ) + VK_UUID_SIZE, uint8_t{} );
+		std::memcpy( data.data(), header.data(), sizeof( header ) );
+		std::memcpy( data.data() + sizeof( header ), context.properties.pipelineCacheUUID, VK_UUID_SIZE );
+		check( crg::PipelineCache::isCompatible( context.properties, data ) )
+		VkPhysicalDeviceProperties properties = context.properties;
+		++properties.vendorID;
+		check( !crg::PipelineCache::isCompatible( properties, data ) )
+		data.resize( 3u );
+		check( !crg::PipelineCache::isCompatible( context.properties, data ) )
+		std::filesystem::remove( filePath );
+		testEnd()
+	}
+
 	void testFramePassTimer( test::TestCounts & testCounts )
 	{
 		testBegin( "testFramePassTimer" )
@@ -637,6 +678,110 @@ namespace
 		testEnd()
 	}
 
+	void testBufferRangeStates( test::TestCounts & testCounts )
+	{
+		testBegin( "testBufferRangeStates" )
+		using BarrierHook = test::ContextHook< &crg::GraphContext::vkCmdPipelineBarrier >;
+		std::vector< VkBufferMemoryBarrier > barriers;
+		auto & context = getContext();
+		BarrierHook barrierHook{ context
+			, [&barriers]( VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask, VkDependencyFlags dependencyFlags
+			, uint32_t memoryBarrierCount, const VkMemoryBarrier * pMemoryBarriers
+			, uint32_t bufferMemoryBarrierCount, const VkBufferMemoryBarrier * pBufferMemoryBarriers
+			, uint32_t imageMemoryBarrierCount, const VkImageMemoryBarrier * pImageMemoryBarriers )
+			{
+				barriers.insert( barriers.end(), pBufferMemoryBarriers, pBufferMemoryBarriers + bufferMemoryBarrierCount );
+				BarrierHook::next( commandBuffer, srcStageMask, dstStageMask, dependencyFlags
+					, memoryBarrierCount, pMemoryBarriers
+					, bufferMemoryBarrierCount, pBufferMemoryBarriers
+					, imageMemoryBarrierCount, pImageMemoryBarriers );
+			} };
+		{
+			crg::ResourceHandler handler;
+			crg::ResourcesCache resources{ handler };
+			crg::RecordContext recContext( resources.getContextCache( context ) );
+			auto buffer = VkBuffer( 1 );
+			crg::AccessState const write{ VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT };
+			crg::AccessState const transfer{ VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT };
+			crg::AccessState const read{ VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT };
+			recContext.setAccessState( buffer, { 0u, 256u }, write );
+			recContext.setAccessState( buffer, { 256u, 256u }, transfer );
+			check( recContext.getAccessState( buffer, { 0u, 16u } ).access == write.access )
+			check( recContext.getAccessState( buffer, { 256u, 16u } ).access == transfer.access )
+			check( recContext.getAccessState( buffer, { 1024u, 16u } ).pipelineStage == VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT )
+
+			// Only the accessed range gets a barrier.
+			recContext.memoryBarrier( VkCommandBuffer{}, buffer, { 256u, 256u }, read );
+			require( barriers.size() == 1u )
+			check( barriers.back().offset == 256u )
+			check( barriers.back().size == 256u )
+			check( barriers.back().srcAccessMask == transfer.access )
+			check( recContext.getAccessState( buffer, { 0u, 16u } ).access == write.access )
+			check( recContext.getAccessState( buffer, { 300u, 16u } ).access == read.access )
+
+			// Already in the wanted state.
+			recContext.memoryBarrier( VkCommandBuffer{}, buffer, { 256u, 128u }, read );
+			check( barriers.size() == 1u )
+
+			// Whole buffer: the written interval and the unknown tail only.
+			recContext.memoryBarrier( VkCommandBuffer{}, buffer, { 0u, VK_WHOLE_SIZE }, read );
+			require( barriers.size() == 3u )
+			check( barriers[1].offset == 0u )
+			check( barriers[1].size == 256u )
+			check( barriers[1].srcAccessMask == write.access )
+			check( barriers[2].offset == 512u )
+			check( barriers[2].size == VK_WHOLE_SIZE )
+			check( recContext.getAccessState( buffer, { 4096u, 16u } ).access == read.access )
+		}
+		testEnd()
+	}
+
+	void testReadBarrierElision( test::TestCounts & testCounts )
+	{
+		testBegin( "testReadBarrierElision" )
+		using BarrierHook = test::ContextHook< &crg::GraphContext::vkCmdPipelineBarrier >;
+		uint32_t barrierCount{};
+		auto & context = getContext();
+		BarrierHook barrierHook{ context
+			, [&barrierCount]( VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask, VkDependencyFlags dependencyFlags
+			, uint32_t memoryBarrierCount, const VkMemoryBarrier * pMemoryBarriers
+			, uint32_t bufferMemoryBarrierCount, const VkBufferMemoryBarrier * pBufferMemoryBarriers
+			, uint32_t imageMemoryBarrierCount, const VkImageMemoryBarrier * pImageMemoryBarriers )
+			{
+				++barrierCount;
+				BarrierHook::next( commandBuffer, srcStageMask, dstStageMask, dependencyFlags
+					, memoryBarrierCount, pMemoryBarriers
+					, bufferMemoryBarrierCount, pBufferMemoryBarriers
+					, imageMemoryBarrierCount, pImageMemoryBarriers );
+			} };
+		{
+			crg::ResourceHandler handler;
+			crg::ResourcesCache resources{ handler };
+			crg::RecordContext recContext( resources.getContextCache( context ) );
+			auto buffer = VkBuffer( 1 );
+			crg::AccessState const write{ VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT };
+			crg::AccessState const computeRead{ VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT };
+			crg::AccessState const fragmentRead{ VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT };
+			recContext.setAccessState( buffer, { 0u, VK_WHOLE_SIZE }, write );
+
+			recContext.memoryBarrier( VkCommandBuffer{}, buffer, { 0u, VK_WHOLE_SIZE }, computeRead );
+			check( barrierCount == 1u )
+			// The write has not been made visible to the fragment stage yet.
+			recContext.memoryBarrier( VkCommandBuffer{}, buffer, { 0u, VK_WHOLE_SIZE }, fragmentRead );
+			check( barrierCount == 2u )
+			check( recContext.getAccessState( buffer, { 0u, VK_WHOLE_SIZE } ).pipelineStage == ( VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT ) )
+			// Both stages see the write now.
+			recContext.memoryBarrier( VkCommandBuffer{}, buffer, { 0u, VK_WHOLE_SIZE }, computeRead );
+			recContext.memoryBarrier( VkCommandBuffer{}, buffer, { 0u, VK_WHOLE_SIZE }, fragmentRead );
+			check( barrierCount == 2u )
+			check( recContext.getElidedBarriersCount() == 2u )
+			// A write is never elided.
+			recContext.memoryBarrier( VkCommandBuffer{}, buffer, { 0u, VK_WHOLE_SIZE }, write );
+			check( barrierCount == 3u )
+		}
+		testEnd()
+	}
+
 	void testResourcesCache( test::TestCounts & testCounts )
 	{
 		testBegin( "testResourcesCache" )
@@ -685,6 +830,64 @@ namespace
 			resources.createQuadTriVertexBuffer( context, false, {} );
 			resources.createQuadTriVertexBuffer( context, true, {} );
 		}
+		{
+			auto result = handler.createImageId( test::createImage( "fbo", VK_FORMAT_R16G16B16A16_SFLOAT ) );
+			auto resultv = handler.createViewId( test::createView( "fbov", result, VK_FORMAT_R16G16B16A16_SFLOAT, 0u, 1u, 0u, 1u ) );
+			auto & cache = resources.getContextCache( context );
+			cache.createImage( result );
+			crg::VkImageViewArray views{ cache.createImageView( resultv ) };
+			auto renderPass = VkRenderPass( 1 );
+			VkExtent2D fullSize{ 1024u, 1024u };
+			VkExtent2D halfSize{ 512u, 512u };
+			auto fbo = cache.createFramebuffer( "fbo", renderPass, views, fullSize, 1u );
+			check( fbo == cache.createFramebuffer( "fbo", renderPass, views, fullSize, 1u ) )
+			check( fbo != cache.createFramebuffer( "fbo", renderPass, views, halfSize, 1u ) )
+			cache.destroyFramebuffers( renderPass );
+			auto other = cache.createFramebuffer( "fbo", renderPass, views, fullSize, 1u );
+			check( fbo != other )
+			cache.destroyImageView( resultv );
+			views = { cache.createImageView( resultv ) };
+			check( other != cache.createFramebuffer( "fbo", renderPass, views, fullSize, 1u ) )
+			cache.destroyImageView( resultv );
+			cache.destroyImage( result );
+		}
+		{
+			auto & cache = resources.getContextCache( context );
+			VkAttachmentDescription attach{ 0u
+				, VK_FORMAT_R16G16B16A16_SFLOAT
+				, VK_SAMPLE_COUNT_1_BIT
+				, VK_ATTACHMENT_LOAD_OP_CLEAR
+				, VK_ATTACHMENT_STORE_OP_STORE
+				, VK_ATTACHMENT_LOAD_OP_DONT_CARE
+				, VK_ATTACHMENT_STORE_OP_DONT_CARE
+				, VK_IMAGE_LAYOUT_UNDEFINED
+				, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+			VkAttachmentReference colourRef{ 0u, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+			VkSubpassDescription subpass{ 0u
+				, VK_PIPELINE_BIND_POINT_GRAPHICS
+				, 0u, nullptr
+				, 1u, &colourRef
+				, nullptr, nullptr
+				, 0u, nullptr };
+			VkRenderPassCreateInfo createInfo{ VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO
+				, nullptr
+				, 0u
+				, 1u, &attach
+				, 1u, &subpass
+				, 0u, nullptr };
+			auto renderPass = cache.createRenderPass( "rp", createInfo );
+			check( renderPass == cache.createRenderPass( "rp", createInfo ) )
+			attach.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+			attach.initialLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			auto other = cache.createRenderPass( "rp", createInfo );
+			check( renderPass != other )
+			cache.destroyRenderPass( other );
+			auto recreated = cache.createRenderPass( "rp", createInfo );
+			check( recreated != other )
+			cache.destroyRenderPass( recreated );
+			cache.destroyRenderPass( renderPass );
+			cache.destroyRenderPass( renderPass );
+		}
 		testEnd()
 	}
 
@@ -705,6 +908,7 @@ int main( int argc, char ** argv )
 	testBaseFuncs( testCounts );
 	testSignal( testCounts );
 	testFence( testCounts );
+	testPipelineCache( testCounts );
 	testFramePassTimer( testCounts );
 	testImplicitActions( testCounts );
 	testPrePassActions( testCounts );
@@ -714,6 +918,8 @@ int main( int argc, char ** argv )
 	testPassGroupDeps( testCounts );
 	testPassGroups( testCounts );
 	testResourcesCache( testCounts );
+	testBufferRangeStates( testCounts );
+	testReadBarrierElision( testCounts );
 	testGraphNodes( testCounts );
 	testSuiteEnd()
 }
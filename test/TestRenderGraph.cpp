@@ -1,12 +1,15 @@
 #include "Common.hpp"
 
+#include <RenderGraph/DotExport.hpp>
 #include <RenderGraph/FrameGraph.hpp>
 #include <RenderGraph/ImageData.hpp>
 #include <RenderGraph/ResourceHandler.hpp>
 #include <RenderGraph/RunnableGraph.hpp>
 #include <RenderGraph/RunnablePass.hpp>
 #include <RenderGraph/RunnablePasses/GenerateMipmaps.hpp>
+#include <RenderGraph/RunnablePasses/RenderQuad.hpp>
 
+#include <algorithm>
 #include <sstream>
 
 namespace
@@ -2465,6 +2468,638 @@ namespace
 		test::checkRunnable( testCounts, runnable );
 		testEnd()
 	}
+
+	void testNextLayoutsSkipDisabledPasses( test::TestCounts & testCounts )
+	{
+		testBegin( "testNextLayoutsSkipDisabledPasses" )
+		crg::ResourceHandler handler;
+		crg::FrameGraph graph{ handler, testCounts.testName };
+		auto rt = graph.createImage( test::createImage( "rt", VK_FORMAT_R32G32B32A32_SFLOAT ) );
+		auto rtv = graph.createView( test::createView( "rtv", rt ) );
+		auto & pass1 = graph.createPass( "pass1C"
+			, [&testCounts]( crg::FramePass const & framePass
+				, crg::GraphContext & context
+				, crg::RunnableGraph & runGraph )
+			{
+				return createDummy( testCounts
+					, framePass, context, runGraph, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT
+					, checkOutputColourIsShaderReadOnly );
+			} );
+		pass1.addOutputColourView( rtv );
+
+		auto cpy = graph.createImage( test::createImage( "cpy", VK_FORMAT_R32G32B32A32_SFLOAT ) );
+		auto cpyv = graph.createView( test::createView( "cpyv", cpy ) );
+		auto & pass2 = graph.createPass( "pass2T"
+			, [&testCounts]( crg::FramePass const & framePass
+				, crg::GraphContext & context
+				, crg::RunnableGraph & runGraph )
+			{
+				return createDummy( testCounts
+					, framePass, context, runGraph, VK_PIPELINE_STAGE_TRANSFER_BIT
+					, test::checkDummy, 0u, false );
+			} );
+		pass2.addDependency( pass1 );
+		pass2.addTransferInputView( rtv );
+		pass2.addTransferOutputView( cpyv );
+
+		auto out = graph.createImage( test::createImage( "out", VK_FORMAT_R32G32B32A32_SFLOAT ) );
+		auto outv = graph.createView( test::createView( "outv", out ) );
+		auto & pass3 = graph.createPass( "pass3C"
+			, [&testCounts]( crg::FramePass const & framePass
+				, crg::GraphContext & context
+				, crg::RunnableGraph & runGraph )
+			{
+				return createDummy( testCounts
+					, framePass, context, runGraph, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT );
+			} );
+		pass3.addDependency( pass2 );
+		pass3.addSampledView( rtv, 0u );
+		pass3.addOutputColourView( outv );
+
+		auto runnable = graph.compile( getContext() );
+		test::checkRunnable( testCounts, runnable );
+		testEnd()
+	}
+
+	void testNextLayoutsPerImage( test::TestCounts & testCounts )
+	{
+		testBegin( "testNextLayoutsPerImage" )
+		crg::ResourceHandler handler;
+		crg::FrameGraph graph{ handler, testCounts.testName };
+		auto rt1 = graph.createImage( test::createImage( "rt1", VK_FORMAT_R32G32B32A32_SFLOAT ) );
+		auto rt1v = graph.createView( test::createView( "rt1v", rt1 ) );
+		auto rt2 = graph.createImage( test::createImage( "rt2", VK_FORMAT_R32G32B32A32_SFLOAT ) );
+		auto rt2v = graph.createView( test::createView( "rt2v", rt2 ) );
+		bool checked{};
+		auto & pass1 = graph.createPass( "pass1C"
+			, [&testCounts, &checked, rt1v, rt2v]( crg::FramePass const & framePass
+				, crg::GraphContext & context
+				, crg::RunnableGraph & runGraph )
+			{
+				return createDummy( testCounts
+					, framePass, context, runGraph, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT
+					, [&checked, rt1v, rt2v]( test::TestCounts & testCounts
+						, crg::FramePass const &
+						, crg::RunnableGraph const &
+						, crg::RecordContext const & recordContext
+						, uint32_t )
+					{
+						// Each image gets the layout of its own first user.
+						check( recordContext.getNextLayoutState( rt1v ).layout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL )
+						check( recordContext.getNextLayoutState( rt2v ).layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL )
+						checked = true;
+					} );
+			} );
+		pass1.addOutputColourView( rt1v );
+		pass1.addOutputColourView( rt2v );
+
+		auto cpy = graph.createImage( test::createImage( "cpy", VK_FORMAT_R32G32B32A32_SFLOAT ) );
+		auto cpyv = graph.createView( test::createView( "cpyv", cpy ) );
+		auto & pass2 = graph.createPass( "pass2T"
+			, [&testCounts]( crg::FramePass const & framePass
+				, crg::GraphContext & context
+				, crg::RunnableGraph & runGraph )
+			{
+				return createDummy( testCounts
+					, framePass, context, runGraph, VK_PIPELINE_STAGE_TRANSFER_BIT );
+			} );
+		pass2.addDependency( pass1 );
+		pass2.addTransferInputView( rt1v );
+		pass2.addTransferOutputView( cpyv );
+
+		auto out = graph.createImage( test::createImage( "out", VK_FORMAT_R32G32B32A32_SFLOAT ) );
+		auto outv = graph.createView( test::createView( "outv", out ) );
+		auto & pass3 = graph.createPass( "pass3C"
+			, [&testCounts]( crg::FramePass const & framePass
+				, crg::GraphContext & context
+				, crg::RunnableGraph & runGraph )
+			{
+				return createDummy( testCounts
+					, framePass, context, runGraph, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT );
+			} );
+		pass3.addDependency( pass2 );
+		pass3.addSampledView( rt2v, 0u );
+		pass3.addSampledView( cpyv, 1u );
+		pass3.addOutputColourView( outv );
+
+		auto runnable = graph.compile( getContext() );
+		test::checkRunnable( testCounts, runnable );
+		check( checked )
+		testEnd()
+	}
+
+	void testSubpassMergeCandidates( test::TestCounts & testCounts )
+	{
+		testBegin( "testSubpassMergeCandidates" )
+		crg::ResourceHandler handler;
+		crg::FrameGraph graph{ handler, testCounts.testName };
+		auto createQuad = []( crg::FramePass const & framePass
+			, crg::GraphContext & context
+			, crg::RunnableGraph & runGraph )
+		{
+			return crg::RenderQuadBuilder{}
+				.program( crg::VkPipelineShaderStageCreateInfoArray{ VkPipelineShaderStageCreateInfo{} } )
+				.build( framePass, context, runGraph );
+		};
+		auto rtData = test::createImage( "rt", VK_FORMAT_R32G32B32A32_SFLOAT );
+		rtData.info.usage |= VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+		auto rt = graph.createImage( rtData );
+		auto rtv = graph.createView( test::createView( "rtv", rt ) );
+		auto & pass1 = graph.createPass( "pass1C", createQuad );
+		pass1.addOutputColourView( rtv );
+
+		auto & pass2 = graph.createPass( "pass2C", createQuad );
+		pass2.addDependency( pass1 );
+		pass2.addInOutColourView( rtv );
+
+		auto out = graph.createImage( test::createImage( "out", VK_FORMAT_R32G32B32A32_SFLOAT ) );
+		auto outv = graph.createView( test::createView( "outv", out ) );
+		auto & pass3 = graph.createPass( "pass3C", createQuad );
+		pass3.addDependency( pass2 );
+		pass3.addSamePixelSampledView( rtv, 0u );
+		pass3.addOutputColourView( outv );
+
+		auto fin = graph.createImage( test::createImage( "fin", VK_FORMAT_R32G32B32A32_SFLOAT ) );
+		auto finv = graph.createView( test::createView( "finv", fin ) );
+		auto & pass4 = graph.createPass( "pass4C", createQuad );
+		pass4.addDependency( pass3 );
+		pass4.addSampledView( outv, 0u );
+		pass4.addOutputColourView( finv );
+
+		auto runnable = graph.compile( getContext() );
+		test::checkRunnable( testCounts, runnable );
+		auto & chains = runnable->getRenderPassChains();
+		require( chains.size() == 1u )
+		require( chains.front().size() == 3u )
+		check( chains.front()[0] == &pass1 )
+		check( chains.front()[1] == &pass2 )
+		check( chains.front()[2] == &pass3 )
+		// The intermediate render target is only read inside the merged render pass.
+		check( runnable->isOutputConsumed( pass2, rtv ) )
+		check( !runnable->isMergedOutputConsumed( pass2, rtv ) )
+		check( runnable->isMergedOutputConsumed( pass3, outv ) )
+
+		std::stringstream stream;
+		crg::dot::Config config{};
+		config.withSubpassMerges = true;
+		crg::dot::displayPasses( stream, *runnable, config );
+		check( stream.str().find( "Subpass merge" ) != std::string::npos )
+		testEnd()
+	}
+
+	void testSubpassMergeRequiresInputAttachment( test::TestCounts & testCounts )
+	{
+		testBegin( "testSubpassMergeRequiresInputAttachment" )
+		crg::ResourceHandler handler;
+		crg::FrameGraph graph{ handler, testCounts.testName };
+		auto createQuad = []( crg::FramePass const & framePass
+			, crg::GraphContext & context
+			, crg::RunnableGraph & runGraph )
+		{
+			return crg::RenderQuadBuilder{}
+				.program( crg::VkPipelineShaderStageCreateInfoArray{ VkPipelineShaderStageCreateInfo{} } )
+				.build( framePass, context, runGraph );
+		};
+		auto rt = graph.createImage( test::createImage( "rt", VK_FORMAT_R32G32B32A32_SFLOAT ) );
+		auto rtv = graph.createView( test::createView( "rtv", rt ) );
+		auto & pass1 = graph.createPass( "pass1C", createQuad );
+		pass1.addOutputColourView( rtv );
+
+		auto out = graph.createImage( test::createImage( "out", VK_FORMAT_R32G32B32A32_SFLOAT ) );
+		auto outv = graph.createView( test::createView( "outv", out ) );
+		auto & pass2 = graph.createPass( "pass2C", createQuad );
+		pass2.addDependency( pass1 );
+		pass2.addSamePixelSampledView( rtv, 0u );
+		pass2.addOutputColourView( outv );
+
+		auto runnable = graph.compile( getContext() );
+		test::checkRunnable( testCounts, runnable );
+		check( runnable->getRenderPassChains().empty() )
+		testEnd()
+	}
+
+	void testOutputsConsumption( test::TestCounts & testCounts )
+	{
+		testBegin( "testOutputsConsumption" )
+		crg::ResourceHandler handler;
+		crg::FrameGraph graph{ handler, testCounts.testName };
+		auto depth = graph.createImage( test::createImage( "depth", VK_FORMAT_D32_SFLOAT ) );
+		auto depthv = graph.createView( test::createView( "depthv", depth ) );
+		auto hist = graph.createImage( test::createImage( "hist", VK_FORMAT_R32G32B32A32_SFLOAT ) );
+		auto histv = graph.createView( test::createView( "histv", hist ) );
+		auto rt = graph.createImage( test::createImage( "rt", VK_FORMAT_R32G32B32A32_SFLOAT ) );
+		auto rtv = graph.createView( test::createView( "rtv", rt ) );
+		auto & pass1 = graph.createPass( "pass1C"
+			, [&testCounts]( crg::FramePass const & framePass
+				, crg::GraphContext & context
+				, crg::RunnableGraph & runGraph )
+			{
+				return createDummy( testCounts
+					, framePass, context, runGraph, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT );
+			} );
+		pass1.addSampledView( histv, 0u );
+		pass1.addOutputDepthView( depthv );
+		pass1.addOutputColourView( rtv );
+
+		auto & pass2 = graph.createPass( "pass2C"
+			, [&testCounts]( crg::FramePass const & framePass
+				, crg::GraphContext & context
+				, crg::RunnableGraph & runGraph )
+			{
+				return createDummy( testCounts
+					, framePass, context, runGraph, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT );
+			} );
+		pass2.addDependency( pass1 );
+		pass2.addInOutDepthView( depthv );
+		pass2.addInOutColourView( rtv );
+		pass2.addOutputColourView( histv );
+
+		auto runnable = graph.compile( getContext() );
+		test::checkRunnable( testCounts, runnable );
+		// Read by pass2
+		check( runnable->isOutputConsumed( pass1, depthv ) )
+		check( runnable->isOutputConsumed( pass1, rtv ) )
+		// Not read afterwards
+		check( !runnable->isOutputConsumed( pass2, depthv ) )
+		check( !runnable->isOutputConsumed( pass2, rtv ) )
+		// Read by pass1, in next run
+		check( runnable->isOutputConsumed( pass2, histv ) )
+
+		graph.addOutput( rtv, crg::makeLayoutState( VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL ) );
+		check( runnable->isOutputConsumed( pass2, rtv ) )
+		testEnd()
+	}
+
+	void testPassCulling( test::TestCounts & testCounts )
+	{
+		testBegin( "testPassCulling" )
+		crg::ResourceHandler handler;
+		crg::FrameGraph graph{ handler, testCounts.testName };
+		uint32_t created{};
+		auto creator = [&testCounts, &created]( crg::FramePass const & framePass
+			, crg::GraphContext & context
+			, crg::RunnableGraph & runGraph )
+		{
+			++created;
+			return createDummy( testCounts
+				, framePass, context, runGraph, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT );
+		};
+		auto rt = graph.createImage( test::createImage( "rt", VK_FORMAT_R32G32B32A32_SFLOAT ) );
+		auto rtv = graph.createView( test::createView( "rtv", rt ) );
+		auto & pass1 = graph.createPass( "pass1C", creator );
+		pass1.addOutputColourView( rtv );
+
+		auto out = graph.createImage( test::createImage( "out", VK_FORMAT_R32G32B32A32_SFLOAT ) );
+		auto outv = graph.createView( test::createView( "outv", out ) );
+		auto & pass2 = graph.createPass( "pass2C", creator );
+		pass2.addDependency( pass1 );
+		pass2.addSampledView( rtv, 0u );
+		pass2.addOutputColourView( outv );
+
+		auto dbg = graph.createImage( test::createImage( "dbg", VK_FORMAT_R32G32B32A32_SFLOAT ) );
+		auto dbgv = graph.createView( test::createView( "dbgv", dbg ) );
+		auto & debugPass = graph.createPass( "debugC", creator );
+		debugPass.addDependency( pass1 );
+		debugPass.addSampledView( rtv, 0u );
+		debugPass.addOutputColourView( dbgv );
+
+		auto side = graph.createImage( test::createImage( "side", VK_FORMAT_R32G32B32A32_SFLOAT ) );
+		auto sidev = graph.createView( test::createView( "sidev", side ) );
+		auto & sidePass = graph.createPass( "sideC", creator );
+		sidePass.addDependency( pass1 );
+		sidePass.addSampledView( rtv, 0u );
+		sidePass.addOutputColourView( sidev );
+		sidePass.setSideEffects();
+
+		graph.addOutput( outv, crg::makeLayoutState( VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL ) );
+		{
+			auto runnable = graph.compile( getContext() );
+			test::checkRunnable( testCounts, runnable );
+			check( created == 4u )
+		}
+		created = 0u;
+		{
+			auto runnable = graph.compile( getContext(), true );
+			auto stream = test::checkRunnable( testCounts, runnable );
+			check( created == 3u )
+			check( stream.str().find( "debugC" ) == std::string::npos )
+			check( stream.str().find( "pass1C" ) != std::string::npos )
+		}
+		testEnd()
+	}
+
+	void testBufferWriterCulling( test::TestCounts & testCounts )
+	{
+		testBegin( "testBufferWriterCulling" )
+		crg::ResourceHandler handler;
+		crg::FrameGraph graph{ handler, testCounts.testName };
+		std::vector< std::string > created;
+		auto creator = [&testCounts, &created]( crg::FramePass const & framePass
+			, crg::GraphContext & context
+			, crg::RunnableGraph & runGraph )
+		{
+			created.push_back( framePass.getName() );
+			return createDummy( testCounts
+				, framePass, context, runGraph, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT );
+		};
+		auto & ssboPass = graph.createPass( "ssboC", creator );
+		ssboPass.addOutputStorageBuffer( crg::Buffer{ VkBuffer( 1 ), "ssbo" }, 0u, 0u, 1024u );
+
+		auto & tmpPass = graph.createPass( "tmpC", creator );
+		tmpPass.addOutputStorageBuffer( crg::Buffer{ VkBuffer( 2 ), "tmp" }, 0u, 0u, 1024u );
+
+		auto dbg = graph.createImage( test::createImage( "dbg", VK_FORMAT_R32G32B32A32_SFLOAT ) );
+		auto dbgv = graph.createView( test::createView( "dbgv", dbg ) );
+		auto & debugPass = graph.createPass( "debugC", creator );
+		debugPass.addDependency( tmpPass );
+		debugPass.addInputStorageBuffer( crg::Buffer{ VkBuffer( 2 ), "tmp" }, 0u, 0u, 1024u );
+		debugPass.addOutputStorageView( dbgv, 1u );
+
+		auto & group = graph.createPassGroup( "Outer" ).createPassGroup( "Inner" );
+		auto out = group.createImage( test::createImage( "out", VK_FORMAT_R32G32B32A32_SFLOAT ) );
+		auto outv = group.createView( test::createView( "outv", out ) );
+		auto & groupPass = group.createPass( "groupC", creator );
+		groupPass.addOutputStorageView( outv, 0u );
+		group.addGroupOutput( outv );
+
+		auto runnable = graph.compile( getContext(), true );
+		test::checkRunnable( testCounts, runnable );
+		check( created.size() == 2u )
+		check( std::find( created.begin(), created.end(), "ssboC" ) != created.end() )
+		check( std::find( created.begin(), created.end(), "groupC" ) != created.end() )
+		testEnd()
+	}
+
+	void testMemoryStats( test::TestCounts & testCounts )
+	{
+		testBegin( "testMemoryStats" )
+		crg::ResourceHandler handler;
+		crg::FrameGraph graph{ handler, testCounts.testName };
+		auto rt = graph.createImage( test::createImage( "rt", VK_FORMAT_R32G32B32A32_SFLOAT ) );
+		auto rtv = graph.createView( test::createView( "rtv", rt ) );
+		auto & pass1 = graph.createPass( "pass1C"
+			, [&testCounts]( crg::FramePass const & framePass
+				, crg::GraphContext & context
+				, crg::RunnableGraph & runGraph )
+			{
+				return createDummy( testCounts
+					, framePass, context, runGraph, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT );
+			} );
+		pass1.addOutputColourView( rtv );
+
+		auto tmp = graph.createImage( test::createImage( "tmp", VK_FORMAT_R32G32B32A32_SFLOAT ) );
+		auto tmpv = graph.createView( test::createView( "tmpv", tmp ) );
+		auto & pass2 = graph.createPass( "pass2C"
+			, [&testCounts]( crg::FramePass const & framePass
+				, crg::GraphContext & context
+				, crg::RunnableGraph & runGraph )
+			{
+				return createDummy( testCounts
+					, framePass, context, runGraph, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT );
+			} );
+		pass2.addDependency( pass1 );
+		pass2.addSampledView( rtv, 0u );
+		pass2.addOutputColourView( tmpv );
+
+		auto out = graph.createImage( test::createImage( "out", VK_FORMAT_R32G32B32A32_SFLOAT ) );
+		auto outv = graph.createView( test::createView( "outv", out ) );
+		auto & pass3 = graph.createPass( "pass3C"
+			, [&testCounts]( crg::FramePass const & framePass
+				, crg::GraphContext & context
+				, crg::RunnableGraph & runGraph )
+			{
+				return createDummy( testCounts
+					, framePass, context, runGraph, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT );
+			} );
+		pass3.addDependency( pass2 );
+		pass3.addSampledView( tmpv, 0u );
+		pass3.addOutputColourView( outv );
+
+		auto runnable = graph.compile( getContext() );
+		test::checkRunnable( testCounts, runnable );
+		VkDeviceSize imageSize = 1024u * 1024u * 64u;
+		check( handler.getMemory( rt ).requirements.size == imageSize )
+		check( handler.getMemoryStats().count == 3u )
+		check( handler.getPeakMemoryUsage() == 3u * imageSize )
+
+		auto stats = runnable->getMemoryStats();
+		check( stats.total.count == 3u )
+		check( stats.total.size == 3u * imageSize )
+		check( stats.groups.size() == 1u )
+		check( stats.groups[&graph.getDefaultGroup()].size == 3u * imageSize )
+		require( stats.timeline.size() == 3u )
+		check( stats.timeline[0].pass == &pass1 )
+		check( stats.timeline[0].liveSize == imageSize )
+		check( stats.timeline[1].liveSize == 2u * imageSize )
+		check( stats.timeline[2].liveSize == 2u * imageSize )
+		check( stats.livePeak == 2u * imageSize )
+
+		runnable.reset();
+		check( handler.getMemoryStats().count == 0u )
+		check( handler.getPeakMemoryUsage() == 3u * imageSize )
+		testEnd()
+	}
+
+	void testResourceLifetimes( test::TestCounts & testCounts )
+	{
+		testBegin( "testResourceLifetimes" )
+		crg::ResourceHandler handler;
+		crg::FrameGraph graph{ handler, testCounts.testName };
+		crg::Buffer buffer{ VkBuffer( 1 ), "buffer" };
+		auto rt = graph.createImage( test::createImage( "rt", VK_FORMAT_R32G32B32A32_SFLOAT ) );
+		auto rtv = graph.createView( test::createView( "rtv", rt ) );
+		auto & pass1 = graph.createPass( "pass1C"
+			, [&testCounts]( crg::FramePass const & framePass
+				, crg::GraphContext & context
+				, crg::RunnableGraph & runGraph )
+			{
+				return createDummy( testCounts
+					, framePass, context, runGraph, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT );
+			} );
+		pass1.addOutputColourView( rtv );
+		pass1.addOutputStorageBuffer( buffer, 1u, 0u, 256u );
+
+		auto tmp = graph.createImage( test::createImage( "tmp", VK_FORMAT_R32G32B32A32_SFLOAT ) );
+		auto tmpv = graph.createView( test::createView( "tmpv", tmp ) );
+		auto & pass2 = graph.createPass( "pass2C"
+			, [&testCounts]( crg::FramePass const & framePass
+				, crg::GraphContext & context
+				, crg::RunnableGraph & runGraph )
+			{
+				return createDummy( testCounts
+					, framePass, context, runGraph, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT );
+			} );
+		pass2.addDependency( pass1 );
+		pass2.addSampledView( rtv, 0u );
+		pass2.addOutputColourView( tmpv );
+
+		auto out = graph.createImage( test::createImage( "out", VK_FORMAT_R32G32B32A32_SFLOAT ) );
+		auto outv = graph.createView( test::createView( "outv", out ) );
+		auto & pass3 = graph.createPass( "pass3C"
+			, [&testCounts]( crg::FramePass const & framePass
+				, crg::GraphContext & context
+				, crg::RunnableGraph & runGraph )
+			{
+				return createDummy( testCounts
+					, framePass, context, runGraph, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT );
+			} );
+		pass3.addDependency( pass2 );
+		pass3.addSampledView( tmpv, 0u );
+		pass3.addInputStorageBuffer( buffer, 1u, 0u, 256u );
+		pass3.addOutputColourView( outv );
+
+		auto runnable = graph.compile( getContext() );
+		test::checkRunnable( testCounts, runnable );
+		auto & lifetimes = runnable->getResourceLifetimes();
+		require( lifetimes.passes.size() == 3u )
+		check( lifetimes.passes[0] == &pass1 )
+		require( lifetimes.images.size() == 3u )
+		check( lifetimes.images.at( rt ).firstPass == 0u )
+		check( lifetimes.images.at( rt ).lastPass == 1u )
+		check( lifetimes.images.at( rt ).size == 1024u * 1024u * 64u )
+		check( lifetimes.images.at( tmp ).firstPass == 1u )
+		check( lifetimes.images.at( tmp ).lastPass == 2u )
+		check( lifetimes.images.at( out ).firstPass == 2u )
+		check( lifetimes.images.at( out ).lastPass == 2u )
+		check( lifetimes.views.at( tmpv ).lastPass == 2u )
+		require( lifetimes.buffers.size() == 1u )
+		auto & bufLifetime = lifetimes.buffers.begin()->second;
+		check( bufLifetime.name == "buffer" )
+		check( bufLifetime.firstPass == 0u )
+		check( bufLifetime.lastPass == 2u )
+		check( bufLifetime.size == 256u )
+		check( bufLifetime.usage == VkBufferUsageFlags( VK_BUFFER_USAGE_STORAGE_BUFFER_BIT ) )
+
+		std::stringstream stream;
+		crg::dot::Config config{};
+		config.withLifetimes = true;
+		crg::dot::displayTransitions( stream, *runnable, config );
+		check( stream.str().find( "Image rt\\nlifetime [0, 1]" ) != std::string::npos )
+		check( stream.str().find( "Buffer buffer\\nlifetime [0, 2]" ) != std::string::npos )
+		testEnd()
+	}
+
+	void testTransientAttachments( test::TestCounts & testCounts )
+	{
+		testBegin( "testTransientAttachments" )
+		using CreateImageHook = test::ContextHook< &crg::GraphContext::vkCreateImage >;
+		std::vector< VkImageUsageFlags > usages;
+		auto & context = getContext();
+		CreateImageHook createImageHook{ context
+			, [&usages]( VkDevice device, const VkImageCreateInfo * createInfo, const VkAllocationCallbacks * allocator, VkImage * pImage )
+			{
+				usages.push_back( createInfo->usage );
+				return CreateImageHook::next( device, createInfo, allocator, pImage );
+			} };
+		auto buildGraph = [&testCounts, &context]( bool transientAttachments )
+			{
+				crg::ResourceHandler handler;
+				crg::FrameGraph graph{ handler, testCounts.testName };
+				graph.setTransientAttachments( transientAttachments );
+				auto depth = graph.createImage( test::createImage( "depth", VK_FORMAT_D32_SFLOAT ) );
+				auto depthv = graph.createView( test::createView( "depthv", depth ) );
+				auto rt = graph.createImage( test::createImage( "rt", VK_FORMAT_R32G32B32A32_SFLOAT ) );
+				auto rtv = graph.createView( test::createView( "rtv", rt ) );
+				auto & pass1 = graph.createPass( "pass1C"
+					, [&testCounts]( crg::FramePass const & framePass
+						, crg::GraphContext & ctx
+						, crg::RunnableGraph & runGraph )
+					{
+						return createDummy( testCounts
+							, framePass, ctx, runGraph, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT );
+					} );
+				pass1.addOutputDepthView( depthv );
+				pass1.addOutputColourView( rtv );
+
+				auto out = graph.createImage( test::createImage( "out", VK_FORMAT_R32G32B32A32_SFLOAT ) );
+				auto outv = graph.createView( test::createView( "outv", out ) );
+				auto & pass2 = graph.createPass( "pass2C"
+					, [&testCounts]( crg::FramePass const & framePass
+						, crg::GraphContext & ctx
+						, crg::RunnableGraph & runGraph )
+					{
+						return createDummy( testCounts
+							, framePass, ctx, runGraph, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT );
+					} );
+				pass2.addDependency( pass1 );
+				pass2.addSampledView( rtv, 0u );
+				pass2.addOutputColourView( outv );
+				graph.addOutput( outv, crg::makeLayoutState( VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL ) );
+
+				auto runnable = graph.compile( context );
+				test::checkRunnable( testCounts, runnable );
+			};
+		// Disabled by default, since the graph images may be used outside of the graph.
+		buildGraph( false );
+		require( usages.size() == 3u )
+		check( ( usages[0] & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT ) == 0u )
+		check( ( usages[1] & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT ) == 0u )
+		check( ( usages[2] & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT ) == 0u )
+		usages.clear();
+		buildGraph( true );
+		require( usages.size() == 3u )
+		check( ( usages[0] & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT ) != 0u )
+		check( ( usages[0] & VK_IMAGE_USAGE_SAMPLED_BIT ) == 0u )
+		check( ( usages[1] & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT ) == 0u )
+		check( ( usages[2] & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT ) == 0u )
+		testEnd()
+	}
+
+	void testGraphBuffers( test::TestCounts & testCounts )
+	{
+		testBegin( "testGraphBuffers" )
+		crg::ResourceHandler handler;
+		crg::FrameGraph graph{ handler, testCounts.testName };
+		auto creator = [&testCounts]( crg::FramePass const & framePass
+			, crg::GraphContext & context
+			, crg::RunnableGraph & runGraph )
+		{
+			return createDummy( testCounts
+				, framePass, context, runGraph, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT );
+		};
+		auto bufA = graph.createBuffer( crg::BufferData{ "bufA", 1024u, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT } );
+		auto bufB = graph.createBuffer( crg::BufferData{ "bufB", 1024u, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT } );
+		auto bufC = graph.createBuffer( crg::BufferData{ "bufC", 512u, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT } );
+		check( bufA.getCount() == 1u )
+		check( bufA.buffer() == VkBuffer{} )
+		auto & pass1 = graph.createPass( "pass1", creator );
+		pass1.addOutputStorageBuffer( bufA, 0u, 0u, VK_WHOLE_SIZE );
+		auto & pass2 = graph.createPass( "pass2", creator );
+		pass2.addDependency( pass1 );
+		pass2.addInputStorageBuffer( bufA, 0u, 0u, VK_WHOLE_SIZE );
+		pass2.addOutputStorageBuffer( bufB, 1u, 0u, VK_WHOLE_SIZE );
+		auto & pass3 = graph.createPass( "pass3", creator );
+		pass3.addDependency( pass2 );
+		pass3.addInputStorageBuffer( bufB, 0u, 0u, VK_WHOLE_SIZE );
+		pass3.addOutputStorageBuffer( bufC, 1u, 0u, VK_WHOLE_SIZE );
+		{
+			auto runnable = graph.compile( getContext() );
+			test::checkRunnable( testCounts, runnable );
+			check( bufA.buffer() != VkBuffer{} )
+			check( bufA.buffer() != bufC.buffer() )
+			auto & lifetimes = runnable->getResourceLifetimes();
+			require( lifetimes.buffers.size() == 3u )
+			check( lifetimes.buffers.at( bufA.buffer() ).lastPass == 1u )
+			check( lifetimes.buffers.at( bufC.buffer() ).firstPass == 2u )
+			check( lifetimes.buffers.at( bufC.buffer() ).size == 512u )
+			// bufA and bufC don't overlap, they share the same memory block.
+			check( handler.getMemoryStats().count == 2u )
+			auto stats = runnable->getMemoryStats();
+			check( stats.total.count == 2u )
+			// The bufA/bufC block lives from pass1 to pass3, bufB from pass2 to pass3.
+			check( stats.groups[&graph.getDefaultGroup()].count == 2u )
+			check( stats.groups[&graph.getDefaultGroup()].size == stats.total.size )
+			require( stats.timeline.size() == 3u )
+			check( stats.timeline[0].liveSize != 0u )
+			check( stats.timeline[0].liveSize < stats.total.size )
+			check( stats.timeline[1].liveSize == stats.total.size )
+			check( stats.timeline[2].liveSize == stats.total.size )
+			check( stats.livePeak == stats.total.size )
+		}
+		check( bufA.buffer() == VkBuffer{} )
+		check( handler.getMemoryStats().count == 0u )
+		testEnd()
+	}
 }
 
 int main( int argc, char ** argv )
@@ -2499,6 +3134,17 @@ int main( int argc, char ** argv )
 	testRender< true, true, true, true >( testCounts );
 	testVarianceShadowMap( testCounts );
 	testEnvironmentMap( testCounts );
+	testSubpassMergeCandidates( testCounts );
+	testSubpassMergeRequiresInputAttachment( testCounts );
+	testOutputsConsumption( testCounts );
+	testPassCulling( testCounts );
+	testBufferWriterCulling( testCounts );
+	testMemoryStats( testCounts );
+	testResourceLifetimes( testCounts );
+	testTransientAttachments( testCounts );
+	testGraphBuffers( testCounts );
 	testDisabledPasses( testCounts );
+	testNextLayoutsSkipDisabledPasses( testCounts );
+	testNextLayoutsPerImage( testCounts );
 	testSuiteEnd()
 }
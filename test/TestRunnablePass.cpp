@@ -11,12 +11,22 @@
 #include <RenderGraph/RunnablePasses/GenerateMipmaps.hpp>
 #include <RenderGraph/RunnablePasses/ImageBlit.hpp>
 #include <RenderGraph/RunnablePasses/ImageCopy.hpp>
+#include <RenderGraph/RunnablePasses/ImageReadback.hpp>
 #include <RenderGraph/RunnablePasses/ImageToBufferCopy.hpp>
 #include <RenderGraph/RunnablePasses/RenderMesh.hpp>
 #include <RenderGraph/RunnablePasses/RenderPass.hpp>
 #include <RenderGraph/RunnablePasses/RenderQuad.hpp>
+#include <RenderGraph/UploadRing.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <map>
+#include <mutex>
 #include <sstream>
+#include <thread>
 
 namespace
 {
@@ -108,6 +118,102 @@ namespace
 		testEnd()
 	}
 
+	void testGenerateMipmapsBarriers( test::TestCounts & testCounts )
+	{
+		testBegin( "testGenerateMipmapsBarriers" )
+		using BarrierHook = test::ContextHook< &crg::GraphContext::vkCmdPipelineBarrier >;
+		using BlitHook = test::ContextHook< &crg::GraphContext::vkCmdBlitImage >;
+		uint32_t imageBarriers{};
+		uint32_t blits{};
+		auto & context = getContext();
+		BarrierHook barrierHook{ context
+			, [&imageBarriers]( VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask, VkDependencyFlags dependencyFlags
+			, uint32_t memoryBarrierCount, const VkMemoryBarrier * pMemoryBarriers
+			, uint32_t bufferMemoryBarrierCount, const VkBufferMemoryBarrier * pBufferMemoryBarriers
+			, uint32_t imageMemoryBarrierCount, const VkImageMemoryBarrier * pImageMemoryBarriers )
+			{
+				imageBarriers += imageMemoryBarrierCount;
+				BarrierHook::next( commandBuffer, srcStageMask, dstStageMask, dependencyFlags
+					, memoryBarrierCount, pMemoryBarriers
+					, bufferMemoryBarrierCount, pBufferMemoryBarriers
+					, imageMemoryBarrierCount, pImageMemoryBarriers );
+			} };
+		BlitHook blitHook{ context
+			, [&blits]( VkCommandBuffer commandBuffer, VkImage srcImage, VkImageLayout srcImageLayout, VkImage dstImage, VkImageLayout dstImageLayout, uint32_t regionCount, const VkImageBlit * pRegions, VkFilter filter )
+			{
+				++blits;
+				BlitHook::next( commandBuffer, srcImage, srcImageLayout, dstImage, dstImageLayout, regionCount, pRegions, filter );
+			} };
+		auto runCube = [&context, &testCounts, &imageBarriers, &blits]( crg::gm::Config config )
+		{
+			imageBarriers = 0u;
+			blits = 0u;
+			crg::ResourceHandler handler;
+			crg::FrameGraph graph{ handler, testCounts.testName };
+			auto result = graph.createImage( test::createImageCube( "result", VK_FORMAT_R16G16B16A16_SFLOAT, 12u ) );
+			auto resultv = graph.createView( test::createView( "resultv", result, VK_FORMAT_R16G16B16A16_SFLOAT, 0u, 12u, 0u, 6u ) );
+			auto & testPass = graph.createPass( "Pass"
+				, [config]( crg::FramePass const & pass
+					, crg::GraphContext & ctx
+					, crg::RunnableGraph & runGraph )
+				{
+					return std::make_unique< crg::GenerateMipmaps >( pass, ctx, runGraph, config );
+				} );
+			testPass.addTransferInOutView( resultv );
+
+			auto runnable = graph.compile( context );
+			require( runnable )
+			checkNoThrow( runnable->record() )
+		};
+		{
+			runCube( crg::gm::Config{} );
+			// One blit per level and per face.
+			check( blits == 6u * 11u )
+			// One barrier per blit source, plus a few coalesced ones, instead of 3 per blit.
+			check( imageBarriers <= 6u * 10u + 6u )
+		}
+		{
+			runCube( crg::gm::Config{}.batchLayers() );
+			// One blit per level for all the faces.
+			check( blits == 11u )
+			// One barrier per blit source level, plus a few coalesced ones.
+			check( imageBarriers <= 10u + 6u )
+		}
+		auto runImages = [&context, &testCounts, &blits]( crg::gm::Config config )
+		{
+			blits = 0u;
+			crg::ResourceHandler handler;
+			crg::FrameGraph graph{ handler, testCounts.testName };
+			auto first = graph.createImage( test::createImage( "first", VK_FORMAT_R16G16B16A16_SFLOAT, 10u, 64u ) );
+			auto firstv = graph.createView( test::createView( "firstv", first, VK_FORMAT_R16G16B16A16_SFLOAT, 0u, 10u, 0u, 64u ) );
+			auto second = graph.createImage( test::createImage( "second", VK_FORMAT_R16G16B16A16_SFLOAT, 4u ) );
+			auto secondv = graph.createView( test::createView( "secondv", second, VK_FORMAT_R16G16B16A16_SFLOAT, 0u, 4u, 0u, 1u ) );
+			auto & testPass = graph.createPass( "Pass"
+				, [config]( crg::FramePass const & pass
+					, crg::GraphContext & ctx
+					, crg::RunnableGraph & runGraph )
+				{
+					return std::make_unique< crg::GenerateMipmaps >( pass, ctx, runGraph, config );
+				} );
+			testPass.addTransferInOutView( firstv );
+			testPass.addTransferInOutView( secondv );
+
+			auto runnable = graph.compile( context );
+			require( runnable )
+			checkNoThrow( runnable->record() )
+		};
+		{
+			// Only the first image is processed by default.
+			runImages( crg::gm::Config{}.batchLayers() );
+			check( blits == 9u )
+		}
+		{
+			runImages( crg::gm::Config{}.allImages().batchLayers() );
+			check( blits == 9u + 3u )
+		}
+		testEnd()
+	}
+
 	void testImageBlit( test::TestCounts & testCounts )
 	{
 		testBegin( "testImageBlit" )
@@ -208,6 +314,186 @@ namespace
 		testEnd()
 	}
 
+	void testBatchedCopies( test::TestCounts & testCounts )
+	{
+		testBegin( "testBatchedCopies" )
+		using CopyImageHook = test::ContextHook< &crg::GraphContext::vkCmdCopyImage >;
+		using CopyBufferHook = test::ContextHook< &crg::GraphContext::vkCmdCopyBuffer >;
+		using CopyImageToBufferHook = test::ContextHook< &crg::GraphContext::vkCmdCopyImageToBuffer >;
+		std::vector< uint32_t > regionCounts;
+		std::vector< VkDeviceSize > bufferOffsets;
+		auto & context = getContext();
+		CopyImageHook copyImageHook{ context
+			, [&regionCounts]( VkCommandBuffer commandBuffer, VkImage srcImage, VkImageLayout srcImageLayout, VkImage dstImage, VkImageLayout dstImageLayout, uint32_t regionCount, const VkImageCopy * pRegions )
+			{
+				regionCounts.push_back( regionCount );
+				CopyImageHook::next( commandBuffer, srcImage, srcImageLayout, dstImage, dstImageLayout, regionCount, pRegions );
+			} };
+		CopyBufferHook copyBufferHook{ context
+			, [&regionCounts]( VkCommandBuffer commandBuffer, VkBuffer srcBuffer, VkBuffer dstBuffer, uint32_t regionCount, const VkBufferCopy * pRegions )
+			{
+				regionCounts.push_back( regionCount );
+				CopyBufferHook::next( commandBuffer, srcBuffer, dstBuffer, regionCount, pRegions );
+			} };
+		CopyImageToBufferHook copyImageToBufferHook{ context
+			, [&regionCounts, &bufferOffsets]( VkCommandBuffer commandBuffer, VkImage srcImage, VkImageLayout srcImageLayout, VkBuffer dstBuffer, uint32_t regionCount, const VkBufferImageCopy * pRegions )
+			{
+				regionCounts.push_back( regionCount );
+
+				for ( uint32_t i = 0u; i < regionCount; ++i )
+				{
+					bufferOffsets.push_back( pRegions[i].bufferOffset );
+				}
+
+				CopyImageToBufferHook::next( commandBuffer, srcImage, srcImageLayout, dstBuffer, regionCount, pRegions );
+			} };
+		{
+			regionCounts.clear();
+			crg::ResourceHandler handler;
+			crg::FrameGraph graph{ handler, testCounts.testName };
+			auto input = graph.createImage( test::createImage( "input", VK_FORMAT_R16G16B16A16_SFLOAT, 1u, 4u ) );
+			auto result = graph.createImage( test::createImage( "result", VK_FORMAT_R16G16B16A16_SFLOAT, 1u, 4u ) );
+			auto & testPass = graph.createPass( "Pass"
+				, []( crg::FramePass const & pass
+					, crg::GraphContext & ctx
+					, crg::RunnableGraph & runGraph )
+				{
+					return std::make_unique< crg::ImageCopy >( pass, ctx, runGraph
+						, getExtent( pass.images.front().view() )
+						, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL );
+				} );
+
+			for ( uint32_t layer = 0u; layer < 4u; ++layer )
+			{
+				auto suffix = std::to_string( layer );
+				testPass.addTransferInputView( graph.createView( test::createView( "inputv" + suffix, input, VK_FORMAT_R16G16B16A16_SFLOAT, 0u, 1u, layer, 1u ) ) );
+				testPass.addTransferOutputView( graph.createView( test::createView( "resultv" + suffix, result, VK_FORMAT_R16G16B16A16_SFLOAT, 0u, 1u, layer, 1u ) ) );
+			}
+
+			auto runnable = graph.compile( context );
+			require( runnable )
+			checkNoThrow( runnable->record() )
+			// The four layers pairs are copied with a single call.
+			check( regionCounts.size() == 1u )
+			check( regionCounts.front() == 4u )
+		}
+		{
+			regionCounts.clear();
+			crg::ResourceHandler handler;
+			crg::FrameGraph graph{ handler, testCounts.testName };
+			auto & testPass = graph.createPass( "Pass"
+				, []( crg::FramePass const & pass
+					, crg::GraphContext & ctx
+					, crg::RunnableGraph & runGraph )
+				{
+					return std::make_unique< crg::BufferCopy >( pass, ctx, runGraph
+						, crg::BufferCopyRegionArray{ { 0u, 1u, VkBufferCopy{ 0u, 0u, 256u } }
+							, { 2u, 3u, VkBufferCopy{ 0u, 0u, 256u } }
+							, { 4u, 5u, VkBufferCopy{ 0u, 0u, 256u } } } );
+				} );
+			testPass.addTransferInputBuffer( crg::Buffer{ VkBuffer( 1 ), "inBuffer" }, 0u, 256u );
+			testPass.addTransferOutputBuffer( crg::Buffer{ VkBuffer( 2 ), "outBuffer" }, 0u, 256u );
+			testPass.addTransferInputBuffer( crg::Buffer{ VkBuffer( 1 ), "inBuffer" }, 256u, 256u );
+			testPass.addTransferOutputBuffer( crg::Buffer{ VkBuffer( 2 ), "outBuffer" }, 256u, 256u );
+			testPass.addTransferInputBuffer( crg::Buffer{ VkBuffer( 3 ), "inBuffer2" }, 0u, 256u );
+			testPass.addTransferOutputBuffer( crg::Buffer{ VkBuffer( 2 ), "outBuffer" }, 512u, 256u );
+
+			auto runnable = graph.compile( context );
+			require( runnable )
+			checkNoThrow( runnable->record() )
+			// Two source buffers, one destination buffer.
+			check( regionCounts.size() == 2u )
+			check( regionCounts.front() == 2u )
+			check( regionCounts.back() == 1u )
+		}
+		{
+			regionCounts.clear();
+			crg::ResourceHandler handler;
+			crg::FrameGraph graph{ handler, testCounts.testName };
+			auto & testPass = graph.createPass( "Pass"
+				, []( crg::FramePass const & pass
+					, crg::GraphContext & ctx
+					, crg::RunnableGraph & runGraph )
+				{
+					return std::make_unique< crg::BufferCopy >( pass, ctx, runGraph
+						, 0u, 256u );
+				} );
+			testPass.addTransferInputBuffer( crg::Buffer{ VkBuffer( 1 ), "inBuffer" }, 0u, 256u );
+			testPass.addTransferInputBuffer( crg::Buffer{ VkBuffer( 3 ), "inBuffer2" }, 0u, 256u );
+			testPass.addTransferOutputBuffer( crg::Buffer{ VkBuffer( 2 ), "outBuffer" }, 0u, 256u );
+
+			auto runnable = graph.compile( context );
+			require( runnable )
+			checkNoThrow( runnable->record() )
+			// Without regions, only the first buffer is copied into the last one.
+			check( regionCounts.size() == 1u )
+			check( regionCounts.front() == 1u )
+		}
+		{
+			crg::ResourceHandler handler;
+			crg::FrameGraph graph{ handler, testCounts.testName };
+			auto & testPass = graph.createPass( "Pass"
+				, []( crg::FramePass const & pass
+					, crg::GraphContext & ctx
+					, crg::RunnableGraph & runGraph )
+				{
+					return std::make_unique< crg::BufferCopy >( pass, ctx, runGraph
+						, crg::BufferCopyRegionArray{ { 0u, 2u, VkBufferCopy{ 0u, 0u, 256u } } } );
+				} );
+			testPass.addTransferInputBuffer( crg::Buffer{ VkBuffer( 1 ), "inBuffer" }, 0u, 256u );
+			testPass.addTransferOutputBuffer( crg::Buffer{ VkBuffer( 2 ), "outBuffer" }, 0u, 256u );
+			// The region refers to a buffer the pass doesn't have.
+			checkThrow( graph.compile( context ) )
+		}
+		{
+			regionCounts.clear();
+			crg::ResourceHandler handler;
+			crg::FrameGraph graph{ handler, testCounts.testName };
+			auto input = graph.createImage( test::createImage( "input", VK_FORMAT_R16G16B16A16_SFLOAT, 1u, 2u ) );
+			auto inputv0 = graph.createView( test::createView( "inputv0", input, VK_FORMAT_R16G16B16A16_SFLOAT, 0u, 1u, 0u, 1u ) );
+			auto inputv1 = graph.createView( test::createView( "inputv1", input, VK_FORMAT_R16G16B16A16_SFLOAT, 0u, 1u, 1u, 1u ) );
+			auto createPass = [&graph, &inputv0, &inputv1]( std::string const & name
+				, crg::RunnablePassCreator creator )
+				{
+					auto & result = graph.createPass( name, std::move( creator ) );
+					result.addTransferInputView( inputv0 );
+					result.addTransferInputView( inputv1 );
+					result.addTransferOutputBuffer( crg::Buffer{ VkBuffer( 1 ), name + "Buffer" }, 256u, 2048u );
+					return &result;
+				};
+			createPass( "Default"
+				, []( crg::FramePass const & pass
+					, crg::GraphContext & ctx
+					, crg::RunnableGraph & runGraph )
+				{
+					return std::make_unique< crg::ImageToBufferCopy >( pass, ctx, runGraph
+						, VkOffset3D{}, VkExtent3D{ 4u, 4u, 1u } );
+				} );
+			createPass( "Regions"
+				, []( crg::FramePass const & pass
+					, crg::GraphContext & ctx
+					, crg::RunnableGraph & runGraph )
+				{
+					return std::make_unique< crg::ImageToBufferCopy >( pass, ctx, runGraph
+						, crg::BufferImageCopyRegionArray{ { 0u, 0u, VkBufferImageCopy{ 256u, 0u, 0u, {}, {}, VkExtent3D{ 4u, 4u, 1u } } }
+							, { 1u, 0u, VkBufferImageCopy{ 384u, 0u, 0u, {}, {}, VkExtent3D{ 4u, 4u, 1u } } } } );
+				} );
+
+			auto runnable = graph.compile( context );
+			require( runnable )
+			checkNoThrow( runnable->record() )
+			// Without regions, only the last image is copied, at the start of the first buffer.
+			require( regionCounts.size() == 2u )
+			check( regionCounts.front() == 1u )
+			check( regionCounts.back() == 2u )
+			require( bufferOffsets.size() == 3u )
+			check( bufferOffsets[0] == 0u )
+			check( bufferOffsets[1] == 256u )
+			check( bufferOffsets[2] == 384u )
+		}
+		testEnd()
+	}
+
 	void testImageToBufferCopy( test::TestCounts & testCounts )
 	{
 		testBegin( "testImageToBufferCopy" )
@@ -231,6 +517,67 @@ namespace
 		testEnd()
 	}
 
+	void testImageReadback( test::TestCounts & testCounts )
+	{
+		testBegin( "testImageReadback" )
+		crg::ResourceHandler handler;
+		crg::FrameGraph graph{ handler, testCounts.testName };
+		auto input = graph.createImage( test::createImage( "input", VK_FORMAT_R16G16B16A16_SFLOAT ) );
+		auto inputv = graph.createView( test::createView( "inputv", input, VK_FORMAT_R16G16B16A16_SFLOAT, 0u, 1u, 0u, 1u ) );
+		uint32_t readCount{};
+		VkDeviceSize readSize{};
+		auto & testPass = graph.createPass( "Pass"
+			, [inputv, &readCount, &readSize]( crg::FramePass const & pass
+				, crg::GraphContext & context
+				, crg::RunnableGraph & runGraph )
+			{
+				return std::make_unique< crg::ImageReadback >( pass, context, runGraph
+					, VkOffset3D{}, VkExtent3D{ 16u, 16u, 1u }, 16u * 16u * 8u
+					, [&readCount, &readSize]( void const *, VkDeviceSize size )
+					{
+						++readCount;
+						readSize = size;
+					} );
+			} );
+		testPass.addTransferInputView( inputv );
+		testPass.setSideEffects();
+
+		auto runnable = graph.compile( getContext() );
+		require( runnable )
+		checkNoThrow( runnable->run( VkQueue{} ) )
+		// The data is given back once the frame has completed, not before.
+		check( readCount == 0u )
+		checkNoThrow( runnable->run( VkQueue{} ) )
+		check( readCount == 1u )
+		check( readSize == 16u * 16u * 8u )
+		checkNoThrow( runnable->run( VkQueue{} ) )
+		check( readCount == 2u )
+		testEnd()
+	}
+
+	void testImageReadbackTooSmall( test::TestCounts & testCounts )
+	{
+		testBegin( "testImageReadbackTooSmall" )
+		crg::ResourceHandler handler;
+		crg::FrameGraph graph{ handler, testCounts.testName };
+		auto input = graph.createImage( test::createImage( "input", VK_FORMAT_R16G16B16A16_SFLOAT ) );
+		auto inputv = graph.createView( test::createView( "inputv", input, VK_FORMAT_R16G16B16A16_SFLOAT, 0u, 1u, 0u, 1u ) );
+		auto & testPass = graph.createPass( "Pass"
+			, []( crg::FramePass const & pass
+				, crg::GraphContext & context
+				, crg::RunnableGraph & runGraph )
+			{
+				// 16x16 RGBA16F texels need 8 bytes each.
+				return std::make_unique< crg::ImageReadback >( pass, context, runGraph
+					, VkOffset3D{}, VkExtent3D{ 16u, 16u, 1u }, 16u * 16u * 4u
+					, []( void const *, VkDeviceSize ){} );
+			} );
+		testPass.addTransferInputView( inputv );
+		testPass.setSideEffects();
+		checkThrow( graph.compile( getContext() ) )
+		testEnd()
+	}
+
 	void testComputePass( test::TestCounts & testCounts )
 	{
 		testBegin( "testComputePass" )
@@ -311,6 +658,86 @@ namespace
 		testEnd()
 	}
 
+	void testComputePassDispatches( test::TestCounts & testCounts )
+	{
+		testBegin( "testComputePassDispatches" )
+		using DispatchHook = test::ContextHook< &crg::GraphContext::vkCmdDispatch >;
+		using PushConstantsHook = test::ContextHook< &crg::GraphContext::vkCmdPushConstants >;
+		using BarrierHook = test::ContextHook< &crg::GraphContext::vkCmdPipelineBarrier >;
+		std::vector< uint32_t > groupCounts;
+		std::vector< uint32_t > pushedOffsets;
+		uint32_t memoryBarriers{};
+		auto & context = getContext();
+		DispatchHook dispatchHook{ context
+			, [&groupCounts]( VkCommandBuffer commandBuffer, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ )
+			{
+				groupCounts.push_back( groupCountX );
+				DispatchHook::next( commandBuffer, groupCountX, groupCountY, groupCountZ );
+			} };
+		PushConstantsHook pushConstantsHook{ context
+			, [&pushedOffsets]( VkCommandBuffer commandBuffer, VkPipelineLayout layout, VkShaderStageFlags stageFlags, uint32_t offset, uint32_t size, const void * pValues )
+			{
+				pushedOffsets.push_back( offset );
+				PushConstantsHook::next( commandBuffer, layout, stageFlags, offset, size, pValues );
+			} };
+		BarrierHook barrierHook{ context
+			, [&memoryBarriers]( VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask, VkDependencyFlags dependencyFlags
+			, uint32_t memoryBarrierCount, const VkMemoryBarrier * pMemoryBarriers
+			, uint32_t bufferMemoryBarrierCount, const VkBufferMemoryBarrier * pBufferMemoryBarriers
+			, uint32_t imageMemoryBarrierCount, const VkImageMemoryBarrier * pImageMemoryBarriers )
+			{
+				memoryBarriers += memoryBarrierCount;
+				BarrierHook::next( commandBuffer, srcStageMask, dstStageMask, dependencyFlags
+					, memoryBarrierCount, pMemoryBarriers
+					, bufferMemoryBarrierCount, pBufferMemoryBarriers
+					, imageMemoryBarrierCount, pImageMemoryBarriers );
+			} };
+		{
+			crg::ResourceHandler handler;
+			crg::FrameGraph graph{ handler, testCounts.testName };
+			auto & testPass = graph.createPass( "Pass"
+				, []( crg::FramePass const & pass
+					, crg::GraphContext & ctx
+					, crg::RunnableGraph & runGraph )
+				{
+					crg::cp::DispatchArray dispatches;
+
+					for ( uint32_t i = 0u; i < 4u; ++i )
+					{
+						crg::cp::Dispatch dispatch{ i + 1u, 1u, 1u };
+						dispatch.pushConstants.resize( sizeof( uint32_t ) );
+						std::memcpy( dispatch.pushConstants.data(), &i, sizeof( uint32_t ) );
+						// The last dispatch reads what the previous ones wrote.
+						dispatch.dependsOnPrevious = i == 3u;
+						dispatches.push_back( std::move( dispatch ) );
+					}
+
+					crg::cp::Config cfg;
+					cfg.dispatches( std::move( dispatches ) );
+					cfg.pushConstants( VkPushConstantRange{ VK_SHADER_STAGE_COMPUTE_BIT, 0u, sizeof( uint32_t ) } );
+					cfg.baseConfig( crg::pp::Config{}
+						.programCreator( crg::ProgramCreator{ 1u
+							, []( uint32_t ){ return crg::VkPipelineShaderStageCreateInfoArray{ VkPipelineShaderStageCreateInfo{} }; } } ) );
+					return std::make_unique< crg::ComputePass >( pass, ctx, runGraph
+						, crg::ru::Config{}, std::move( cfg ) );
+				} );
+			testPass.addOutputStorageBuffer( crg::Buffer{ VkBuffer( 1 ), "buffer" }, 0u, 0u, 1024u );
+			testPass.setSideEffects();
+
+			auto runnable = graph.compile( context );
+			require( runnable )
+			groupCounts.clear();
+			pushedOffsets.clear();
+			memoryBarriers = 0u;
+			checkNoThrow( runnable->record() )
+			check( groupCounts.size() == 4u )
+			check( groupCounts.back() == 4u )
+			check( pushedOffsets.size() == 4u )
+			check( memoryBarriers == 1u )
+		}
+		testEnd()
+	}
+
 	void testComputePassTransitions( test::TestCounts & testCounts )
 	{
 		testBegin( "testComputePassTransitions" )
@@ -715,6 +1142,97 @@ namespace
 		testEnd()
 	}
 
+	void testRenderMeshIndirectCount( test::TestCounts & testCounts )
+	{
+		testBegin( "testRenderMeshIndirectCount" )
+#if VK_VERSION_1_2
+		using DrawHook = test::ContextHook< &crg::GraphContext::vkCmdDrawIndexedIndirectCount >;
+		using BarrierHook = test::ContextHook< &crg::GraphContext::vkCmdPipelineBarrier >;
+		std::vector< uint32_t > maxDrawCounts;
+		uint32_t indirectBarriers{};
+		auto & context = getContext();
+		DrawHook drawHook{ context
+			, [&maxDrawCounts]( VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkBuffer countBuffer, VkDeviceSize countBufferOffset, uint32_t maxDrawCount, uint32_t stride )
+			{
+				maxDrawCounts.push_back( maxDrawCount );
+				DrawHook::next( commandBuffer, buffer, offset, countBuffer, countBufferOffset, maxDrawCount, stride );
+			} };
+		BarrierHook barrierHook{ context
+			, [&indirectBarriers]( VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask, VkDependencyFlags dependencyFlags
+			, uint32_t memoryBarrierCount, const VkMemoryBarrier * pMemoryBarriers
+			, uint32_t bufferMemoryBarrierCount, const VkBufferMemoryBarrier * pBufferMemoryBarriers
+			, uint32_t imageMemoryBarrierCount, const VkImageMemoryBarrier * pImageMemoryBarriers )
+			{
+				if ( ( dstStageMask & VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT ) != 0u )
+				{
+					indirectBarriers += bufferMemoryBarrierCount;
+				}
+
+				BarrierHook::next( commandBuffer, srcStageMask, dstStageMask, dependencyFlags
+					, memoryBarrierCount, pMemoryBarriers
+					, bufferMemoryBarrierCount, pBufferMemoryBarriers
+					, imageMemoryBarrierCount, pImageMemoryBarriers );
+			} };
+		{
+			crg::ResourceHandler handler;
+			crg::FrameGraph graph{ handler, testCounts.testName };
+			auto result = graph.createImage( test::createImage( "result", VK_FORMAT_R16G16B16A16_SFLOAT ) );
+			auto resultv = graph.createView( test::createView( "resultv", result, VK_FORMAT_R16G16B16A16_SFLOAT, 0u, 1u, 0u, 1u ) );
+			crg::Buffer indirect{ VkBuffer( 3 ), "indirect" };
+			crg::Buffer count{ VkBuffer( 4 ), "count" };
+			auto & cullPass = graph.createPass( "Cull"
+				, []( crg::FramePass const & pass
+					, crg::GraphContext & ctx
+					, crg::RunnableGraph & runGraph )
+				{
+					crg::cp::Config cfg;
+					cfg.baseConfig( crg::pp::Config{}
+						.programCreator( crg::ProgramCreator{ 1u
+							, []( uint32_t ){ return crg::VkPipelineShaderStageCreateInfoArray{ VkPipelineShaderStageCreateInfo{} }; } } ) );
+					return std::make_unique< crg::ComputePass >( pass, ctx, runGraph
+						, crg::ru::Config{}, std::move( cfg ) );
+				} );
+			cullPass.addOutputStorageBuffer( indirect, 0u, 0u, 64u * sizeof( VkDrawIndexedIndirectCommand ) );
+			cullPass.addClearableOutputStorageBuffer( count, 1u, 0u, sizeof( uint32_t ) );
+			crg::RenderMesh * renderMesh{};
+			auto & drawPass = graph.createPass( "Draw"
+				, [&renderMesh, indirect, count]( crg::FramePass const & pass
+					, crg::GraphContext & ctx
+					, crg::RunnableGraph & runGraph )
+				{
+					crg::rm::Config cfg;
+					cfg.indirectBuffer( crg::IndirectBuffer{ indirect, sizeof( VkDrawIndexedIndirectCommand ) } );
+					cfg.indirectCountBuffer( crg::IndirectCountBuffer{ count, 64u } );
+					cfg.indexBuffer( crg::IndexBuffer{ crg::Buffer{ VkBuffer( 2 ), "idx" } } );
+					cfg.baseConfig( crg::pp::Config{}
+						.programCreator( crg::ProgramCreator{ 1u
+							, []( uint32_t ){ return crg::VkPipelineShaderStageCreateInfoArray{ VkPipelineShaderStageCreateInfo{} }; } } ) );
+					auto res = std::make_unique< crg::RenderMesh >( pass, ctx, runGraph
+						, crg::ru::Config{ 1u, true }, std::move( cfg ) );
+					renderMesh = res.get();
+					return res;
+				} );
+			drawPass.addDependency( cullPass );
+			drawPass.addIndirectBuffer( indirect, 0u, 64u * sizeof( VkDrawIndexedIndirectCommand ) );
+			drawPass.addIndirectBuffer( count, 0u, sizeof( uint32_t ) );
+			drawPass.addOutputColourView( resultv );
+
+			auto runnable = graph.compile( context );
+			test::checkRunnable( testCounts, runnable );
+			require( renderMesh )
+			checkNoThrow( renderMesh->resetPipeline( crg::VkPipelineShaderStageCreateInfoArray{ VkPipelineShaderStageCreateInfo{} }, 0u ) )
+			maxDrawCounts.clear();
+			indirectBarriers = 0u;
+			checkNoThrow( runnable->record() )
+			check( maxDrawCounts.size() == 1u )
+			check( maxDrawCounts.front() == 64u )
+			// Both the commands and the count are made visible to the indirect draw.
+			check( indirectBarriers >= 2u )
+		}
+#endif
+		testEnd()
+	}
+
 	void testRenderTexturedMesh( test::TestCounts & testCounts )
 	{
 		testBegin( "testRenderTexturedMesh" )
@@ -779,6 +1297,858 @@ namespace
 		check( graph.getDefaultGroup().getFinalLayoutState( sampledv, 0u ).layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL )
 		testEnd()
 	}
+
+	void testAsyncPipelineCompilation( test::TestCounts & testCounts )
+	{
+		testBegin( "testAsyncPipelineCompilation" )
+		using CreateGraphicsPipelinesHook = test::ContextHook< &crg::GraphContext::vkCreateGraphicsPipelines >;
+		using CreateComputePipelinesHook = test::ContextHook< &crg::GraphContext::vkCreateComputePipelines >;
+		using BindPipelineHook = test::ContextHook< &crg::GraphContext::vkCmdBindPipeline >;
+		using DispatchHook = test::ContextHook< &crg::GraphContext::vkCmdDispatch >;
+		using DestroyPipelineHook = test::ContextHook< &crg::GraphContext::vkDestroyPipeline >;
+		// Holds the compilation of a program until it is opened.
+		struct Gate
+		{
+			void open()
+			{
+				if ( !opened )
+				{
+					opened = true;
+					promise.set_value();
+				}
+			}
+
+			std::promise< void > promise{};
+			std::shared_future< void > future{ promise.get_future().share() };
+			bool opened{};
+		};
+		struct CompileGates
+		{
+			void wait( std::string const & program )const
+			{
+				if ( program == "program1" )
+				{
+					program1.future.wait();
+				}
+				else if ( program == "program2" )
+				{
+					program2.future.wait();
+				}
+			}
+
+			Gate program1{};
+			Gate program2{};
+		};
+		auto makeProgram = []( char const * name )
+		{
+			return crg::VkPipelineShaderStageCreateInfoArray{ VkPipelineShaderStageCreateInfo{ VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO
+				, nullptr
+				, 0u
+				, VK_SHADER_STAGE_FRAGMENT_BIT
+				, VkShaderModule{}
+				, name
+				, nullptr } };
+		};
+		CompileGates gates;
+		std::mutex mutex;
+		std::map< VkPipeline, std::string > pipelinePrograms;
+		auto registerPipeline = [&mutex, &pipelinePrograms]( VkPipeline pipeline, std::string program )
+		{
+			std::lock_guard< std::mutex > lock{ mutex };
+			pipelinePrograms[pipeline] = std::move( program );
+		};
+		auto getProgram = [&mutex, &pipelinePrograms]( VkPipeline pipeline )
+		{
+			std::lock_guard< std::mutex > lock{ mutex };
+			auto it = pipelinePrograms.find( pipeline );
+			return it == pipelinePrograms.end() ? std::string{} : it->second;
+		};
+		std::atomic_bool quadProgram1Compiled{};
+		std::string lastQuadProgram;
+		uint32_t dispatches{};
+		uint32_t destroyedPipelines{};
+		auto & context = getContext();
+		CreateGraphicsPipelinesHook createGraphicsPipelinesHook{ context
+			, [&gates, &registerPipeline, &quadProgram1Compiled]( VkDevice device, VkPipelineCache cache, uint32_t createInfoCount, const VkGraphicsPipelineCreateInfo * createInfos, const VkAllocationCallbacks * allocator, VkPipeline * pipelines )
+			{
+				std::string program = createInfos->pStages->pName;
+				gates.wait( program );
+				auto res = CreateGraphicsPipelinesHook::next( device, cache, createInfoCount, createInfos, allocator, pipelines );
+				registerPipeline( *pipelines, program );
+				quadProgram1Compiled = quadProgram1Compiled || program == "program1";
+				return res;
+			} };
+		CreateComputePipelinesHook createComputePipelinesHook{ context
+			, [&gates, &registerPipeline]( VkDevice device, VkPipelineCache cache, uint32_t createInfoCount, const VkComputePipelineCreateInfo * createInfos, const VkAllocationCallbacks * allocator, VkPipeline * pipelines )
+			{
+				std::string program = createInfos->stage.pName;
+				gates.wait( program );
+				auto res = CreateComputePipelinesHook::next( device, cache, createInfoCount, createInfos, allocator, pipelines );
+				registerPipeline( *pipelines, program );
+				return res;
+			} };
+		BindPipelineHook bindPipelineHook{ context
+			, [&getProgram, &lastQuadProgram]( VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipeline pipeline )
+			{
+				if ( bindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS )
+				{
+					lastQuadProgram = getProgram( pipeline );
+				}
+
+				BindPipelineHook::next( commandBuffer, bindPoint, pipeline );
+			} };
+		DispatchHook dispatchHook{ context
+			, [&dispatches]( VkCommandBuffer commandBuffer, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ )
+			{
+				++dispatches;
+				DispatchHook::next( commandBuffer, groupCountX, groupCountY, groupCountZ );
+			} };
+		DestroyPipelineHook destroyPipelineHook{ context
+			, [&destroyedPipelines]( VkDevice device, VkPipeline pipeline, const VkAllocationCallbacks * allocator )
+			{
+				++destroyedPipelines;
+				DestroyPipelineHook::next( device, pipeline, allocator );
+			} };
+		crg::ResourceHandler handler;
+		crg::FrameGraph graph{ handler, testCounts.testName };
+		auto sampled = graph.createImage( test::createImage( "sampled", VK_FORMAT_R16G16B16A16_SFLOAT ) );
+		auto sampledv = graph.createView( test::createView( "sampledv", sampled, VK_FORMAT_R16G16B16A16_SFLOAT, 0u, 1u, 0u, 1u ) );
+		crg::ComputePass * computePass{};
+		auto & testCompute = graph.createPass( "Compute"
+			, [&computePass, &makeProgram]( crg::FramePass const & pass
+				, crg::GraphContext & context
+				, crg::RunnableGraph & runGraph )
+			{
+				crg::cp::Config cfg;
+				cfg.baseConfig( crg::pp::Config{}
+					.asyncCompile( true )
+					.program( makeProgram( "program1" ) ) );
+				auto res = std::make_unique< crg::ComputePass >( pass, context, runGraph
+					, crg::ru::Config{ 1u, true }, std::move( cfg ) );
+				computePass = res.get();
+				return res;
+			} );
+		testCompute.addOutputStorageView( sampledv, 0u );
+
+		auto result = graph.createImage( test::createImage( "result", VK_FORMAT_R16G16B16A16_SFLOAT ) );
+		auto resultv = graph.createView( test::createView( "resultv", result, VK_FORMAT_R16G16B16A16_SFLOAT, 0u, 1u, 0u, 1u ) );
+		crg::RenderQuad * renderQuad{};
+		auto & testQuad = graph.createPass( "Quad"
+			, [&renderQuad, &makeProgram]( crg::FramePass const & pass
+				, crg::GraphContext & context
+				, crg::RunnableGraph & runGraph )
+			{
+				auto res = crg::RenderQuadBuilder{}
+					.asyncCompile( true )
+					.fallbackProgram( makeProgram( "fallback" ) )
+					.program( makeProgram( "program1" ) )
+					.build( pass, context, runGraph, crg::ru::Config{ 1u, true } );
+				renderQuad = res.get();
+				return res;
+			} );
+		testQuad.addDependency( testCompute );
+		testQuad.addSampledView( sampledv, 0u );
+		testQuad.addOutputColourView( resultv );
+
+		auto runnable = graph.compile( context );
+		// The pending compilations must be able to end before the runnable graph is destroyed.
+		struct GatesGuard
+		{
+			~GatesGuard()noexcept
+			{
+				gates.program1.open();
+				gates.program2.open();
+			}
+
+			CompileGates & gates;
+		} gatesGuard{ gates };
+		test::checkRunnable( testCounts, runnable );
+		require( computePass )
+		require( renderQuad )
+
+		// While the compilations are pending, the compute pass is skipped, and the quad uses its fallback pipeline.
+		checkNoThrow( runnable->record() )
+		checkNoThrow( runnable->run( VkQueue{} ) )
+		check( dispatches == 0u )
+		check( lastQuadProgram == "fallback" )
+
+		// Changing the program while its compilation is pending waits for the compilation to end.
+		std::thread opener{ [&gates]()
+			{
+				std::this_thread::sleep_for( std::chrono::milliseconds{ 20 } );
+				gates.program1.open();
+			} };
+		checkNoThrow( renderQuad->resetPipeline( makeProgram( "program2" ), 0u ) )
+		opener.join();
+		check( quadProgram1Compiled )
+		auto destroyedBefore = destroyedPipelines;
+		checkNoThrow( runnable->record() )
+		checkNoThrow( runnable->run( VkQueue{} ) )
+		check( lastQuadProgram == "fallback" )
+		// The program1 quad pipeline and its fallback are destroyed once the GPU is done with them.
+		check( destroyedPipelines == destroyedBefore + 2u )
+
+		// Once the compilations are done, the real pipelines are used.
+		gates.program2.open();
+
+		for ( uint32_t i = 0u; i < 1000u && ( lastQuadProgram != "program2" || dispatches == 0u ); ++i )
+		{
+			std::this_thread::sleep_for( std::chrono::milliseconds{ 1 } );
+			checkNoThrow( runnable->record() )
+		}
+
+		check( lastQuadProgram == "program2" )
+		check( dispatches > 0u )
+		testEnd()
+	}
+
+	void testDynamicRendering( test::TestCounts & testCounts )
+	{
+		testBegin( "testDynamicRendering" )
+		using BeginRenderingHook = test::ContextHook< &crg::GraphContext::vkCmdBeginRenderingKHR >;
+		using EndRenderingHook = test::ContextHook< &crg::GraphContext::vkCmdEndRenderingKHR >;
+		using BeginRenderPassHook = test::ContextHook< &crg::GraphContext::vkCmdBeginRenderPass >;
+		struct DynamicRenderingGuard
+		{
+			explicit DynamicRenderingGuard( crg::GraphContext & context )
+				: m_context{ context }
+				, m_previous{ context.dynamicRendering }
+			{
+				m_context.dynamicRendering = true;
+			}
+
+			DynamicRenderingGuard( DynamicRenderingGuard const & ) = delete;
+			DynamicRenderingGuard & operator=( DynamicRenderingGuard const & ) = delete;
+
+			~DynamicRenderingGuard()noexcept
+			{
+				m_context.dynamicRendering = m_previous;
+			}
+
+		private:
+			crg::GraphContext & m_context;
+			bool m_previous;
+		};
+		uint32_t beginRenderings{};
+		uint32_t endRenderings{};
+		uint32_t beginRenderPasses{};
+		auto & context = getContext();
+		DynamicRenderingGuard guard{ context };
+		BeginRenderingHook beginRenderingHook{ context
+			, [&beginRenderings]( VkCommandBuffer commandBuffer, const VkRenderingInfoKHR * renderingInfo )
+			{
+				++beginRenderings;
+				BeginRenderingHook::next( commandBuffer, renderingInfo );
+			} };
+		EndRenderingHook endRenderingHook{ context
+			, [&endRenderings]( VkCommandBuffer commandBuffer )
+			{
+				++endRenderings;
+				EndRenderingHook::next( commandBuffer );
+			} };
+		BeginRenderPassHook beginRenderPassHook{ context
+			, [&beginRenderPasses]( VkCommandBuffer commandBuffer, const VkRenderPassBeginInfo * beginInfo, VkSubpassContents contents )
+			{
+				++beginRenderPasses;
+				BeginRenderPassHook::next( commandBuffer, beginInfo, contents );
+			} };
+		{
+			crg::ResourceHandler handler;
+			crg::FrameGraph graph{ handler, testCounts.testName };
+			auto result = graph.createImage( test::createImage( "result", VK_FORMAT_R16G16B16A16_SFLOAT ) );
+			auto resultv = graph.createView( test::createView( "resultv", result, VK_FORMAT_R16G16B16A16_SFLOAT, 0u, 1u, 0u, 1u ) );
+			auto depthStencil = graph.createImage( test::createImage( "depthStencil", VK_FORMAT_D32_SFLOAT_S8_UINT ) );
+			auto depthStencilv = graph.createView( test::createView( "depthStencilv", depthStencil, VK_FORMAT_D32_SFLOAT_S8_UINT, 0u, 1u, 0u, 1u ) );
+			auto & testQuad = graph.createPass( "Quad"
+				, []( crg::FramePass const & pass
+					, crg::GraphContext & ctx
+					, crg::RunnableGraph & runGraph )
+				{
+					return crg::RenderQuadBuilder{}
+						.program( crg::VkPipelineShaderStageCreateInfoArray{ VkPipelineShaderStageCreateInfo{} } )
+						.build( pass, ctx, runGraph );
+				} );
+			testQuad.addOutputColourView( resultv );
+			testQuad.addOutputDepthStencilView( depthStencilv );
+
+			auto other = graph.createImage( test::createImage( "other", VK_FORMAT_R8G8B8A8_UNORM ) );
+			auto otherv = graph.createView( test::createView( "otherv", other, VK_FORMAT_R8G8B8A8_UNORM, 0u, 1u, 0u, 1u ) );
+			crg::RenderPass * renderPass{};
+			auto & testPass = graph.createPass( "Pass"
+				, [&renderPass]( crg::FramePass const & pass
+					, crg::GraphContext & ctx
+					, crg::RunnableGraph & runGraph )
+				{
+					auto res = std::make_unique< crg::RenderPass >( pass, ctx, runGraph
+						, crg::RenderPass::Callbacks{ crg::defaultV< crg::RunnablePass::InitialiseCallback >
+							, crg::defaultV< crg::RunnablePass::RecordCallback > } );
+					renderPass = res.get();
+					return res;
+				} );
+			testPass.addDependency( testQuad );
+			testPass.addSampledView( resultv, 0u );
+			testPass.addOutputColourView( otherv );
+			testPass.addInOutDepthStencilView( depthStencilv );
+
+			auto runnable = graph.compile( context );
+			test::checkRunnable( testCounts, runnable );
+			require( renderPass )
+			checkNoThrow( runnable->record() )
+			checkNoThrow( runnable->run( VkQueue{} ) )
+			checkNoThrow( runnable->record() )
+			checkNoThrow( runnable->run( VkQueue{} ) )
+			check( renderPass->isDynamicRendering() )
+			check( renderPass->getRenderPass( 0u ) == VkRenderPass{} )
+			auto & formats = renderPass->getRenderingFormats( 0u );
+			require( formats.colour.size() == 1u )
+			check( formats.colour.front() == VK_FORMAT_R8G8B8A8_UNORM )
+			check( formats.depth == VK_FORMAT_D32_SFLOAT_S8_UINT )
+			check( formats.stencil == VK_FORMAT_D32_SFLOAT_S8_UINT )
+			check( beginRenderings > 0u )
+			check( endRenderings == beginRenderings )
+			check( beginRenderPasses == 0u )
+		}
+		testEnd()
+	}
+
+	void testCommandBufferVariants( test::TestCounts & testCounts )
+	{
+		testBegin( "testCommandBufferVariants" )
+		crg::ResourceHandler handler;
+		crg::FrameGraph graph{ handler, testCounts.testName };
+		auto result = graph.createImage( test::createImage( "result", VK_FORMAT_R16G16B16A16_SFLOAT ) );
+		auto resultv = graph.createView( test::createView( "resultv", result, VK_FORMAT_R16G16B16A16_SFLOAT, 0u, 1u, 0u, 1u ) );
+		uint32_t recordCount{};
+		bool enabled{ true };
+		auto & testPass = graph.createPass( "Pass"
+			, [&recordCount, &enabled]( crg::FramePass const & pass
+				, crg::GraphContext & context
+				, crg::RunnableGraph & runGraph )
+			{
+				return std::make_unique< crg::RunnablePass >( pass, context, runGraph
+					, crg::RunnablePass::Callbacks{ crg::defaultV< crg::RunnablePass::InitialiseCallback >
+						, crg::RunnablePass::GetPipelineStateCallback( [](){ return crg::getPipelineState( VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT ); } )
+						, crg::RunnablePass::RecordCallback( [&recordCount]( crg::RecordContext &, VkCommandBuffer, uint32_t ){ ++recordCount; } )
+						, crg::RunnablePass::GetPassIndexCallback( [](){ return 0u; } )
+						, crg::RunnablePass::IsEnabledCallback( [&enabled](){ return enabled; } ) } );
+			} );
+		testPass.addOutputStorageView( resultv, 0u );
+
+		auto runnable = graph.compile( getContext() );
+		runnable->setMaxVariants( 4u );
+		// First run records the (none, enabled) variant, second one records the (enabled, enabled) one.
+		checkNoThrow( runnable->run( VkQueue{} ) )
+		checkNoThrow( runnable->run( VkQueue{} ) )
+		check( recordCount == 2u )
+		checkNoThrow( runnable->run( VkQueue{} ) )
+		check( recordCount == 2u )
+		check( runnable->getVariantCount() == 2u )
+
+		enabled = false;
+		checkNoThrow( runnable->run( VkQueue{} ) )
+		checkNoThrow( runnable->run( VkQueue{} ) )
+		check( runnable->getVariantCount() == 4u )
+		enabled = true;
+		checkNoThrow( runnable->run( VkQueue{} ) )
+		// Cap reached, recorded without being kept.
+		check( recordCount == 3u )
+		check( runnable->getVariantCount() == 4u )
+
+		runnable->invalidateVariants();
+		checkNoThrow( runnable->run( VkQueue{} ) )
+		check( recordCount == 4u )
+		check( runnable->getVariantCount() == 1u )
+		testEnd()
+	}
+
+	void testRenderPassVariants( test::TestCounts & testCounts )
+	{
+		testBegin( "testRenderPassVariants" )
+		using CreateRenderPassHook = test::ContextHook< &crg::GraphContext::vkCreateRenderPass >;
+		using DestroyRenderPassHook = test::ContextHook< &crg::GraphContext::vkDestroyRenderPass >;
+		using CreateGraphicsPipelinesHook = test::ContextHook< &crg::GraphContext::vkCreateGraphicsPipelines >;
+		using BeginRenderPassHook = test::ContextHook< &crg::GraphContext::vkCmdBeginRenderPass >;
+		std::vector< VkRenderPass > renderPasses;
+		std::vector< VkRenderPass > destroyed;
+		std::vector< VkRenderPass > pipelineRenderPasses;
+		uint32_t beginRenderPasses{};
+		auto & context = getContext();
+		CreateRenderPassHook createRenderPassHook{ context
+			, [&renderPasses]( VkDevice device, const VkRenderPassCreateInfo * createInfo, const VkAllocationCallbacks * allocator, VkRenderPass * renderPass )
+			{
+				auto res = CreateRenderPassHook::next( device, createInfo, allocator, renderPass );
+				renderPasses.push_back( *renderPass );
+				return res;
+			} };
+		DestroyRenderPassHook destroyRenderPassHook{ context
+			, [&destroyed]( VkDevice device, VkRenderPass renderPass, const VkAllocationCallbacks * allocator )
+			{
+				destroyed.push_back( renderPass );
+				DestroyRenderPassHook::next( device, renderPass, allocator );
+			} };
+		CreateGraphicsPipelinesHook createGraphicsPipelinesHook{ context
+			, [&pipelineRenderPasses]( VkDevice device, VkPipelineCache cache, uint32_t createInfoCount, const VkGraphicsPipelineCreateInfo * createInfos, const VkAllocationCallbacks * allocator, VkPipeline * pipelines )
+			{
+				pipelineRenderPasses.push_back( createInfos->renderPass );
+				return CreateGraphicsPipelinesHook::next( device, cache, createInfoCount, createInfos, allocator, pipelines );
+			} };
+		BeginRenderPassHook beginRenderPassHook{ context
+			, [&beginRenderPasses]( VkCommandBuffer commandBuffer, const VkRenderPassBeginInfo * beginInfo, VkSubpassContents contents )
+			{
+				++beginRenderPasses;
+				BeginRenderPassHook::next( commandBuffer, beginInfo, contents );
+			} };
+		{
+			crg::ResourceHandler handler;
+			crg::FrameGraph graph{ handler, testCounts.testName };
+			auto result = graph.createImage( test::createImage( "result", VK_FORMAT_R16G16B16A16_SFLOAT ) );
+			auto resultv = graph.createView( test::createView( "resultv", result, VK_FORMAT_R16G16B16A16_SFLOAT, 0u, 1u, 0u, 1u ) );
+			auto & computePass = graph.createPass( "Compute"
+				, []( crg::FramePass const & pass
+					, crg::GraphContext & ctx
+					, crg::RunnableGraph & runGraph )
+				{
+					return std::make_unique< crg::RunnablePass >( pass, ctx, runGraph
+						, crg::RunnablePass::Callbacks{ crg::defaultV< crg::RunnablePass::InitialiseCallback >
+							, crg::RunnablePass::GetPipelineStateCallback( [](){ return crg::getPipelineState( VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT ); } )
+							, crg::defaultV< crg::RunnablePass::RecordCallback > } );
+				} );
+			computePass.addOutputStorageView( resultv, 0u );
+			// The layout of the colour attachment depends on whether the copy pass is enabled or not.
+			bool enabled{ true };
+			auto & copyPass = graph.createPass( "Copy"
+				, [&enabled]( crg::FramePass const & pass
+					, crg::GraphContext & ctx
+					, crg::RunnableGraph & runGraph )
+				{
+					return std::make_unique< crg::RunnablePass >( pass, ctx, runGraph
+						, crg::RunnablePass::Callbacks{ crg::defaultV< crg::RunnablePass::InitialiseCallback >
+							, crg::RunnablePass::GetPipelineStateCallback( [](){ return crg::getPipelineState( VK_PIPELINE_STAGE_TRANSFER_BIT ); } )
+							, crg::defaultV< crg::RunnablePass::RecordCallback >
+							, crg::RunnablePass::GetPassIndexCallback( [](){ return 0u; } )
+							, crg::RunnablePass::IsEnabledCallback( [&enabled](){ return enabled; } ) } );
+				} );
+			copyPass.addDependency( computePass );
+			copyPass.addTransferOutputView( resultv );
+			auto & testPass = graph.createPass( "Pass"
+				, []( crg::FramePass const & pass
+					, crg::GraphContext & ctx
+					, crg::RunnableGraph & runGraph )
+				{
+					return crg::RenderQuadBuilder{}
+						.program( crg::VkPipelineShaderStageCreateInfoArray{ VkPipelineShaderStageCreateInfo{} } )
+						.build( pass, ctx, runGraph );
+				} );
+			testPass.addDependency( copyPass );
+			testPass.addInOutColourView( resultv );
+
+			auto runnable = graph.compile( context );
+			require( runnable )
+			runnable->setMaxVariants( 8u );
+			// Records the variants for each combination of enabled flags, for the current and previous run.
+			for ( auto value : { true, true, false, false, true } )
+			{
+				enabled = value;
+				checkNoThrow( runnable->run( VkQueue{} ) )
+			}
+			check( runnable->getVariantCount() == 5u )
+			// One render pass per attachment layout, none of them is destroyed while the variants using them are alive.
+			check( renderPasses.size() == 2u )
+			check( destroyed.empty() )
+			// One pipeline per render pass, switching back to a known render pass doesn't recreate it.
+			require( pipelineRenderPasses.size() == 2u )
+			check( pipelineRenderPasses[0] != pipelineRenderPasses[1] )
+
+			// The known combinations reuse their variants, nothing is recorded anymore.
+			auto recordedRenderPasses = beginRenderPasses;
+			for ( auto value : { true, false, false, true } )
+			{
+				enabled = value;
+				checkNoThrow( runnable->run( VkQueue{} ) )
+			}
+			check( runnable->getVariantCount() == 5u )
+			check( beginRenderPasses == recordedRenderPasses )
+			check( pipelineRenderPasses.size() == 2u )
+		}
+		testEnd()
+	}
+
+	void testMergedSubpasses( test::TestCounts & testCounts )
+	{
+		testBegin( "testMergedSubpasses" )
+		using CreateRenderPassHook = test::ContextHook< &crg::GraphContext::vkCreateRenderPass >;
+		using BeginRenderPassHook = test::ContextHook< &crg::GraphContext::vkCmdBeginRenderPass >;
+		using NextSubpassHook = test::ContextHook< &crg::GraphContext::vkCmdNextSubpass >;
+		using EndRenderPassHook = test::ContextHook< &crg::GraphContext::vkCmdEndRenderPass >;
+		uint32_t subpassCount{};
+		uint32_t inputAttachments{};
+		uint32_t subpassDependencies{};
+		uint32_t beginRenderPasses{};
+		uint32_t nextSubpasses{};
+		uint32_t endRenderPasses{};
+		auto & context = getContext();
+		CreateRenderPassHook createRenderPassHook{ context
+			, [&subpassCount, &inputAttachments, &subpassDependencies]( VkDevice device, const VkRenderPassCreateInfo * createInfo, const VkAllocationCallbacks * allocator, VkRenderPass * renderPass )
+			{
+				subpassCount = createInfo->subpassCount;
+				inputAttachments = 0u;
+				subpassDependencies = 0u;
+
+				for ( uint32_t i = 0u; i < createInfo->subpassCount; ++i )
+				{
+					inputAttachments += createInfo->pSubpasses[i].inputAttachmentCount;
+				}
+
+				for ( uint32_t i = 0u; i < createInfo->dependencyCount; ++i )
+				{
+					auto & dependency = createInfo->pDependencies[i];
+
+					if ( dependency.srcSubpass != VK_SUBPASS_EXTERNAL
+						&& dependency.dstSubpass != VK_SUBPASS_EXTERNAL )
+					{
+						++subpassDependencies;
+					}
+				}
+
+				return CreateRenderPassHook::next( device, createInfo, allocator, renderPass );
+			} };
+		BeginRenderPassHook beginRenderPassHook{ context
+			, [&beginRenderPasses]( VkCommandBuffer commandBuffer, const VkRenderPassBeginInfo * beginInfo, VkSubpassContents contents )
+			{
+				++beginRenderPasses;
+				BeginRenderPassHook::next( commandBuffer, beginInfo, contents );
+			} };
+		NextSubpassHook nextSubpassHook{ context
+			, [&nextSubpasses]( VkCommandBuffer commandBuffer, VkSubpassContents contents )
+			{
+				++nextSubpasses;
+				NextSubpassHook::next( commandBuffer, contents );
+			} };
+		EndRenderPassHook endRenderPassHook{ context
+			, [&endRenderPasses]( VkCommandBuffer commandBuffer )
+			{
+				++endRenderPasses;
+				EndRenderPassHook::next( commandBuffer );
+			} };
+		{
+			crg::ResourceHandler handler;
+			crg::FrameGraph graph{ handler, testCounts.testName };
+			auto rtData = test::createImage( "rt", VK_FORMAT_R16G16B16A16_SFLOAT );
+			rtData.info.usage |= VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+			auto rt = graph.createImage( rtData );
+			auto rtv = graph.createView( test::createView( "rtv", rt, VK_FORMAT_R16G16B16A16_SFLOAT, 0u, 1u, 0u, 1u ) );
+			auto result = graph.createImage( test::createImage( "result", VK_FORMAT_R16G16B16A16_SFLOAT ) );
+			auto resultv = graph.createView( test::createView( "resultv", result, VK_FORMAT_R16G16B16A16_SFLOAT, 0u, 1u, 0u, 1u ) );
+			bool enabled{ true };
+			auto & firstPass = graph.createPass( "First"
+				, []( crg::FramePass const & pass
+					, crg::GraphContext & ctx
+					, crg::RunnableGraph & runGraph )
+				{
+					return crg::RenderQuadBuilder{}
+						.program( crg::VkPipelineShaderStageCreateInfoArray{ VkPipelineShaderStageCreateInfo{} } )
+						.build( pass, ctx, runGraph );
+				} );
+			firstPass.addOutputColourView( rtv );
+			auto & secondPass = graph.createPass( "Second"
+				, [&enabled]( crg::FramePass const & pass
+					, crg::GraphContext & ctx
+					, crg::RunnableGraph & runGraph )
+				{
+					return crg::RenderQuadBuilder{}
+						.program( crg::VkPipelineShaderStageCreateInfoArray{ VkPipelineShaderStageCreateInfo{} } )
+						.enabled( &enabled )
+						.build( pass, ctx, runGraph );
+				} );
+			secondPass.addDependency( firstPass );
+			secondPass.addSamePixelSampledView( rtv, 0u );
+			secondPass.addOutputColourView( resultv );
+
+			auto runnable = graph.compile( context );
+			require( runnable )
+			require( runnable->getRenderPassChains().size() == 1u )
+			checkNoThrow( runnable->run( VkQueue{} ) )
+			// Both passes are recorded as the subpasses of a single render pass.
+			check( beginRenderPasses == 1u )
+			check( nextSubpasses == 1u )
+			check( endRenderPasses == 1u )
+			check( subpassCount == 2u )
+			check( inputAttachments == 1u )
+			check( subpassDependencies == 1u )
+
+			// The second pass being disabled, the first one is recorded in its own render pass.
+			enabled = false;
+			beginRenderPasses = 0u;
+			nextSubpasses = 0u;
+			endRenderPasses = 0u;
+			checkNoThrow( runnable->run( VkQueue{} ) )
+			check( beginRenderPasses == 1u )
+			check( nextSubpasses == 0u )
+			check( endRenderPasses == 1u )
+			check( subpassCount == 1u )
+
+			// Merged again once it is enabled.
+			enabled = true;
+			beginRenderPasses = 0u;
+			nextSubpasses = 0u;
+			endRenderPasses = 0u;
+			checkNoThrow( runnable->run( VkQueue{} ) )
+			check( beginRenderPasses == 1u )
+			check( nextSubpasses == 1u )
+			check( endRenderPasses == 1u )
+		}
+		testEnd()
+	}
+
+	void testPushConstantsData( test::TestCounts & testCounts )
+	{
+		testBegin( "testPushConstantsData" )
+		using PushConstantsHook = test::ContextHook< &crg::GraphContext::vkCmdPushConstants >;
+		std::vector< uint32_t > pushedValues;
+		auto & context = getContext();
+		PushConstantsHook pushConstantsHook{ context
+			, [&pushedValues]( VkCommandBuffer commandBuffer, VkPipelineLayout layout, VkShaderStageFlags stageFlags, uint32_t offset, uint32_t size, const void * pValues )
+			{
+				uint32_t value{};
+				std::memcpy( &value, pValues, sizeof( uint32_t ) );
+				pushedValues.push_back( value );
+				PushConstantsHook::next( commandBuffer, layout, stageFlags, offset, size, pValues );
+			} };
+		{
+			uint32_t frameData{ 1u };
+			crg::ResourceHandler handler;
+			crg::FrameGraph graph{ handler, testCounts.testName };
+			auto & testPass = graph.createPass( "Pass"
+				, [&frameData]( crg::FramePass const & pass
+					, crg::GraphContext & ctx
+					, crg::RunnableGraph & runGraph )
+				{
+					crg::cp::Config cfg;
+					cfg.baseConfig( crg::pp::Config{}
+						.programCreator( crg::ProgramCreator{ 1u
+							, []( uint32_t ){ return crg::VkPipelineShaderStageCreateInfoArray{ VkPipelineShaderStageCreateInfo{} }; } } )
+						.pushConstants( VkPushConstantRange{ VK_SHADER_STAGE_COMPUTE_BIT, 0u, sizeof( uint32_t ) } )
+						.pushConstantsData( &frameData ) );
+					return std::make_unique< crg::ComputePass >( pass, ctx, runGraph
+						, crg::ru::Config{}, std::move( cfg ) );
+				} );
+			testPass.addOutputStorageBuffer( crg::Buffer{ VkBuffer( 1 ), "buffer" }, 0u, 0u, 1024u );
+			testPass.setSideEffects();
+
+			auto runnable = graph.compile( context );
+			require( runnable )
+			runnable->setMaxVariants( 4u );
+			// The values are read at record time, so the pass is recorded at each run, with the current values.
+			checkNoThrow( runnable->run( VkQueue{} ) )
+			checkNoThrow( runnable->run( VkQueue{} ) )
+			check( pushedValues.size() == 2u )
+			check( pushedValues.back() == 1u )
+			auto variantCount = runnable->getVariantCount();
+			frameData = 2u;
+			checkNoThrow( runnable->run( VkQueue{} ) )
+			check( pushedValues.size() == 3u )
+			check( pushedValues.back() == 2u )
+			frameData = 3u;
+			checkNoThrow( runnable->run( VkQueue{} ) )
+			check( pushedValues.size() == 4u )
+			check( pushedValues.back() == 3u )
+			// The values are not part of the variants key.
+			check( runnable->getVariantCount() == variantCount )
+		}
+		testEnd()
+	}
+
+	void testFrameDataBuffer( test::TestCounts & testCounts )
+	{
+		testBegin( "testFrameDataBuffer" )
+		using DispatchHook = test::ContextHook< &crg::GraphContext::vkCmdDispatch >;
+		uint32_t dispatchCount{};
+		auto & context = getContext();
+		DispatchHook dispatchHook{ context
+			, [&dispatchCount]( VkCommandBuffer commandBuffer, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ )
+			{
+				++dispatchCount;
+				DispatchHook::next( commandBuffer, groupCountX, groupCountY, groupCountZ );
+			} };
+		{
+			uint32_t frameData{ 1u };
+			std::vector< uint32_t > writtenValues;
+			std::vector< VkDeviceSize > writtenSizes;
+			crg::ResourceHandler handler;
+			crg::FrameGraph graph{ handler, testCounts.testName };
+			auto buffer = graph.createFrameDataBuffer( "FrameData"
+				, sizeof( uint32_t )
+				, [&frameData, &writtenValues, &writtenSizes]( void * data, VkDeviceSize size )
+				{
+					std::memcpy( data, &frameData, sizeof( uint32_t ) );
+					writtenValues.push_back( frameData );
+					writtenSizes.push_back( size );
+				} );
+			auto & testPass = graph.createPass( "Pass"
+				, []( crg::FramePass const & pass
+					, crg::GraphContext & ctx
+					, crg::RunnableGraph & runGraph )
+				{
+					crg::cp::Config cfg;
+					cfg.baseConfig( crg::pp::Config{}
+						.programCreator( crg::ProgramCreator{ 1u
+							, []( uint32_t ){ return crg::VkPipelineShaderStageCreateInfoArray{ VkPipelineShaderStageCreateInfo{} }; } } ) );
+					return std::make_unique< crg::ComputePass >( pass, ctx, runGraph
+						, crg::ru::Config{}, std::move( cfg ) );
+				} );
+			testPass.addUniformBuffer( buffer, 0u, 0u, sizeof( uint32_t ) );
+			testPass.addOutputStorageBuffer( crg::Buffer{ VkBuffer( 1 ), "buffer" }, 1u, 0u, 1024u );
+			testPass.setSideEffects();
+
+			auto runnable = graph.compile( context );
+			require( runnable )
+			runnable->setMaxVariants( 4u );
+			// First run has no previous indices, the second one records the steady variant.
+			checkNoThrow( runnable->run( VkQueue{} ) )
+			checkNoThrow( runnable->run( VkQueue{} ) )
+			auto recorded = dispatchCount;
+			auto variantCount = runnable->getVariantCount();
+			// The provider writes the buffer at each run, the steady variant is reused.
+			for ( uint32_t value = 2u; value < 5u; ++value )
+			{
+				frameData = value;
+				checkNoThrow( runnable->run( VkQueue{} ) )
+				check( writtenValues.back() == value )
+			}
+
+			check( dispatchCount == recorded )
+			check( writtenValues.size() == 5u )
+			check( std::all_of( writtenSizes.begin()
+				, writtenSizes.end()
+				, []( VkDeviceSize size ){ return size == sizeof( uint32_t ); } ) )
+			check( runnable->getVariantCount() == variantCount )
+		}
+		testEnd()
+	}
+
+	void testUploadRing( test::TestCounts & testCounts )
+	{
+		testBegin( "testUploadRing" )
+		using CopyBufferHook = test::ContextHook< &crg::GraphContext::vkCmdCopyBuffer >;
+		std::vector< VkDeviceSize > srcOffsets;
+		auto & context = getContext();
+		CopyBufferHook copyBufferHook{ context
+			, [&srcOffsets]( VkCommandBuffer commandBuffer, VkBuffer srcBuffer, VkBuffer dstBuffer, uint32_t regionCount, const VkBufferCopy * pRegions )
+			{
+				srcOffsets.push_back( pRegions->srcOffset );
+				CopyBufferHook::next( commandBuffer, srcBuffer, dstBuffer, regionCount, pRegions );
+			} };
+		{
+			crg::UploadRing ring{ context, "Ring", 1024u, 2u };
+			check( ring.getFrameCount() == 2u )
+			check( ring.getBuffer().buffer() != VkBuffer{} )
+			crg::ResourceHandler handler;
+			crg::FrameGraph graph{ handler, testCounts.testName };
+			auto & testPass = graph.createPass( "Pass"
+				, [&ring]( crg::FramePass const & pass
+					, crg::GraphContext & ctx
+					, crg::RunnableGraph & runGraph )
+				{
+					return std::make_unique< crg::BufferCopy >( pass, ctx, runGraph
+						, ring, 0u, 1024u );
+				} );
+			testPass.addTransferOutputBuffer( crg::Buffer{ VkBuffer( 1 ), "outBuffer" }, 0u, 1024u );
+			auto runnable = graph.compile( context );
+			require( runnable )
+			std::vector< uint8_t > data( 2048u, uint8_t( 1 ) );
+
+			check( !ring.upload( testPass, data.data(), 2048u ) )
+			check( ring.upload( testPass, data.data(), 1024u ) )
+			// The frame segment is full.
+			check( !ring.upload( testPass, data.data(), 1u ) )
+			checkNoThrow( runnable->run( VkQueue{} ) )
+			check( srcOffsets.size() == 1u )
+			// No pending upload, no copy.
+			checkNoThrow( runnable->run( VkQueue{} ) )
+			check( srcOffsets.size() == 1u )
+			// Next frame uses the next segment.
+			check( ring.upload( testPass, data.data(), 1024u ) )
+			checkNoThrow( runnable->run( VkQueue{} ) )
+			check( srcOffsets.size() == 2u )
+			check( srcOffsets.back() == 1024u )
+			// First segment has been reclaimed.
+			check( ring.upload( testPass, data.data(), 1024u ) )
+			checkNoThrow( runnable->run( VkQueue{} ) )
+			check( srcOffsets.size() == 3u )
+			check( srcOffsets.back() == 0u )
+		}
+		testEnd()
+	}
+
+	void testUploadRingSegments( test::TestCounts & testCounts )
+	{
+		testBegin( "testUploadRingSegments" )
+		using CopyBufferToImageHook = test::ContextHook< &crg::GraphContext::vkCmdCopyBufferToImage >;
+		using WaitForFencesHook = test::ContextHook< &crg::GraphContext::vkWaitForFences >;
+		uint32_t imageCopies{};
+		std::vector< VkFence > waited;
+		auto & context = getContext();
+		CopyBufferToImageHook copyBufferToImageHook{ context
+			, [&imageCopies]( VkCommandBuffer commandBuffer, VkBuffer srcBuffer, VkImage dstImage, VkImageLayout dstImageLayout, uint32_t regionCount, const VkBufferImageCopy * pRegions )
+			{
+				++imageCopies;
+				CopyBufferToImageHook::next( commandBuffer, srcBuffer, dstImage, dstImageLayout, regionCount, pRegions );
+			} };
+		WaitForFencesHook waitForFencesHook{ context
+			, [&waited]( VkDevice device, uint32_t fenceCount, const VkFence * pFences, VkBool32 waitAll, uint64_t timeout )
+			{
+				waited.insert( waited.end(), pFences, pFences + fenceCount );
+				return WaitForFencesHook::next( device, fenceCount, pFences, waitAll, timeout );
+			} };
+		{
+			crg::UploadRing ring{ context, "Ring", 2048u, 2u };
+			crg::ResourceHandler handler;
+			crg::FrameGraph bufferGraph{ handler, testCounts.testName + "Buffer" };
+			auto & bufferPass = bufferGraph.createPass( "BufferPass"
+				, [&ring]( crg::FramePass const & pass
+					, crg::GraphContext & ctx
+					, crg::RunnableGraph & runGraph )
+				{
+					return std::make_unique< crg::BufferCopy >( pass, ctx, runGraph
+						, ring, 0u, 1024u );
+				} );
+			bufferPass.addTransferOutputBuffer( crg::Buffer{ VkBuffer( 1 ), "outBuffer" }, 0u, 1024u );
+			auto bufferRunnable = bufferGraph.compile( context );
+			require( bufferRunnable )
+
+			crg::FrameGraph imageGraph{ handler, testCounts.testName + "Image" };
+			auto result = imageGraph.createImage( test::createImage( "result", VK_FORMAT_R8G8B8A8_UNORM ) );
+			auto resultv = imageGraph.createView( test::createView( "resultv", result, VK_FORMAT_R8G8B8A8_UNORM ) );
+			auto & imagePass = imageGraph.createPass( "ImagePass"
+				, [&ring]( crg::FramePass const & pass
+					, crg::GraphContext & ctx
+					, crg::RunnableGraph & runGraph )
+				{
+					return std::make_unique< crg::BufferToImageCopy >( pass, ctx, runGraph
+						, ring, VkOffset3D{}, VkExtent3D{ 16u, 16u, 1u } );
+				} );
+			imagePass.addTransferOutputView( resultv );
+			auto imageRunnable = imageGraph.compile( context );
+			require( imageRunnable )
+			std::vector< uint8_t > data( 1024u, uint8_t( 1 ) );
+
+			// First segment is read by the buffer graph.
+			check( ring.upload( bufferPass, data.data(), 1024u ) )
+			checkNoThrow( bufferRunnable->run( VkQueue{} ) )
+			// Second segment is read by the image graph, which needs 16x16 RGBA8 texels.
+			check( ring.upload( imagePass, data.data(), 512u ) )
+			checkNoThrow( imageRunnable->run( VkQueue{} ) )
+			check( imageCopies == 0u )
+			// Reclaiming the first segment waits for the graph which read it.
+			waited.clear();
+			check( ring.upload( imagePass, data.data(), 1024u ) )
+			check( waited.end() != std::find( waited.begin(), waited.end(), VkFence( bufferRunnable->getFence() ) ) )
+			check( waited.end() == std::find( waited.begin(), waited.end(), VkFence( imageRunnable->getFence() ) ) )
+			checkNoThrow( imageRunnable->run( VkQueue{} ) )
+			check( imageCopies == 1u )
+		}
+		testEnd()
+	}
 }
 
 int main( int argc, char ** argv )
@@ -787,14 +2157,29 @@ int main( int argc, char ** argv )
 	testBufferCopy( testCounts );
 	testBufferToImageCopy( testCounts );
 	testGenerateMipmaps( testCounts );
+	testGenerateMipmapsBarriers( testCounts );
 	testImageBlit( testCounts );
 	testImageCopy( testCounts );
+	testBatchedCopies( testCounts );
 	testImageToBufferCopy( testCounts );
+	testImageReadback( testCounts );
+	testImageReadbackTooSmall( testCounts );
 	testComputePass( testCounts );
+	testComputePassDispatches( testCounts );
 	testComputePassTransitions( testCounts );
 	testRenderPass( testCounts );
 	testRenderQuad( testCounts );
 	testRenderMesh( testCounts );
+	testRenderMeshIndirectCount( testCounts );
 	testRenderTexturedMesh( testCounts );
+	testAsyncPipelineCompilation( testCounts );
+	testDynamicRendering( testCounts );
+	testCommandBufferVariants( testCounts );
+	testRenderPassVariants( testCounts );
+	testMergedSubpasses( testCounts );
+	testPushConstantsData( testCounts );
+	testFrameDataBuffer( testCounts );
+	testUploadRing( testCounts );
+	testUploadRingSegments( testCounts );
 	testSuiteEnd()
 }